@@ -0,0 +1,488 @@
+#pragma once
+#include <immintrin.h>
+
+#include "cbrt_poly_fix.hpp"  // fixed-point calculation of cubic root by polynomial
+#include "cbrt_tbl_fix.hpp"   //  fixed-point calculation of cubic root by LUT
+#include "simd_dispatch.hpp"
+#include "xyb_lut3d.hpp"
+
+// kernels of this header are compiled with AVX2 (or AVX-512) flags; keep every symbol local to
+// the including unit so that no out-of-line copy can be picked up by code built for older CPUs
+namespace {
+
+class mat_coeff_avx2 {
+ public:
+  const __m256i val;
+  const __m128i rshift;
+  explicit mat_coeff_avx2(ui32 v, ui32 rs) : val(_mm256_set1_epi32(v)), rshift(_mm_cvtsi32_si128(rs)) {}
+  inline __m256i mul(__m256i v) const { return _mm256_srl_epi32(_mm256_mullo_epi32(val, v), rshift); }
+};
+
+/**
+ * @brief Derive cubic root of 8 inputs (Q16 format of value 0.0 - 1.0), bit-exact with cbrt_lut()
+ *
+ * @param N inputs, shall be in the range of 0 - 65535
+ * @return cbrt(N)
+ */
+static inline __m256i cbrt_lut_avx2(__m256i N) {
+  const __m256i idx  = _mm256_srli_epi32(N, 8);  // Quantize pixel value to 8 bit (256 bins)
+  const __m256i frac = _mm256_and_si256(N, _mm256_set1_epi32(0xFF));
+  const __m256i pair = _mm256_i32gather_epi32((const int *)tbl_cbrt_pair.data(), idx, 2);
+  const __m256i val0 = _mm256_and_si256(pair, _mm256_set1_epi32(0xFFFF));
+  const __m256i val1 = _mm256_srli_epi32(pair, 16);
+  // linear interpolation; with frac = 0 this yields val0, for N = 65535 it yields 65535
+  __m256i tmp = _mm256_slli_epi32(val0, 8);
+  tmp         = _mm256_add_epi32(tmp, _mm256_mullo_epi32(_mm256_sub_epi32(val1, val0), frac));
+  tmp         = _mm256_add_epi32(tmp, _mm256_set1_epi32(1 << 7));  // rounding
+  return _mm256_srli_epi32(tmp, 8);
+}
+
+/**
+ * @brief Derive cubic root of 8 inputs (Q16 format of value 0.0 - 1.0) without table lookups, bit-exact
+ * with cbrt_poly()
+ *
+ * @param N inputs, shall be in the range of 0 - 65535
+ * @return cbrt(N)
+ */
+static inline __m256i cbrt_poly_avx2(__m256i N) {
+  const __m256i zero = _mm256_cmpeq_epi32(N, _mm256_setzero_si256());
+  const __m256i n    = _mm256_max_epi32(N, _mm256_set1_epi32(1));
+  // float(n) is exact: its exponent is floor(log2(n)) and its mantissa n << (23 - floor(log2(n)))
+  const __m256i bits = _mm256_castps_si256(_mm256_cvtepi32_ps(n));
+  const __m256i t    = _mm256_sub_epi32(_mm256_set1_epi32(127 + 15), _mm256_srli_epi32(bits, 23));
+  const __m256i q    = _mm256_srli_epi32(_mm256_madd_epi16(t, _mm256_set1_epi32(11)), 5);
+  const __m256i q3   = _mm256_madd_epi16(q, _mm256_set1_epi32(3));
+  const __m256i d    = _mm256_and_si256(_mm256_srli_epi32(bits, 8), _mm256_set1_epi32(0x7FFF));
+  const __m256i f    = _mm256_sllv_epi32(n, q3);
+  // root_scale[r] in the lower and step_scale[r] in the upper half of each lane
+  const __m256i scale_tbl = _mm256_setr_epi32(cbrt_poly_scale_pair(0), cbrt_poly_scale_pair(1),
+                                              cbrt_poly_scale_pair(2), 0, 0, 0, 0, 0);
+  const __m256i scales    = _mm256_permutevar8x32_epi32(scale_tbl, _mm256_sub_epi32(t, q3));
+  // 16-bit products of operands in the lower half of each lane keep the upper half zero
+  // seed of cbrt(f) in Q15
+  __m256i c = _mm256_mulhi_epu16(_mm256_set1_epi32(cbrt_poly_a2), d);
+  c         = _mm256_mulhi_epu16(_mm256_sub_epi32(_mm256_set1_epi32(cbrt_poly_a1), c), d);
+  c         = _mm256_add_epi32(_mm256_set1_epi32(cbrt_poly_a0), c);
+  c         = _mm256_mulhrs_epi16(c, _mm256_and_si256(scales, _mm256_set1_epi32(0xFFFF)));
+  // Newton step size 1/(3c^2) in Q13
+  __m256i k = _mm256_mulhi_epu16(_mm256_set1_epi32(cbrt_poly_k2), d);
+  k         = _mm256_mulhi_epu16(_mm256_sub_epi32(_mm256_set1_epi32(cbrt_poly_k1), k), d);
+  k         = _mm256_sub_epi32(_mm256_set1_epi32(cbrt_poly_k0), k);
+  k         = _mm256_mulhrs_epi16(k, _mm256_srli_epi32(scales, 16));
+  // c^3 in Q24 from the 64-bit products of the even and the odd lanes
+  const __m256i c2   = _mm256_madd_epi16(c, c);
+  const __m256i even = _mm256_srli_epi64(_mm256_mul_epu32(c2, c), 21);
+  const __m256i odd  = _mm256_mul_epu32(_mm256_srli_epi64(c2, 32), _mm256_srli_epi64(c, 32));
+  const __m256i cube = _mm256_blend_epi32(even, _mm256_slli_epi64(odd, 11), 0xAA);
+  const __m256i err  = _mm256_sub_epi32(_mm256_slli_epi32(f, 8), cube);
+  __m256i root       = _mm256_add_epi32(_mm256_mullo_epi32(err, k), _mm256_set1_epi32(1 << 12));
+  root               = _mm256_add_epi32(_mm256_slli_epi32(c, 9), _mm256_srai_epi32(root, 13));  // Q24
+  // root of N / 65535, then shifted right by q with rounding
+  const __m256i range = _mm256_mulhi_epu16(_mm256_srli_epi32(root, 8), _mm256_set1_epi32(cbrt_poly_range));
+  root                = _mm256_sub_epi32(root, _mm256_srli_epi32(range, 2));
+  root                = _mm256_add_epi32(root, _mm256_sllv_epi32(_mm256_set1_epi32(128), q));
+  root                = _mm256_srlv_epi32(root, _mm256_add_epi32(q, _mm256_set1_epi32(8)));
+  return _mm256_andnot_si256(zero, _mm256_min_epi32(root, _mm256_set1_epi32(65535)));
+}
+
+// load 8 samples as int32
+static inline __m256i load8_s32(const i32 *p) { return _mm256_loadu_si256((const __m256i *)p); }
+static inline __m256i load8_s32(const ui16 *p) {
+  return _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)p));
+}
+static inline __m256i load8_s32(const ui8 *p) {
+  return _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)p));
+}
+
+/**
+ * @brief Matrix stage of 8 pixels: L, M and S mixing values (before clamping) of Q16 RGB inputs
+ */
+static inline void rgb2mix_avx2(__m256i r, __m256i g, __m256i b, __m256i &Lmix, __m256i &Mmix,
+                                __m256i &Smix) {
+  // Set matrix coefficients
+  const mat_coeff_avx2 T00(4915U, 0);                // 0.3 << 14
+  const mat_coeff_avx2 T01(40763U, 2);               // 0.622 << 16
+  const mat_coeff_avx2 T02(5111U, 2);                // 0.078 << 16
+  const mat_coeff_avx2 T10(15073U, 2);               // 0.23 << 16
+  const mat_coeff_avx2 T11(22675U, 1);               // 0.692 << 15
+  const mat_coeff_avx2 T12(5111U, 2);                // 0.078 << 16
+  const mat_coeff_avx2 T20(3988U, 0);                // 0.24342268924547819 << 14
+  const mat_coeff_avx2 T21(13419U, 2);               // 0.20476744424496821 << 16
+  const mat_coeff_avx2 T22(36163U, 2);               // 0.55180986650955360 << 16
+  const __m256i bias = _mm256_set1_epi32(-4079616);  // / 2^30 = -0.003799438476562
+
+  Lmix = _mm256_add_epi32(_mm256_add_epi32(T00.mul(r), T01.mul(g)), T02.mul(b));
+  Mmix = _mm256_add_epi32(_mm256_add_epi32(T10.mul(r), T11.mul(g)), T12.mul(b));
+  Smix = _mm256_add_epi32(_mm256_add_epi32(T20.mul(r), T21.mul(g)), T22.mul(b));
+  Lmix = _mm256_srai_epi32(_mm256_sub_epi32(Lmix, bias), 14);
+  Mmix = _mm256_srai_epi32(_mm256_sub_epi32(Mmix, bias), 14);
+  Smix = _mm256_srai_epi32(_mm256_sub_epi32(Smix, bias), 14);
+}
+
+/**
+ * @brief Gamma and opsin stage of 8 pixels: store their XYB values derived from the mixing values
+ *
+ * @tparam cbrt cubic root of 8 Q16 inputs
+ * @param Lmix, Mmix, Smix mixing values, shall be in the range of 0 - 65535
+ */
+template <__m256i (*cbrt)(__m256i)>
+static inline void mix2xyb_avx2(__m256i Lmix, __m256i Mmix, __m256i Smix, i32 *X, i32 *Y, i32 *B) {
+  const __m256i bias_cbrt2  = _mm256_set1_epi32(-334921728);  // 2 * (-0.155960083007812 * 2^30)
+  const __m256i bias_cbrt16 = _mm256_set1_epi32(-10221);      // / 2^16 = -0.155960083007812
+
+  __m256i Lgamma = cbrt(Lmix);
+  __m256i Mgamma = cbrt(Mmix);
+  __m256i Sgamma = _mm256_add_epi32(cbrt(Smix), bias_cbrt16);
+
+  // X = (Lgamma - Mgamma) / 2;
+  __m256i vX = _mm256_srai_epi32(_mm256_sub_epi32(Lgamma, Mgamma), 1);
+  // Y = (Lgamma + Mgamma) / 2;
+  __m256i vY = _mm256_slli_epi32(_mm256_add_epi32(Lgamma, Mgamma), 14);
+  vY         = _mm256_srai_epi32(_mm256_add_epi32(vY, bias_cbrt2), 15);
+
+  _mm256_storeu_si256((__m256i *)X, vX);
+  _mm256_storeu_si256((__m256i *)Y, vY);
+  // B = Sgamma
+  _mm256_storeu_si256((__m256i *)B, Sgamma);
+}
+
+/**
+ * @brief floor((c0 r + c1 g + c2 b) / 256) of 16 samples (0 - 255) in 16-bit lanes, exact as mix_u8_sse41()
+ */
+static inline __m256i mix_u8_avx2(__m256i r, __m256i g, __m256i b, ui16 c0, ui16 c1, ui16 c2) {
+  const __m256i vc0 = _mm256_set1_epi16(static_cast<i16>(c0));
+  const __m256i vc1 = _mm256_set1_epi16(static_cast<i16>(c1));
+  const __m256i vc2 = _mm256_set1_epi16(static_cast<i16>(c2));
+  __m256i est       = _mm256_mulhi_epu16(_mm256_slli_epi16(r, 8), vc0);
+  est               = _mm256_add_epi16(est, _mm256_mulhi_epu16(_mm256_slli_epi16(g, 8), vc1));
+  est               = _mm256_add_epi16(est, _mm256_mulhi_epu16(_mm256_slli_epi16(b, 8), vc2));
+  __m256i low       = _mm256_mullo_epi16(r, vc0);
+  low               = _mm256_add_epi16(low, _mm256_mullo_epi16(g, vc1));
+  low               = _mm256_add_epi16(low, _mm256_mullo_epi16(b, vc2));
+  const __m256i fix = _mm256_sub_epi16(_mm256_srli_epi16(low, 8), est);
+  return _mm256_add_epi16(est, _mm256_and_si256(fix, _mm256_set1_epi16(0xFF)));
+}
+
+/**
+ * @brief rgb2xyb_avx2() of 8-bit (or shallower) samples: the matrix stage runs on 16 pixels in 16-bit lanes
+ * (derived in rgb2xyb_u8_sse41())
+ */
+template <__m256i (*cbrt)(__m256i)>
+void rgb2xyb_u8_avx2(const ui8 *buf_red, const ui8 *buf_grn, const ui8 *buf_blu, i32 *buf_X, i32 *buf_Y,
+                     i32 *buf_B, size_t length, i32 bpp, xyb_stats &stats) {
+  // the 16-bit statistics below cannot express the empty range of xyb_stats
+  if (length == 0) {
+    stats = xyb_stats_empty;
+    return;
+  }
+  const __m256i bias  = _mm256_set1_epi16(249);  // -(-4079616 >> 14)
+  const __m128i shift = _mm_cvtsi32_si128(8 - bpp);
+  __m256i Lmax        = _mm256_setzero_si256(), Lmin = _mm256_set1_epi16(-1);
+  __m256i Mmax        = _mm256_setzero_si256(), Mmin = _mm256_set1_epi16(-1);
+  __m256i Smax        = _mm256_setzero_si256(), Smin = _mm256_set1_epi16(-1);
+
+  // convert 16 pixels
+  auto convert = [&](const ui8 *red, const ui8 *grn, const ui8 *blu, i32 *X, i32 *Y, i32 *B) {
+    __m256i r = _mm256_sll_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)red)), shift);
+    __m256i g = _mm256_sll_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)grn)), shift);
+    __m256i b = _mm256_sll_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)blu)), shift);
+
+    __m256i Lmix = _mm256_add_epi16(mix_u8_avx2(r, g, b, 19660, 40763, 5111), bias);
+    __m256i Mmix = _mm256_add_epi16(mix_u8_avx2(r, g, b, 15073, 45350, 5111), bias);
+    __m256i Smix = _mm256_add_epi16(mix_u8_avx2(r, g, b, 15952, 13419, 36163), bias);
+
+    Lmax = _mm256_max_epu16(Lmax, Lmix);
+    Lmin = _mm256_min_epu16(Lmin, Lmix);
+    Mmax = _mm256_max_epu16(Mmax, Mmix);
+    Mmin = _mm256_min_epu16(Mmin, Mmix);
+    Smax = _mm256_max_epu16(Smax, Smix);
+    Smin = _mm256_min_epu16(Smin, Smix);
+
+    mix2xyb_avx2<cbrt>(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(Lmix)),
+                       _mm256_cvtepu16_epi32(_mm256_castsi256_si128(Mmix)),
+                       _mm256_cvtepu16_epi32(_mm256_castsi256_si128(Smix)), X, Y, B);
+    mix2xyb_avx2<cbrt>(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(Lmix, 1)),
+                       _mm256_cvtepu16_epi32(_mm256_extracti128_si256(Mmix, 1)),
+                       _mm256_cvtepu16_epi32(_mm256_extracti128_si256(Smix, 1)), X + 8, Y + 8, B + 8);
+  };
+
+  const size_t simdlen = length - length % 16;
+  for (size_t idx = 0; idx < simdlen; idx += 16) {
+    convert(buf_red + idx, buf_grn + idx, buf_blu + idx, buf_X + idx, buf_Y + idx, buf_B + idx);
+  }
+  // remaining pixels: pad with the last pixel so that the statistics are not affected
+  if (simdlen < length) {
+    alignas(32) ui8 in[3][16];
+    alignas(32) i32 out[3][16];
+    for (size_t i = 0; i < 16; ++i) {
+      const size_t idx = (simdlen + i < length) ? simdlen + i : length - 1;
+      in[0][i]         = buf_red[idx];
+      in[1][i]         = buf_grn[idx];
+      in[2][i]         = buf_blu[idx];
+    }
+    convert(in[0], in[1], in[2], out[0], out[1], out[2]);
+    for (size_t i = 0; i < length - simdlen; ++i) {
+      buf_X[simdlen + i] = out[0][i];
+      buf_Y[simdlen + i] = out[1][i];
+      buf_B[simdlen + i] = out[2][i];
+    }
+  }
+
+  // horizontal reduction of the statistics
+  alignas(32) ui16 stat[6][16];
+  _mm256_store_si256((__m256i *)stat[0], Lmax);
+  _mm256_store_si256((__m256i *)stat[1], Lmin);
+  _mm256_store_si256((__m256i *)stat[2], Mmax);
+  _mm256_store_si256((__m256i *)stat[3], Mmin);
+  _mm256_store_si256((__m256i *)stat[4], Smax);
+  _mm256_store_si256((__m256i *)stat[5], Smin);
+  stats.Lmax = stat[0][0];
+  stats.Lmin = stat[1][0];
+  stats.Mmax = stat[2][0];
+  stats.Mmin = stat[3][0];
+  stats.Smax = stat[4][0];
+  stats.Smin = stat[5][0];
+  for (size_t i = 1; i < 16; ++i) {
+    stats.Lmax = (stat[0][i] > stats.Lmax) ? stat[0][i] : stats.Lmax;
+    stats.Lmin = (stat[1][i] < stats.Lmin) ? stat[1][i] : stats.Lmin;
+    stats.Mmax = (stat[2][i] > stats.Mmax) ? stat[2][i] : stats.Mmax;
+    stats.Mmin = (stat[3][i] < stats.Mmin) ? stat[3][i] : stats.Mmin;
+    stats.Smax = (stat[4][i] > stats.Smax) ? stat[4][i] : stats.Smax;
+    stats.Smin = (stat[5][i] < stats.Smin) ? stat[5][i] : stats.Smin;
+  }
+}
+
+/**
+ * @brief Convert len pixels of bpp-bit RGB planes into XYB planes, bit-exact with rgb2xyb_scalar() using
+ * cbrt_lut256 (or cbrt_polynomial if cbrt is cbrt_poly_avx2); 8-bit samples take rgb2xyb_u8_avx2()
+ *
+ * @tparam T sample type of the RGB planes (ui8, ui16 or i32)
+ * @tparam cbrt cubic root of 8 Q16 inputs
+ * @param stats receives the range of the mixing values of these pixels
+ */
+template <class T, __m256i (*cbrt)(__m256i) = cbrt_lut_avx2>
+void rgb2xyb_avx2(const T *buf_red, const T *buf_grn, const T *buf_blu, i32 *buf_X, i32 *buf_Y, i32 *buf_B,
+                  size_t length, i32 bpp, xyb_stats &stats) {
+  if constexpr (sizeof(T) == 1) {
+    if (bpp <= 8) {
+      rgb2xyb_u8_avx2<cbrt>(buf_red, buf_grn, buf_blu, buf_X, buf_Y, buf_B, length, bpp, stats);
+      return;
+    }
+  }
+  const __m256i maxval = _mm256_set1_epi32(65535);
+
+  const __m128i shift = _mm_cvtsi32_si128(16 - bpp);
+  __m256i Lmax        = _mm256_set1_epi32(INT32_MIN), Lmin = _mm256_set1_epi32(INT32_MAX);
+  __m256i Mmax        = _mm256_set1_epi32(INT32_MIN), Mmin = _mm256_set1_epi32(INT32_MAX);
+  __m256i Smax        = _mm256_set1_epi32(INT32_MIN), Smin = _mm256_set1_epi32(INT32_MAX);
+
+  // convert 8 pixels
+  auto convert = [&](const T *red, const T *grn, const T *blu, i32 *X, i32 *Y, i32 *B) {
+    // RGB inputs are limited in 16bpp, ui16(0-65535)
+    __m256i r = _mm256_sll_epi32(load8_s32(red), shift);
+    __m256i g = _mm256_sll_epi32(load8_s32(grn), shift);
+    __m256i b = _mm256_sll_epi32(load8_s32(blu), shift);
+
+    __m256i Lmix, Mmix, Smix;
+    rgb2mix_avx2(r, g, b, Lmix, Mmix, Smix);
+
+    Lmax = _mm256_max_epi32(Lmax, Lmix);
+    Lmin = _mm256_min_epi32(Lmin, Lmix);
+    Mmax = _mm256_max_epi32(Mmax, Mmix);
+    Mmin = _mm256_min_epi32(Mmin, Mmix);
+    Smax = _mm256_max_epi32(Smax, Smix);
+    Smin = _mm256_min_epi32(Smin, Smix);
+
+    // Limit _mix values to prevent overflow
+    Lmix = _mm256_min_epi32(Lmix, maxval);
+    Mmix = _mm256_min_epi32(Mmix, maxval);
+    Smix = _mm256_min_epi32(Smix, maxval);
+
+    mix2xyb_avx2<cbrt>(Lmix, Mmix, Smix, X, Y, B);
+  };
+
+  const size_t simdlen = length - length % 8;
+  for (size_t idx = 0; idx < simdlen; idx += 8) {
+    convert(buf_red + idx, buf_grn + idx, buf_blu + idx, buf_X + idx, buf_Y + idx, buf_B + idx);
+  }
+  // remaining pixels: pad with the last pixel so that the statistics are not affected
+  if (simdlen < length) {
+    alignas(32) T in[3][8];
+    alignas(32) i32 out[3][8];
+    for (size_t i = 0; i < 8; ++i) {
+      const size_t idx = (simdlen + i < length) ? simdlen + i : length - 1;
+      in[0][i]         = buf_red[idx];
+      in[1][i]         = buf_grn[idx];
+      in[2][i]         = buf_blu[idx];
+    }
+    convert(in[0], in[1], in[2], out[0], out[1], out[2]);
+    for (size_t i = 0; i < length - simdlen; ++i) {
+      buf_X[simdlen + i] = out[0][i];
+      buf_Y[simdlen + i] = out[1][i];
+      buf_B[simdlen + i] = out[2][i];
+    }
+  }
+
+  // horizontal reduction of the statistics
+  alignas(32) i32 stat[6][8];
+  _mm256_store_si256((__m256i *)stat[0], Lmax);
+  _mm256_store_si256((__m256i *)stat[1], Lmin);
+  _mm256_store_si256((__m256i *)stat[2], Mmax);
+  _mm256_store_si256((__m256i *)stat[3], Mmin);
+  _mm256_store_si256((__m256i *)stat[4], Smax);
+  _mm256_store_si256((__m256i *)stat[5], Smin);
+  stats.Lmax = stat[0][0];
+  stats.Lmin = stat[1][0];
+  stats.Mmax = stat[2][0];
+  stats.Mmin = stat[3][0];
+  stats.Smax = stat[4][0];
+  stats.Smin = stat[5][0];
+  for (size_t i = 1; i < 8; ++i) {
+    stats.Lmax = (stat[0][i] > stats.Lmax) ? stat[0][i] : stats.Lmax;
+    stats.Lmin = (stat[1][i] < stats.Lmin) ? stat[1][i] : stats.Lmin;
+    stats.Mmax = (stat[2][i] > stats.Mmax) ? stat[2][i] : stats.Mmax;
+    stats.Mmin = (stat[3][i] < stats.Mmin) ? stat[3][i] : stats.Mmin;
+    stats.Smax = (stat[4][i] > stats.Smax) ? stat[4][i] : stats.Smax;
+    stats.Smin = (stat[5][i] < stats.Smin) ? stat[5][i] : stats.Smin;
+  }
+}
+
+/**
+ * @brief Convert len pixels of RGB planes into XYB planes with the lattice lut, bit-exact with
+ * rgb2xyb_lut3d_scalar()
+ *
+ * @tparam T sample type of the RGB planes (ui8, ui16 or i32)
+ * @param stats if not null, receives the range of the mixing values of these pixels
+ */
+template <class T>
+void rgb2xyb_lut3d_avx2(const xyb_lut3d &lut, const T *buf_red, const T *buf_grn, const T *buf_blu,
+                        i32 *buf_X, i32 *buf_Y, i32 *buf_B, size_t length, xyb_stats *stats) {
+  const int *axis_r   = reinterpret_cast<const int *>(lut.axis[0].data());
+  const int *axis_g   = reinterpret_cast<const int *>(lut.axis[1].data());
+  const int *axis_b   = reinterpret_cast<const int *>(lut.axis[2].data());
+  const int *node     = lut.nodes.data();
+  const __m256i level = _mm256_set1_epi32((1 << lut.bpp) - 1);
+  const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+  const __m256i sr    = _mm256_set1_epi32(1);
+  const __m256i sg    = _mm256_set1_epi32(lut.grid);
+  const __m256i sb    = _mm256_set1_epi32(lut.grid * lut.grid);
+  const __m256i diag  = _mm256_set1_epi32(1 + lut.grid + lut.grid * lut.grid);
+  const __m256i one   = _mm256_set1_epi32(1 << lut3d_frac_bits);
+  const __m256i half  = _mm256_set1_epi32(1 << (lut3d_frac_bits - 1));
+  const __m256i zero  = _mm256_setzero_si256();
+
+  const __m128i shift = _mm_cvtsi32_si128(16 - lut.bpp);
+  __m256i Lmax        = _mm256_set1_epi32(INT32_MIN), Lmin = _mm256_set1_epi32(INT32_MAX);
+  __m256i Mmax        = _mm256_set1_epi32(INT32_MIN), Mmin = _mm256_set1_epi32(INT32_MAX);
+  __m256i Smax        = _mm256_set1_epi32(INT32_MIN), Smin = _mm256_set1_epi32(INT32_MAX);
+
+  // convert 8 pixels
+  auto convert = [&](const T *red, const T *grn, const T *blu, i32 *X, i32 *Y, i32 *B) {
+    __m256i r = load8_s32(red);
+    __m256i g = load8_s32(grn);
+    __m256i b = load8_s32(blu);
+
+    if (stats != nullptr) {
+      __m256i Lmix, Mmix, Smix;
+      rgb2mix_avx2(_mm256_sll_epi32(r, shift), _mm256_sll_epi32(g, shift), _mm256_sll_epi32(b, shift), Lmix,
+                   Mmix, Smix);
+      Lmax = _mm256_max_epi32(Lmax, Lmix);
+      Lmin = _mm256_min_epi32(Lmin, Lmix);
+      Mmax = _mm256_max_epi32(Mmax, Mmix);
+      Mmin = _mm256_min_epi32(Mmin, Mmix);
+      Smax = _mm256_max_epi32(Smax, Smix);
+      Smin = _mm256_min_epi32(Smin, Smix);
+    }
+
+    const __m256i er   = _mm256_i32gather_epi32(axis_r, _mm256_min_epu32(r, level), 4);
+    const __m256i eg   = _mm256_i32gather_epi32(axis_g, _mm256_min_epu32(g, level), 4);
+    const __m256i eb   = _mm256_i32gather_epi32(axis_b, _mm256_min_epu32(b, level), 4);
+    __m256i base       = _mm256_add_epi32(_mm256_and_si256(er, low16), _mm256_and_si256(eg, low16));
+    base               = _mm256_add_epi32(base, _mm256_and_si256(eb, low16));
+    const __m256i fr   = _mm256_srli_epi32(er, 16);
+    const __m256i fg   = _mm256_srli_epi32(eg, 16);
+    const __m256i fb   = _mm256_srli_epi32(eb, 16);
+    // the tetrahedron of rgb2xyb_lut3d_scalar()
+    const __m256i g_r  = _mm256_cmpgt_epi32(fg, fr);  // !(fr >= fg)
+    const __m256i b_g  = _mm256_cmpgt_epi32(fb, fg);  // !(fg >= fb)
+    const __m256i b_r  = _mm256_cmpgt_epi32(fb, fr);  // !(fr >= fb)
+    __m256i smax       = _mm256_blendv_epi8(sb, sg, _mm256_andnot_si256(b_g, g_r));
+    smax               = _mm256_blendv_epi8(smax, sr, _mm256_cmpeq_epi32(_mm256_or_si256(g_r, b_r), zero));
+    __m256i smin       = _mm256_blendv_epi8(sr, sg, _mm256_andnot_si256(g_r, b_g));
+    smin               = _mm256_blendv_epi8(smin, sb, _mm256_cmpeq_epi32(_mm256_or_si256(b_r, b_g), zero));
+    const __m256i fmax = _mm256_max_epi32(fr, _mm256_max_epi32(fg, fb));
+    const __m256i fmin = _mm256_min_epi32(fr, _mm256_min_epi32(fg, fb));
+    const __m256i fsum = _mm256_add_epi32(_mm256_add_epi32(fr, fg), fb);
+    const __m256i fmid = _mm256_sub_epi32(_mm256_sub_epi32(fsum, fmax), fmin);
+    const __m256i w0   = _mm256_sub_epi32(one, fmax);
+    const __m256i w1   = _mm256_sub_epi32(fmax, fmid);
+    const __m256i w2   = _mm256_sub_epi32(fmid, fmin);
+    const __m256i w3   = fmin;
+    // 4 i32 per node
+    const __m256i i0 = _mm256_slli_epi32(base, 2);
+    const __m256i i1 = _mm256_slli_epi32(_mm256_add_epi32(base, smax), 2);
+    const __m256i i2 = _mm256_slli_epi32(_mm256_sub_epi32(_mm256_add_epi32(base, diag), smin), 2);
+    const __m256i i3 = _mm256_slli_epi32(_mm256_add_epi32(base, diag), 2);
+    auto interpolate = [&](const int *n) {
+      __m256i acc = _mm256_mullo_epi32(w0, _mm256_i32gather_epi32(n, i0, 4));
+      acc         = _mm256_add_epi32(acc, _mm256_mullo_epi32(w1, _mm256_i32gather_epi32(n, i1, 4)));
+      acc         = _mm256_add_epi32(acc, _mm256_mullo_epi32(w2, _mm256_i32gather_epi32(n, i2, 4)));
+      acc         = _mm256_add_epi32(acc, _mm256_mullo_epi32(w3, _mm256_i32gather_epi32(n, i3, 4)));
+      return _mm256_srai_epi32(_mm256_add_epi32(acc, half), lut3d_frac_bits);
+    };
+
+    _mm256_storeu_si256((__m256i *)X, interpolate(node));
+    _mm256_storeu_si256((__m256i *)Y, interpolate(node + 1));
+    _mm256_storeu_si256((__m256i *)B, interpolate(node + 2));
+  };
+
+  const size_t simdlen = length - length % 8;
+  for (size_t idx = 0; idx < simdlen; idx += 8) {
+    convert(buf_red + idx, buf_grn + idx, buf_blu + idx, buf_X + idx, buf_Y + idx, buf_B + idx);
+  }
+  // remaining pixels: pad with the last pixel so that the statistics are not affected
+  if (simdlen < length) {
+    alignas(32) T in[3][8];
+    alignas(32) i32 out[3][8];
+    for (size_t i = 0; i < 8; ++i) {
+      const size_t idx = (simdlen + i < length) ? simdlen + i : length - 1;
+      in[0][i]         = buf_red[idx];
+      in[1][i]         = buf_grn[idx];
+      in[2][i]         = buf_blu[idx];
+    }
+    convert(in[0], in[1], in[2], out[0], out[1], out[2]);
+    for (size_t i = 0; i < length - simdlen; ++i) {
+      buf_X[simdlen + i] = out[0][i];
+      buf_Y[simdlen + i] = out[1][i];
+      buf_B[simdlen + i] = out[2][i];
+    }
+  }
+  if (stats == nullptr) {
+    return;
+  }
+
+  // horizontal reduction of the statistics
+  alignas(32) i32 stat[6][8];
+  _mm256_store_si256((__m256i *)stat[0], Lmax);
+  _mm256_store_si256((__m256i *)stat[1], Lmin);
+  _mm256_store_si256((__m256i *)stat[2], Mmax);
+  _mm256_store_si256((__m256i *)stat[3], Mmin);
+  _mm256_store_si256((__m256i *)stat[4], Smax);
+  _mm256_store_si256((__m256i *)stat[5], Smin);
+  stats->Lmax = stat[0][0];
+  stats->Lmin = stat[1][0];
+  stats->Mmax = stat[2][0];
+  stats->Mmin = stat[3][0];
+  stats->Smax = stat[4][0];
+  stats->Smin = stat[5][0];
+  for (size_t i = 1; i < 8; ++i) {
+    stats->Lmax = (stat[0][i] > stats->Lmax) ? stat[0][i] : stats->Lmax;
+    stats->Lmin = (stat[1][i] < stats->Lmin) ? stat[1][i] : stats->Lmin;
+    stats->Mmax = (stat[2][i] > stats->Mmax) ? stat[2][i] : stats->Mmax;
+    stats->Mmin = (stat[3][i] < stats->Mmin) ? stat[3][i] : stats->Mmin;
+    stats->Smax = (stat[4][i] > stats->Smax) ? stat[4][i] : stats->Smax;
+    stats->Smin = (stat[5][i] < stats->Smin) ? stat[5][i] : stats->Smin;
+  }
+}
+
+}  // namespace
@@ -0,0 +1,404 @@
+#pragma once
+#include <immintrin.h>
+
+#include "cbrt_poly_fix.hpp"  // fixed-point calculation of cubic root by polynomial
+#include "cbrt_tbl_fix.hpp"   //  fixed-point calculation of cubic root by LUT
+#include "simd_dispatch.hpp"
+#include "xyb_lut3d.hpp"
+
+// compiled with AVX-512 flags; see RGB2XYB_avx2.hpp for why everything is local to the including unit
+namespace {
+
+class mat_coeff_avx512 {
+ public:
+  const __m512i val;
+  const __m128i rshift;
+  explicit mat_coeff_avx512(ui32 v, ui32 rs) : val(_mm512_set1_epi32(v)), rshift(_mm_cvtsi32_si128(rs)) {}
+  inline __m512i mul(__m512i v) const { return _mm512_srl_epi32(_mm512_mullo_epi32(val, v), rshift); }
+};
+
+/**
+ * @brief Derive cubic root of 16 inputs (Q16 format of value 0.0 - 1.0), bit-exact with cbrt_lut()
+ *
+ * @param N inputs, shall be in the range of 0 - 65535
+ * @return cbrt(N)
+ */
+static inline __m512i cbrt_lut_avx512(__m512i N) {
+  const __m512i idx  = _mm512_srli_epi32(N, 8);  // Quantize pixel value to 8 bit (256 bins)
+  const __m512i frac = _mm512_and_si512(N, _mm512_set1_epi32(0xFF));
+  const __m512i pair = _mm512_i32gather_epi32(idx, (const void *)tbl_cbrt_pair.data(), 2);
+  const __m512i val0 = _mm512_and_si512(pair, _mm512_set1_epi32(0xFFFF));
+  const __m512i val1 = _mm512_srli_epi32(pair, 16);
+  // linear interpolation; with frac = 0 this yields val0, for N = 65535 it yields 65535
+  __m512i tmp = _mm512_slli_epi32(val0, 8);
+  tmp         = _mm512_add_epi32(tmp, _mm512_mullo_epi32(_mm512_sub_epi32(val1, val0), frac));
+  tmp         = _mm512_add_epi32(tmp, _mm512_set1_epi32(1 << 7));  // rounding
+  return _mm512_srli_epi32(tmp, 8);
+}
+
+/**
+ * @brief Derive cubic root of 16 inputs (Q16 format of value 0.0 - 1.0) without table lookups, bit-exact
+ * with cbrt_poly()
+ *
+ * @param N inputs, shall be in the range of 0 - 65535
+ * @return cbrt(N)
+ */
+static inline __m512i cbrt_poly_avx512(__m512i N) {
+  const __mmask16 nonzero = _mm512_test_epi32_mask(N, N);
+  const __m512i n         = _mm512_max_epi32(N, _mm512_set1_epi32(1));
+  // float(n) is exact: its exponent is floor(log2(n)) and its mantissa n << (23 - floor(log2(n)))
+  const __m512i bits = _mm512_castps_si512(_mm512_cvtepi32_ps(n));
+  const __m512i t    = _mm512_sub_epi32(_mm512_set1_epi32(127 + 15), _mm512_srli_epi32(bits, 23));
+  const __m512i q    = _mm512_srli_epi32(_mm512_madd_epi16(t, _mm512_set1_epi32(11)), 5);
+  const __m512i q3   = _mm512_madd_epi16(q, _mm512_set1_epi32(3));
+  const __m512i d    = _mm512_and_si512(_mm512_srli_epi32(bits, 8), _mm512_set1_epi32(0x7FFF));
+  const __m512i f    = _mm512_sllv_epi32(n, q3);
+  // root_scale[r] in the lower and step_scale[r] in the upper half of each lane
+  const __m512i scale_tbl = _mm512_setr_epi32(cbrt_poly_scale_pair(0), cbrt_poly_scale_pair(1),
+                                              cbrt_poly_scale_pair(2), 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                                              0);
+  const __m512i scales    = _mm512_permutexvar_epi32(_mm512_sub_epi32(t, q3), scale_tbl);
+  // 16-bit products of operands in the lower half of each lane keep the upper half zero
+  // seed of cbrt(f) in Q15
+  __m512i c = _mm512_mulhi_epu16(_mm512_set1_epi32(cbrt_poly_a2), d);
+  c         = _mm512_mulhi_epu16(_mm512_sub_epi32(_mm512_set1_epi32(cbrt_poly_a1), c), d);
+  c         = _mm512_add_epi32(_mm512_set1_epi32(cbrt_poly_a0), c);
+  c         = _mm512_mulhrs_epi16(c, _mm512_and_si512(scales, _mm512_set1_epi32(0xFFFF)));
+  // Newton step size 1/(3c^2) in Q13
+  __m512i k = _mm512_mulhi_epu16(_mm512_set1_epi32(cbrt_poly_k2), d);
+  k         = _mm512_mulhi_epu16(_mm512_sub_epi32(_mm512_set1_epi32(cbrt_poly_k1), k), d);
+  k         = _mm512_sub_epi32(_mm512_set1_epi32(cbrt_poly_k0), k);
+  k         = _mm512_mulhrs_epi16(k, _mm512_srli_epi32(scales, 16));
+  // c^3 in Q24 from the 64-bit products of the even and the odd lanes
+  const __m512i c2   = _mm512_madd_epi16(c, c);
+  const __m512i even = _mm512_srli_epi64(_mm512_mul_epu32(c2, c), 21);
+  const __m512i odd  = _mm512_mul_epu32(_mm512_srli_epi64(c2, 32), _mm512_srli_epi64(c, 32));
+  const __m512i cube = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 11));
+  const __m512i err  = _mm512_sub_epi32(_mm512_slli_epi32(f, 8), cube);
+  __m512i root       = _mm512_add_epi32(_mm512_mullo_epi32(err, k), _mm512_set1_epi32(1 << 12));
+  root               = _mm512_add_epi32(_mm512_slli_epi32(c, 9), _mm512_srai_epi32(root, 13));  // Q24
+  // root of N / 65535, then shifted right by q with rounding
+  const __m512i range = _mm512_mulhi_epu16(_mm512_srli_epi32(root, 8), _mm512_set1_epi32(cbrt_poly_range));
+  root                = _mm512_sub_epi32(root, _mm512_srli_epi32(range, 2));
+  root                = _mm512_add_epi32(root, _mm512_sllv_epi32(_mm512_set1_epi32(128), q));
+  root                = _mm512_srlv_epi32(root, _mm512_add_epi32(q, _mm512_set1_epi32(8)));
+  return _mm512_maskz_min_epi32(nonzero, root, _mm512_set1_epi32(65535));
+}
+
+// load the samples of 16 pixels selected by m as int32, the others are zero
+static inline __m512i load16_s32(const i32 *p, __mmask16 m) { return _mm512_maskz_loadu_epi32(m, p); }
+static inline __m512i load16_s32(const ui16 *p, __mmask16 m) {
+  return _mm512_cvtepu16_epi32(_mm256_maskz_loadu_epi16(m, p));
+}
+static inline __m512i load16_s32(const ui8 *p, __mmask16 m) {
+  return _mm512_cvtepu8_epi32(_mm_maskz_loadu_epi8(m, p));
+}
+
+/**
+ * @brief Matrix stage of 16 pixels: L, M and S mixing values (before clamping) of Q16 RGB inputs
+ */
+static inline void rgb2mix_avx512(__m512i r, __m512i g, __m512i b, __m512i &Lmix, __m512i &Mmix,
+                                  __m512i &Smix) {
+  // Set matrix coefficients
+  const mat_coeff_avx512 T00(4915U, 0);              // 0.3 << 14
+  const mat_coeff_avx512 T01(40763U, 2);             // 0.622 << 16
+  const mat_coeff_avx512 T02(5111U, 2);              // 0.078 << 16
+  const mat_coeff_avx512 T10(15073U, 2);             // 0.23 << 16
+  const mat_coeff_avx512 T11(22675U, 1);             // 0.692 << 15
+  const mat_coeff_avx512 T12(5111U, 2);              // 0.078 << 16
+  const mat_coeff_avx512 T20(3988U, 0);              // 0.24342268924547819 << 14
+  const mat_coeff_avx512 T21(13419U, 2);             // 0.20476744424496821 << 16
+  const mat_coeff_avx512 T22(36163U, 2);             // 0.55180986650955360 << 16
+  const __m512i bias = _mm512_set1_epi32(-4079616);  // / 2^30 = -0.003799438476562
+
+  Lmix = _mm512_add_epi32(_mm512_add_epi32(T00.mul(r), T01.mul(g)), T02.mul(b));
+  Mmix = _mm512_add_epi32(_mm512_add_epi32(T10.mul(r), T11.mul(g)), T12.mul(b));
+  Smix = _mm512_add_epi32(_mm512_add_epi32(T20.mul(r), T21.mul(g)), T22.mul(b));
+  Lmix = _mm512_srai_epi32(_mm512_sub_epi32(Lmix, bias), 14);
+  Mmix = _mm512_srai_epi32(_mm512_sub_epi32(Mmix, bias), 14);
+  Smix = _mm512_srai_epi32(_mm512_sub_epi32(Smix, bias), 14);
+}
+
+/**
+ * @brief Gamma and opsin stage of 16 pixels: store the XYB values of those selected by m
+ *
+ * @tparam cbrt cubic root of 16 Q16 inputs
+ * @param Lmix, Mmix, Smix mixing values, shall be in the range of 0 - 65535
+ */
+template <__m512i (*cbrt)(__m512i)>
+static inline void mix2xyb_avx512(__m512i Lmix, __m512i Mmix, __m512i Smix, i32 *X, i32 *Y, i32 *B,
+                                  __mmask16 m) {
+  const __m512i bias_cbrt2  = _mm512_set1_epi32(-334921728);  // 2 * (-0.155960083007812 * 2^30)
+  const __m512i bias_cbrt16 = _mm512_set1_epi32(-10221);      // / 2^16 = -0.155960083007812
+
+  __m512i Lgamma = cbrt(Lmix);
+  __m512i Mgamma = cbrt(Mmix);
+  __m512i Sgamma = _mm512_add_epi32(cbrt(Smix), bias_cbrt16);
+
+  // X = (Lgamma - Mgamma) / 2;
+  __m512i vX = _mm512_srai_epi32(_mm512_sub_epi32(Lgamma, Mgamma), 1);
+  // Y = (Lgamma + Mgamma) / 2;
+  __m512i vY = _mm512_slli_epi32(_mm512_add_epi32(Lgamma, Mgamma), 14);
+  vY         = _mm512_srai_epi32(_mm512_add_epi32(vY, bias_cbrt2), 15);
+
+  _mm512_mask_storeu_epi32(X, m, vX);
+  _mm512_mask_storeu_epi32(Y, m, vY);
+  // B = Sgamma
+  _mm512_mask_storeu_epi32(B, m, Sgamma);
+}
+
+/**
+ * @brief floor((c0 r + c1 g + c2 b) / 256) of 32 samples (0 - 255) in 16-bit lanes, exact as mix_u8_sse41()
+ */
+static inline __m512i mix_u8_avx512(__m512i r, __m512i g, __m512i b, ui16 c0, ui16 c1, ui16 c2) {
+  const __m512i vc0 = _mm512_set1_epi16(static_cast<i16>(c0));
+  const __m512i vc1 = _mm512_set1_epi16(static_cast<i16>(c1));
+  const __m512i vc2 = _mm512_set1_epi16(static_cast<i16>(c2));
+  __m512i est       = _mm512_mulhi_epu16(_mm512_slli_epi16(r, 8), vc0);
+  est               = _mm512_add_epi16(est, _mm512_mulhi_epu16(_mm512_slli_epi16(g, 8), vc1));
+  est               = _mm512_add_epi16(est, _mm512_mulhi_epu16(_mm512_slli_epi16(b, 8), vc2));
+  __m512i low       = _mm512_mullo_epi16(r, vc0);
+  low               = _mm512_add_epi16(low, _mm512_mullo_epi16(g, vc1));
+  low               = _mm512_add_epi16(low, _mm512_mullo_epi16(b, vc2));
+  const __m512i fix = _mm512_sub_epi16(_mm512_srli_epi16(low, 8), est);
+  return _mm512_add_epi16(est, _mm512_and_si512(fix, _mm512_set1_epi16(0xFF)));
+}
+
+/**
+ * @brief rgb2xyb_avx512() of 8-bit (or shallower) samples: the matrix stage runs on 32 pixels in 16-bit
+ * lanes (derived in rgb2xyb_u8_sse41())
+ */
+template <__m512i (*cbrt)(__m512i)>
+void rgb2xyb_u8_avx512(const ui8 *buf_red, const ui8 *buf_grn, const ui8 *buf_blu, i32 *buf_X, i32 *buf_Y,
+                       i32 *buf_B, size_t length, i32 bpp, xyb_stats &stats) {
+  // the 16-bit statistics below cannot express the empty range of xyb_stats
+  if (length == 0) {
+    stats = xyb_stats_empty;
+    return;
+  }
+  const __m512i bias  = _mm512_set1_epi16(249);  // -(-4079616 >> 14)
+  const __m128i shift = _mm_cvtsi32_si128(8 - bpp);
+  __m512i Lmax        = _mm512_setzero_si512(), Lmin = _mm512_set1_epi16(-1);
+  __m512i Mmax        = _mm512_setzero_si512(), Mmin = _mm512_set1_epi16(-1);
+  __m512i Smax        = _mm512_setzero_si512(), Smin = _mm512_set1_epi16(-1);
+
+  // convert up to 32 pixels selected by m
+  auto convert = [&](size_t idx, __mmask32 m) {
+    __m512i r = _mm512_sll_epi16(_mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m, buf_red + idx)), shift);
+    __m512i g = _mm512_sll_epi16(_mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m, buf_grn + idx)), shift);
+    __m512i b = _mm512_sll_epi16(_mm512_cvtepu8_epi16(_mm256_maskz_loadu_epi8(m, buf_blu + idx)), shift);
+
+    __m512i Lmix = _mm512_add_epi16(mix_u8_avx512(r, g, b, 19660, 40763, 5111), bias);
+    __m512i Mmix = _mm512_add_epi16(mix_u8_avx512(r, g, b, 15073, 45350, 5111), bias);
+    __m512i Smix = _mm512_add_epi16(mix_u8_avx512(r, g, b, 15952, 13419, 36163), bias);
+
+    Lmax = _mm512_mask_max_epu16(Lmax, m, Lmax, Lmix);
+    Lmin = _mm512_mask_min_epu16(Lmin, m, Lmin, Lmix);
+    Mmax = _mm512_mask_max_epu16(Mmax, m, Mmax, Mmix);
+    Mmin = _mm512_mask_min_epu16(Mmin, m, Mmin, Mmix);
+    Smax = _mm512_mask_max_epu16(Smax, m, Smax, Smix);
+    Smin = _mm512_mask_min_epu16(Smin, m, Smin, Smix);
+
+    mix2xyb_avx512<cbrt>(_mm512_cvtepu16_epi32(_mm512_castsi512_si256(Lmix)),
+                         _mm512_cvtepu16_epi32(_mm512_castsi512_si256(Mmix)),
+                         _mm512_cvtepu16_epi32(_mm512_castsi512_si256(Smix)), buf_X + idx, buf_Y + idx,
+                         buf_B + idx, static_cast<__mmask16>(m));
+    if (m >> 16) {
+      mix2xyb_avx512<cbrt>(_mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(Lmix, 1)),
+                           _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(Mmix, 1)),
+                           _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(Smix, 1)), buf_X + idx + 16,
+                           buf_Y + idx + 16, buf_B + idx + 16, static_cast<__mmask16>(m >> 16));
+    }
+  };
+
+  const size_t simdlen = length - length % 32;
+  for (size_t idx = 0; idx < simdlen; idx += 32) {
+    convert(idx, 0xFFFFFFFFU);
+  }
+  if (simdlen < length) {
+    convert(simdlen, static_cast<__mmask32>((1ULL << (length - simdlen)) - 1));
+  }
+
+  // widen the 16-bit statistics for the reduction
+  auto lo    = [](__m512i v) { return _mm512_cvtepu16_epi32(_mm512_castsi512_si256(v)); };
+  auto hi    = [](__m512i v) { return _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(v, 1)); };
+  stats.Lmax = _mm512_reduce_max_epi32(_mm512_max_epi32(lo(Lmax), hi(Lmax)));
+  stats.Lmin = _mm512_reduce_min_epi32(_mm512_min_epi32(lo(Lmin), hi(Lmin)));
+  stats.Mmax = _mm512_reduce_max_epi32(_mm512_max_epi32(lo(Mmax), hi(Mmax)));
+  stats.Mmin = _mm512_reduce_min_epi32(_mm512_min_epi32(lo(Mmin), hi(Mmin)));
+  stats.Smax = _mm512_reduce_max_epi32(_mm512_max_epi32(lo(Smax), hi(Smax)));
+  stats.Smin = _mm512_reduce_min_epi32(_mm512_min_epi32(lo(Smin), hi(Smin)));
+}
+
+/**
+ * @brief Convert len pixels of bpp-bit RGB planes into XYB planes, bit-exact with rgb2xyb_scalar() using
+ * cbrt_lut256 (or cbrt_polynomial if cbrt is cbrt_poly_avx512); the last partial vector is handled with
+ * masked loads and stores; 8-bit samples take rgb2xyb_u8_avx512()
+ *
+ * @tparam T sample type of the RGB planes (ui8, ui16 or i32)
+ * @tparam cbrt cubic root of 16 Q16 inputs
+ * @param stats receives the range of the mixing values of these pixels
+ */
+template <class T, __m512i (*cbrt)(__m512i) = cbrt_lut_avx512>
+void rgb2xyb_avx512(const T *buf_red, const T *buf_grn, const T *buf_blu, i32 *buf_X, i32 *buf_Y,
+                    i32 *buf_B, size_t length, i32 bpp, xyb_stats &stats) {
+  if constexpr (sizeof(T) == 1) {
+    if (bpp <= 8) {
+      rgb2xyb_u8_avx512<cbrt>(buf_red, buf_grn, buf_blu, buf_X, buf_Y, buf_B, length, bpp, stats);
+      return;
+    }
+  }
+  const __m512i maxval = _mm512_set1_epi32(65535);
+
+  const __m128i shift = _mm_cvtsi32_si128(16 - bpp);
+  __m512i Lmax        = _mm512_set1_epi32(INT32_MIN), Lmin = _mm512_set1_epi32(INT32_MAX);
+  __m512i Mmax        = _mm512_set1_epi32(INT32_MIN), Mmin = _mm512_set1_epi32(INT32_MAX);
+  __m512i Smax        = _mm512_set1_epi32(INT32_MIN), Smin = _mm512_set1_epi32(INT32_MAX);
+
+  // convert up to 16 pixels selected by m
+  auto convert = [&](size_t idx, __mmask16 m) {
+    // RGB inputs are limited in 16bpp, ui16(0-65535)
+    __m512i r = _mm512_sll_epi32(load16_s32(buf_red + idx, m), shift);
+    __m512i g = _mm512_sll_epi32(load16_s32(buf_grn + idx, m), shift);
+    __m512i b = _mm512_sll_epi32(load16_s32(buf_blu + idx, m), shift);
+
+    __m512i Lmix, Mmix, Smix;
+    rgb2mix_avx512(r, g, b, Lmix, Mmix, Smix);
+
+    Lmax = _mm512_mask_max_epi32(Lmax, m, Lmax, Lmix);
+    Lmin = _mm512_mask_min_epi32(Lmin, m, Lmin, Lmix);
+    Mmax = _mm512_mask_max_epi32(Mmax, m, Mmax, Mmix);
+    Mmin = _mm512_mask_min_epi32(Mmin, m, Mmin, Mmix);
+    Smax = _mm512_mask_max_epi32(Smax, m, Smax, Smix);
+    Smin = _mm512_mask_min_epi32(Smin, m, Smin, Smix);
+
+    // Limit _mix values to prevent overflow
+    Lmix = _mm512_min_epi32(Lmix, maxval);
+    Mmix = _mm512_min_epi32(Mmix, maxval);
+    Smix = _mm512_min_epi32(Smix, maxval);
+
+    mix2xyb_avx512<cbrt>(Lmix, Mmix, Smix, buf_X + idx, buf_Y + idx, buf_B + idx, m);
+  };
+
+  const size_t simdlen = length - length % 16;
+  for (size_t idx = 0; idx < simdlen; idx += 16) {
+    convert(idx, 0xFFFF);
+  }
+  if (simdlen < length) {
+    convert(simdlen, static_cast<__mmask16>((1U << (length - simdlen)) - 1));
+  }
+
+  stats.Lmax = _mm512_reduce_max_epi32(Lmax);
+  stats.Lmin = _mm512_reduce_min_epi32(Lmin);
+  stats.Mmax = _mm512_reduce_max_epi32(Mmax);
+  stats.Mmin = _mm512_reduce_min_epi32(Mmin);
+  stats.Smax = _mm512_reduce_max_epi32(Smax);
+  stats.Smin = _mm512_reduce_min_epi32(Smin);
+}
+
+/**
+ * @brief Convert len pixels of RGB planes into XYB planes with the lattice lut, bit-exact with
+ * rgb2xyb_lut3d_scalar(); the last partial vector is handled with masked loads and stores
+ *
+ * @tparam T sample type of the RGB planes (ui8, ui16 or i32)
+ * @param stats if not null, receives the range of the mixing values of these pixels
+ */
+template <class T>
+void rgb2xyb_lut3d_avx512(const xyb_lut3d &lut, const T *buf_red, const T *buf_grn, const T *buf_blu,
+                          i32 *buf_X, i32 *buf_Y, i32 *buf_B, size_t length, xyb_stats *stats) {
+  const int *axis_r   = reinterpret_cast<const int *>(lut.axis[0].data());
+  const int *axis_g   = reinterpret_cast<const int *>(lut.axis[1].data());
+  const int *axis_b   = reinterpret_cast<const int *>(lut.axis[2].data());
+  const int *node     = lut.nodes.data();
+  const __m512i level = _mm512_set1_epi32((1 << lut.bpp) - 1);
+  const __m512i low16 = _mm512_set1_epi32(0xFFFF);
+  const __m512i sr    = _mm512_set1_epi32(1);
+  const __m512i sg    = _mm512_set1_epi32(lut.grid);
+  const __m512i sb    = _mm512_set1_epi32(lut.grid * lut.grid);
+  const __m512i diag  = _mm512_set1_epi32(1 + lut.grid + lut.grid * lut.grid);
+  const __m512i one   = _mm512_set1_epi32(1 << lut3d_frac_bits);
+  const __m512i half  = _mm512_set1_epi32(1 << (lut3d_frac_bits - 1));
+
+  const __m128i shift = _mm_cvtsi32_si128(16 - lut.bpp);
+  __m512i Lmax        = _mm512_set1_epi32(INT32_MIN), Lmin = _mm512_set1_epi32(INT32_MAX);
+  __m512i Mmax        = _mm512_set1_epi32(INT32_MIN), Mmin = _mm512_set1_epi32(INT32_MAX);
+  __m512i Smax        = _mm512_set1_epi32(INT32_MIN), Smin = _mm512_set1_epi32(INT32_MAX);
+
+  // convert up to 16 pixels selected by m
+  auto convert = [&](size_t idx, __mmask16 m) {
+    __m512i r = load16_s32(buf_red + idx, m);
+    __m512i g = load16_s32(buf_grn + idx, m);
+    __m512i b = load16_s32(buf_blu + idx, m);
+
+    if (stats != nullptr) {
+      __m512i Lmix, Mmix, Smix;
+      rgb2mix_avx512(_mm512_sll_epi32(r, shift), _mm512_sll_epi32(g, shift), _mm512_sll_epi32(b, shift),
+                     Lmix, Mmix, Smix);
+      Lmax = _mm512_mask_max_epi32(Lmax, m, Lmax, Lmix);
+      Lmin = _mm512_mask_min_epi32(Lmin, m, Lmin, Lmix);
+      Mmax = _mm512_mask_max_epi32(Mmax, m, Mmax, Mmix);
+      Mmin = _mm512_mask_min_epi32(Mmin, m, Mmin, Mmix);
+      Smax = _mm512_mask_max_epi32(Smax, m, Smax, Smix);
+      Smin = _mm512_mask_min_epi32(Smin, m, Smin, Smix);
+    }
+
+    // the lanes outside m hold zeros, a valid index
+    const __m512i er = _mm512_i32gather_epi32(_mm512_min_epu32(r, level), axis_r, 4);
+    const __m512i eg = _mm512_i32gather_epi32(_mm512_min_epu32(g, level), axis_g, 4);
+    const __m512i eb = _mm512_i32gather_epi32(_mm512_min_epu32(b, level), axis_b, 4);
+    __m512i base     = _mm512_add_epi32(_mm512_and_si512(er, low16), _mm512_and_si512(eg, low16));
+    base             = _mm512_add_epi32(base, _mm512_and_si512(eb, low16));
+    const __m512i fr = _mm512_srli_epi32(er, 16);
+    const __m512i fg = _mm512_srli_epi32(eg, 16);
+    const __m512i fb = _mm512_srli_epi32(eb, 16);
+    // the tetrahedron of rgb2xyb_lut3d_scalar()
+    const __mmask16 rg = _mm512_cmpge_epi32_mask(fr, fg);
+    const __mmask16 gb = _mm512_cmpge_epi32_mask(fg, fb);
+    const __mmask16 rb = _mm512_cmpge_epi32_mask(fr, fb);
+    const __m512i smax = _mm512_mask_blend_epi32(rg & rb, _mm512_mask_blend_epi32(~rg & gb, sb, sg), sr);
+    const __m512i smin = _mm512_mask_blend_epi32(rb & gb, _mm512_mask_blend_epi32(rg & ~gb, sr, sg), sb);
+    const __m512i fmax = _mm512_max_epi32(fr, _mm512_max_epi32(fg, fb));
+    const __m512i fmin = _mm512_min_epi32(fr, _mm512_min_epi32(fg, fb));
+    const __m512i fsum = _mm512_add_epi32(_mm512_add_epi32(fr, fg), fb);
+    const __m512i fmid = _mm512_sub_epi32(_mm512_sub_epi32(fsum, fmax), fmin);
+    const __m512i w0   = _mm512_sub_epi32(one, fmax);
+    const __m512i w1   = _mm512_sub_epi32(fmax, fmid);
+    const __m512i w2   = _mm512_sub_epi32(fmid, fmin);
+    const __m512i w3   = fmin;
+    // 4 i32 per node
+    const __m512i i0 = _mm512_slli_epi32(base, 2);
+    const __m512i i1 = _mm512_slli_epi32(_mm512_add_epi32(base, smax), 2);
+    const __m512i i2 = _mm512_slli_epi32(_mm512_sub_epi32(_mm512_add_epi32(base, diag), smin), 2);
+    const __m512i i3 = _mm512_slli_epi32(_mm512_add_epi32(base, diag), 2);
+    auto interpolate = [&](const int *n) {
+      __m512i acc = _mm512_mullo_epi32(w0, _mm512_i32gather_epi32(i0, n, 4));
+      acc         = _mm512_add_epi32(acc, _mm512_mullo_epi32(w1, _mm512_i32gather_epi32(i1, n, 4)));
+      acc         = _mm512_add_epi32(acc, _mm512_mullo_epi32(w2, _mm512_i32gather_epi32(i2, n, 4)));
+      acc         = _mm512_add_epi32(acc, _mm512_mullo_epi32(w3, _mm512_i32gather_epi32(i3, n, 4)));
+      return _mm512_srai_epi32(_mm512_add_epi32(acc, half), lut3d_frac_bits);
+    };
+
+    _mm512_mask_storeu_epi32(buf_X + idx, m, interpolate(node));
+    _mm512_mask_storeu_epi32(buf_Y + idx, m, interpolate(node + 1));
+    _mm512_mask_storeu_epi32(buf_B + idx, m, interpolate(node + 2));
+  };
+
+  const size_t simdlen = length - length % 16;
+  for (size_t idx = 0; idx < simdlen; idx += 16) {
+    convert(idx, 0xFFFF);
+  }
+  if (simdlen < length) {
+    convert(simdlen, static_cast<__mmask16>((1U << (length - simdlen)) - 1));
+  }
+
+  if (stats != nullptr) {
+    stats->Lmax = _mm512_reduce_max_epi32(Lmax);
+    stats->Lmin = _mm512_reduce_min_epi32(Lmin);
+    stats->Mmax = _mm512_reduce_max_epi32(Mmax);
+    stats->Mmin = _mm512_reduce_min_epi32(Mmin);
+    stats->Smax = _mm512_reduce_max_epi32(Smax);
+    stats->Smin = _mm512_reduce_min_epi32(Smin);
+  }
+}
+
+}  // namespace
@@ -0,0 +1,360 @@
+#pragma once
+#include <cstring>
+#include <smmintrin.h>
+
+#include "cbrt_poly_fix.hpp"  // fixed-point calculation of cubic root by polynomial
+#include "cbrt_tbl_fix.hpp"   //  fixed-point calculation of cubic root by LUT
+#include "simd_dispatch.hpp"
+
+// compiled with SSE4.1 flags; see RGB2XYB_avx2.hpp for why everything is local to the including unit
+namespace {
+
+class mat_coeff_sse41 {
+ public:
+  const __m128i val;
+  const __m128i rshift;
+  explicit mat_coeff_sse41(ui32 v, ui32 rs) : val(_mm_set1_epi32(v)), rshift(_mm_cvtsi32_si128(rs)) {}
+  inline __m128i mul(__m128i v) const { return _mm_srl_epi32(_mm_mullo_epi32(val, v), rshift); }
+};
+
+/**
+ * @brief Derive cubic root of 4 inputs (Q16 format of value 0.0 - 1.0), bit-exact with cbrt_lut()
+ *
+ * @param N inputs, shall be in the range of 0 - 65535
+ * @return cbrt(N)
+ */
+static inline __m128i cbrt_lut_sse41(__m128i N) {
+  // no gather before AVX2: fetch the table entry pairs lane by lane
+  const uint8_t *tbl = reinterpret_cast<const uint8_t *>(tbl_cbrt_pair.data());
+  alignas(16) ui32 pairs[4];
+  memcpy(&pairs[0], tbl + 2 * (_mm_extract_epi32(N, 0) >> 8), sizeof(ui32));
+  memcpy(&pairs[1], tbl + 2 * (_mm_extract_epi32(N, 1) >> 8), sizeof(ui32));
+  memcpy(&pairs[2], tbl + 2 * (_mm_extract_epi32(N, 2) >> 8), sizeof(ui32));
+  memcpy(&pairs[3], tbl + 2 * (_mm_extract_epi32(N, 3) >> 8), sizeof(ui32));
+  const __m128i pair = _mm_load_si128((const __m128i *)pairs);
+  const __m128i frac = _mm_and_si128(N, _mm_set1_epi32(0xFF));
+  const __m128i val0 = _mm_and_si128(pair, _mm_set1_epi32(0xFFFF));
+  const __m128i val1 = _mm_srli_epi32(pair, 16);
+  // linear interpolation; with frac = 0 this yields val0, for N = 65535 it yields 65535
+  __m128i tmp = _mm_slli_epi32(val0, 8);
+  tmp         = _mm_add_epi32(tmp, _mm_mullo_epi32(_mm_sub_epi32(val1, val0), frac));
+  tmp         = _mm_add_epi32(tmp, _mm_set1_epi32(1 << 7));  // rounding
+  return _mm_srli_epi32(tmp, 8);
+}
+
+// 2^e (0 <= e < 31) built as the exponent of a float; SSE4.1 has no per-lane shifts
+static inline __m128i pow2_sse41(__m128i e) {
+  return _mm_cvttps_epi32(_mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(e, _mm_set1_epi32(127)), 23)));
+}
+
+/**
+ * @brief Derive cubic root of 4 inputs (Q16 format of value 0.0 - 1.0) without table lookups, bit-exact
+ * with cbrt_poly()
+ *
+ * @param N inputs, shall be in the range of 0 - 65535
+ * @return cbrt(N)
+ */
+static inline __m128i cbrt_poly_sse41(__m128i N) {
+  const __m128i zero = _mm_cmpeq_epi32(N, _mm_setzero_si128());
+  const __m128i n    = _mm_max_epi32(N, _mm_set1_epi32(1));
+  // float(n) is exact: its exponent is floor(log2(n)) and its mantissa n << (23 - floor(log2(n)))
+  const __m128i bits = _mm_castps_si128(_mm_cvtepi32_ps(n));
+  const __m128i t    = _mm_sub_epi32(_mm_set1_epi32(127 + 15), _mm_srli_epi32(bits, 23));
+  const __m128i q    = _mm_srli_epi32(_mm_madd_epi16(t, _mm_set1_epi32(11)), 5);
+  const __m128i q3   = _mm_madd_epi16(q, _mm_set1_epi32(3));
+  const __m128i d    = _mm_and_si128(_mm_srli_epi32(bits, 8), _mm_set1_epi32(0x7FFF));
+  const __m128i f    = _mm_mullo_epi16(n, pow2_sse41(q3));  // < 2^16
+  // root_scale[r] in the lower and step_scale[r] in the upper half of each lane
+  const __m128i r      = _mm_sub_epi32(t, q3);
+  const __m128i scale0 = _mm_set1_epi32(cbrt_poly_scale_pair(0));
+  const __m128i scale1 = _mm_set1_epi32(cbrt_poly_scale_pair(1));
+  const __m128i scale2 = _mm_set1_epi32(cbrt_poly_scale_pair(2));
+  __m128i scales       = _mm_blendv_epi8(scale0, scale1, _mm_cmpeq_epi32(r, _mm_set1_epi32(1)));
+  scales               = _mm_blendv_epi8(scales, scale2, _mm_cmpeq_epi32(r, _mm_set1_epi32(2)));
+  // 16-bit products of operands in the lower half of each lane keep the upper half zero
+  // seed of cbrt(f) in Q15
+  __m128i c = _mm_mulhi_epu16(_mm_set1_epi32(cbrt_poly_a2), d);
+  c         = _mm_mulhi_epu16(_mm_sub_epi32(_mm_set1_epi32(cbrt_poly_a1), c), d);
+  c         = _mm_add_epi32(_mm_set1_epi32(cbrt_poly_a0), c);
+  c         = _mm_mulhrs_epi16(c, _mm_and_si128(scales, _mm_set1_epi32(0xFFFF)));
+  // Newton step size 1/(3c^2) in Q13
+  __m128i k = _mm_mulhi_epu16(_mm_set1_epi32(cbrt_poly_k2), d);
+  k         = _mm_mulhi_epu16(_mm_sub_epi32(_mm_set1_epi32(cbrt_poly_k1), k), d);
+  k         = _mm_sub_epi32(_mm_set1_epi32(cbrt_poly_k0), k);
+  k         = _mm_mulhrs_epi16(k, _mm_srli_epi32(scales, 16));
+  // c^3 in Q24 from the 64-bit products of the even and the odd lanes
+  const __m128i c2   = _mm_madd_epi16(c, c);
+  const __m128i even = _mm_srli_epi64(_mm_mul_epu32(c2, c), 21);
+  const __m128i odd  = _mm_mul_epu32(_mm_srli_epi64(c2, 32), _mm_srli_epi64(c, 32));
+  const __m128i cube = _mm_blend_epi16(even, _mm_slli_epi64(odd, 11), 0xCC);
+  const __m128i err  = _mm_sub_epi32(_mm_slli_epi32(f, 8), cube);
+  __m128i root       = _mm_add_epi32(_mm_mullo_epi32(err, k), _mm_set1_epi32(1 << 12));
+  root               = _mm_add_epi32(_mm_slli_epi32(c, 9), _mm_srai_epi32(root, 13));  // Q24
+  // root of N / 65535, then shifted right by q with rounding: (root * 2^(5 - q) + 2^12) >> 13
+  const __m128i range = _mm_mulhi_epu16(_mm_srli_epi32(root, 8), _mm_set1_epi32(cbrt_poly_range));
+  root                = _mm_sub_epi32(root, _mm_srli_epi32(range, 2));
+  root                = _mm_mullo_epi32(root, pow2_sse41(_mm_sub_epi32(_mm_set1_epi32(5), q)));
+  root                = _mm_srli_epi32(_mm_add_epi32(root, _mm_set1_epi32(1 << 12)), 13);
+  return _mm_andnot_si128(zero, _mm_min_epi32(root, _mm_set1_epi32(65535)));
+}
+
+// load 4 samples as int32
+static inline __m128i load4_s32(const i32 *p) { return _mm_loadu_si128((const __m128i *)p); }
+static inline __m128i load4_s32(const ui16 *p) {
+  return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)p));
+}
+static inline __m128i load4_s32(const ui8 *p) {
+  i32 v;
+  memcpy(&v, p, sizeof(v));
+  return _mm_cvtepu8_epi32(_mm_cvtsi32_si128(v));
+}
+
+/**
+ * @brief Gamma and opsin stage of 4 pixels: store their XYB values derived from the mixing values
+ *
+ * @tparam cbrt cubic root of 4 Q16 inputs
+ * @param Lmix, Mmix, Smix mixing values, shall be in the range of 0 - 65535
+ */
+template <__m128i (*cbrt)(__m128i)>
+static inline void mix2xyb_sse41(__m128i Lmix, __m128i Mmix, __m128i Smix, i32 *X, i32 *Y, i32 *B) {
+  const __m128i bias_cbrt2  = _mm_set1_epi32(-334921728);  // 2 * (-0.155960083007812 * 2^30)
+  const __m128i bias_cbrt16 = _mm_set1_epi32(-10221);      // / 2^16 = -0.155960083007812
+
+  __m128i Lgamma = cbrt(Lmix);
+  __m128i Mgamma = cbrt(Mmix);
+  __m128i Sgamma = _mm_add_epi32(cbrt(Smix), bias_cbrt16);
+
+  // X = (Lgamma - Mgamma) / 2;
+  __m128i vX = _mm_srai_epi32(_mm_sub_epi32(Lgamma, Mgamma), 1);
+  // Y = (Lgamma + Mgamma) / 2;
+  __m128i vY = _mm_slli_epi32(_mm_add_epi32(Lgamma, Mgamma), 14);
+  vY         = _mm_srai_epi32(_mm_add_epi32(vY, bias_cbrt2), 15);
+
+  _mm_storeu_si128((__m128i *)X, vX);
+  _mm_storeu_si128((__m128i *)Y, vY);
+  // B = Sgamma
+  _mm_storeu_si128((__m128i *)B, Sgamma);
+}
+
+/**
+ * @brief floor((c0 r + c1 g + c2 b) / 256) of 8 samples (0 - 255) in 16-bit lanes, exact
+ *
+ * The high halves of the products of (r << 8) etc. sum up to the result less 0 - 2; the wrapping sum of the
+ * low halves of the products of r etc. is the sum modulo 2^16 and thus settles the last 8 bits.
+ */
+static inline __m128i mix_u8_sse41(__m128i r, __m128i g, __m128i b, ui16 c0, ui16 c1, ui16 c2) {
+  const __m128i vc0 = _mm_set1_epi16(static_cast<i16>(c0));
+  const __m128i vc1 = _mm_set1_epi16(static_cast<i16>(c1));
+  const __m128i vc2 = _mm_set1_epi16(static_cast<i16>(c2));
+  __m128i est       = _mm_mulhi_epu16(_mm_slli_epi16(r, 8), vc0);
+  est               = _mm_add_epi16(est, _mm_mulhi_epu16(_mm_slli_epi16(g, 8), vc1));
+  est               = _mm_add_epi16(est, _mm_mulhi_epu16(_mm_slli_epi16(b, 8), vc2));
+  __m128i low       = _mm_mullo_epi16(r, vc0);
+  low               = _mm_add_epi16(low, _mm_mullo_epi16(g, vc1));
+  low               = _mm_add_epi16(low, _mm_mullo_epi16(b, vc2));
+  const __m128i fix = _mm_sub_epi16(_mm_srli_epi16(low, 8), est);
+  return _mm_add_epi16(est, _mm_and_si128(fix, _mm_set1_epi16(0xFF)));
+}
+
+/**
+ * @brief rgb2xyb_sse41() of 8-bit (or shallower) samples: the matrix stage runs on 8 pixels in 16-bit lanes
+ *
+ * With v' = v << (8 - bpp), the scaled input is v' << 8 and every product of the matrix stage is exact, so
+ * mix = floor((c0 r' + c1 g' + c2 b') / 256) + 249 where c = T.val << (2 - T.rshift) and 249 = -bias >> 14.
+ * Each set of coefficients sums up to 65534, so mix never exceeds 65527 and needs no clamp.
+ */
+template <__m128i (*cbrt)(__m128i)>
+void rgb2xyb_u8_sse41(const ui8 *buf_red, const ui8 *buf_grn, const ui8 *buf_blu, i32 *buf_X, i32 *buf_Y,
+                      i32 *buf_B, size_t length, i32 bpp, xyb_stats &stats) {
+  // the 16-bit statistics below cannot express the empty range of xyb_stats
+  if (length == 0) {
+    stats = xyb_stats_empty;
+    return;
+  }
+  const __m128i bias  = _mm_set1_epi16(249);  // -(-4079616 >> 14)
+  const __m128i shift = _mm_cvtsi32_si128(8 - bpp);
+  __m128i Lmax        = _mm_setzero_si128(), Lmin = _mm_set1_epi16(-1);
+  __m128i Mmax        = _mm_setzero_si128(), Mmin = _mm_set1_epi16(-1);
+  __m128i Smax        = _mm_setzero_si128(), Smin = _mm_set1_epi16(-1);
+
+  // convert 8 pixels
+  auto convert = [&](const ui8 *red, const ui8 *grn, const ui8 *blu, i32 *X, i32 *Y, i32 *B) {
+    __m128i r = _mm_sll_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)red)), shift);
+    __m128i g = _mm_sll_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)grn)), shift);
+    __m128i b = _mm_sll_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *)blu)), shift);
+
+    __m128i Lmix = _mm_add_epi16(mix_u8_sse41(r, g, b, 19660, 40763, 5111), bias);
+    __m128i Mmix = _mm_add_epi16(mix_u8_sse41(r, g, b, 15073, 45350, 5111), bias);
+    __m128i Smix = _mm_add_epi16(mix_u8_sse41(r, g, b, 15952, 13419, 36163), bias);
+
+    Lmax = _mm_max_epu16(Lmax, Lmix);
+    Lmin = _mm_min_epu16(Lmin, Lmix);
+    Mmax = _mm_max_epu16(Mmax, Mmix);
+    Mmin = _mm_min_epu16(Mmin, Mmix);
+    Smax = _mm_max_epu16(Smax, Smix);
+    Smin = _mm_min_epu16(Smin, Smix);
+
+    mix2xyb_sse41<cbrt>(_mm_cvtepu16_epi32(Lmix), _mm_cvtepu16_epi32(Mmix), _mm_cvtepu16_epi32(Smix), X,
+                        Y, B);
+    mix2xyb_sse41<cbrt>(_mm_cvtepu16_epi32(_mm_srli_si128(Lmix, 8)),
+                        _mm_cvtepu16_epi32(_mm_srli_si128(Mmix, 8)),
+                        _mm_cvtepu16_epi32(_mm_srli_si128(Smix, 8)), X + 4, Y + 4, B + 4);
+  };
+
+  const size_t simdlen = length - length % 8;
+  for (size_t idx = 0; idx < simdlen; idx += 8) {
+    convert(buf_red + idx, buf_grn + idx, buf_blu + idx, buf_X + idx, buf_Y + idx, buf_B + idx);
+  }
+  // remaining pixels: pad with the last pixel so that the statistics are not affected
+  if (simdlen < length) {
+    alignas(16) ui8 in[3][8];
+    alignas(16) i32 out[3][8];
+    for (size_t i = 0; i < 8; ++i) {
+      const size_t idx = (simdlen + i < length) ? simdlen + i : length - 1;
+      in[0][i]         = buf_red[idx];
+      in[1][i]         = buf_grn[idx];
+      in[2][i]         = buf_blu[idx];
+    }
+    convert(in[0], in[1], in[2], out[0], out[1], out[2]);
+    for (size_t i = 0; i < length - simdlen; ++i) {
+      buf_X[simdlen + i] = out[0][i];
+      buf_Y[simdlen + i] = out[1][i];
+      buf_B[simdlen + i] = out[2][i];
+    }
+  }
+
+  // horizontal reduction of the statistics
+  alignas(16) ui16 stat[6][8];
+  _mm_store_si128((__m128i *)stat[0], Lmax);
+  _mm_store_si128((__m128i *)stat[1], Lmin);
+  _mm_store_si128((__m128i *)stat[2], Mmax);
+  _mm_store_si128((__m128i *)stat[3], Mmin);
+  _mm_store_si128((__m128i *)stat[4], Smax);
+  _mm_store_si128((__m128i *)stat[5], Smin);
+  stats.Lmax = stat[0][0];
+  stats.Lmin = stat[1][0];
+  stats.Mmax = stat[2][0];
+  stats.Mmin = stat[3][0];
+  stats.Smax = stat[4][0];
+  stats.Smin = stat[5][0];
+  for (size_t i = 1; i < 8; ++i) {
+    stats.Lmax = (stat[0][i] > stats.Lmax) ? stat[0][i] : stats.Lmax;
+    stats.Lmin = (stat[1][i] < stats.Lmin) ? stat[1][i] : stats.Lmin;
+    stats.Mmax = (stat[2][i] > stats.Mmax) ? stat[2][i] : stats.Mmax;
+    stats.Mmin = (stat[3][i] < stats.Mmin) ? stat[3][i] : stats.Mmin;
+    stats.Smax = (stat[4][i] > stats.Smax) ? stat[4][i] : stats.Smax;
+    stats.Smin = (stat[5][i] < stats.Smin) ? stat[5][i] : stats.Smin;
+  }
+}
+
+/**
+ * @brief Convert len pixels of bpp-bit RGB planes into XYB planes, bit-exact with rgb2xyb_scalar() using
+ * cbrt_lut256 (or cbrt_polynomial if cbrt is cbrt_poly_sse41); 8-bit samples take rgb2xyb_u8_sse41()
+ *
+ * @tparam T sample type of the RGB planes (ui8, ui16 or i32)
+ * @tparam cbrt cubic root of 4 Q16 inputs
+ * @param stats receives the range of the mixing values of these pixels
+ */
+template <class T, __m128i (*cbrt)(__m128i) = cbrt_lut_sse41>
+void rgb2xyb_sse41(const T *buf_red, const T *buf_grn, const T *buf_blu, i32 *buf_X, i32 *buf_Y, i32 *buf_B,
+                   size_t length, i32 bpp, xyb_stats &stats) {
+  if constexpr (sizeof(T) == 1) {
+    if (bpp <= 8) {
+      rgb2xyb_u8_sse41<cbrt>(buf_red, buf_grn, buf_blu, buf_X, buf_Y, buf_B, length, bpp, stats);
+      return;
+    }
+  }
+  // Set matrix coefficients
+  const mat_coeff_sse41 T00(4915U, 0);              // 0.3 << 14
+  const mat_coeff_sse41 T01(40763U, 2);             // 0.622 << 16
+  const mat_coeff_sse41 T02(5111U, 2);              // 0.078 << 16
+  const mat_coeff_sse41 T10(15073U, 2);             // 0.23 << 16
+  const mat_coeff_sse41 T11(22675U, 1);             // 0.692 << 15
+  const mat_coeff_sse41 T12(5111U, 2);              // 0.078 << 16
+  const mat_coeff_sse41 T20(3988U, 0);              // 0.24342268924547819 << 14
+  const mat_coeff_sse41 T21(13419U, 2);             // 0.20476744424496821 << 16
+  const mat_coeff_sse41 T22(36163U, 2);             // 0.55180986650955360 << 16
+  const __m128i bias   = _mm_set1_epi32(-4079616);  // / 2^30 = -0.003799438476562
+  const __m128i maxval = _mm_set1_epi32(65535);
+
+  const __m128i shift = _mm_cvtsi32_si128(16 - bpp);
+  __m128i Lmax        = _mm_set1_epi32(INT32_MIN), Lmin = _mm_set1_epi32(INT32_MAX);
+  __m128i Mmax        = _mm_set1_epi32(INT32_MIN), Mmin = _mm_set1_epi32(INT32_MAX);
+  __m128i Smax        = _mm_set1_epi32(INT32_MIN), Smin = _mm_set1_epi32(INT32_MAX);
+
+  // convert 4 pixels
+  auto convert = [&](const T *red, const T *grn, const T *blu, i32 *X, i32 *Y, i32 *B) {
+    // RGB inputs are limited in 16bpp, ui16(0-65535)
+    __m128i r = _mm_sll_epi32(load4_s32(red), shift);
+    __m128i g = _mm_sll_epi32(load4_s32(grn), shift);
+    __m128i b = _mm_sll_epi32(load4_s32(blu), shift);
+
+    __m128i Lmix = _mm_add_epi32(_mm_add_epi32(T00.mul(r), T01.mul(g)), T02.mul(b));
+    __m128i Mmix = _mm_add_epi32(_mm_add_epi32(T10.mul(r), T11.mul(g)), T12.mul(b));
+    __m128i Smix = _mm_add_epi32(_mm_add_epi32(T20.mul(r), T21.mul(g)), T22.mul(b));
+    Lmix         = _mm_srai_epi32(_mm_sub_epi32(Lmix, bias), 14);
+    Mmix         = _mm_srai_epi32(_mm_sub_epi32(Mmix, bias), 14);
+    Smix         = _mm_srai_epi32(_mm_sub_epi32(Smix, bias), 14);
+
+    Lmax = _mm_max_epi32(Lmax, Lmix);
+    Lmin = _mm_min_epi32(Lmin, Lmix);
+    Mmax = _mm_max_epi32(Mmax, Mmix);
+    Mmin = _mm_min_epi32(Mmin, Mmix);
+    Smax = _mm_max_epi32(Smax, Smix);
+    Smin = _mm_min_epi32(Smin, Smix);
+
+    // Limit _mix values to prevent overflow
+    Lmix = _mm_min_epi32(Lmix, maxval);
+    Mmix = _mm_min_epi32(Mmix, maxval);
+    Smix = _mm_min_epi32(Smix, maxval);
+
+    mix2xyb_sse41<cbrt>(Lmix, Mmix, Smix, X, Y, B);
+  };
+
+  const size_t simdlen = length - length % 4;
+  for (size_t idx = 0; idx < simdlen; idx += 4) {
+    convert(buf_red + idx, buf_grn + idx, buf_blu + idx, buf_X + idx, buf_Y + idx, buf_B + idx);
+  }
+  // remaining pixels: pad with the last pixel so that the statistics are not affected
+  if (simdlen < length) {
+    alignas(16) T in[3][4];
+    alignas(16) i32 out[3][4];
+    for (size_t i = 0; i < 4; ++i) {
+      const size_t idx = (simdlen + i < length) ? simdlen + i : length - 1;
+      in[0][i]         = buf_red[idx];
+      in[1][i]         = buf_grn[idx];
+      in[2][i]         = buf_blu[idx];
+    }
+    convert(in[0], in[1], in[2], out[0], out[1], out[2]);
+    for (size_t i = 0; i < length - simdlen; ++i) {
+      buf_X[simdlen + i] = out[0][i];
+      buf_Y[simdlen + i] = out[1][i];
+      buf_B[simdlen + i] = out[2][i];
+    }
+  }
+
+  // horizontal reduction of the statistics
+  alignas(16) i32 stat[6][4];
+  _mm_store_si128((__m128i *)stat[0], Lmax);
+  _mm_store_si128((__m128i *)stat[1], Lmin);
+  _mm_store_si128((__m128i *)stat[2], Mmax);
+  _mm_store_si128((__m128i *)stat[3], Mmin);
+  _mm_store_si128((__m128i *)stat[4], Smax);
+  _mm_store_si128((__m128i *)stat[5], Smin);
+  stats.Lmax = stat[0][0];
+  stats.Lmin = stat[1][0];
+  stats.Mmax = stat[2][0];
+  stats.Mmin = stat[3][0];
+  stats.Smax = stat[4][0];
+  stats.Smin = stat[5][0];
+  for (size_t i = 1; i < 4; ++i) {
+    stats.Lmax = (stat[0][i] > stats.Lmax) ? stat[0][i] : stats.Lmax;
+    stats.Lmin = (stat[1][i] < stats.Lmin) ? stat[1][i] : stats.Lmin;
+    stats.Mmax = (stat[2][i] > stats.Mmax) ? stat[2][i] : stats.Mmax;
+    stats.Mmin = (stat[3][i] < stats.Mmin) ? stat[3][i] : stats.Mmin;
+    stats.Smax = (stat[4][i] > stats.Smax) ? stat[4][i] : stats.Smax;
+    stats.Smin = (stat[5][i] < stats.Smin) ? stat[5][i] : stats.Smin;
+  }
+}
+
+}  // namespace
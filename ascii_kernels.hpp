@@ -0,0 +1,260 @@
+#pragma once
+/********************************************************************************
+ * ASCII sample kernels (plain PGM/PPM rasters, P2/P3)
+ * parse white space separated decimal samples into the raster of the equivalent
+ * binary file (8-bit, or 16-bit big-endian samples); included by the
+ * kernels_*.cpp translation units after unpack_kernels.hpp. The kernels stop in
+ * front of anything but a run of 1 - 5 digits of value <= maxval followed by
+ * white space or the end of the input: comments, longer runs, malformed or
+ * out-of-range samples are left to the caller (pnm_raster() in pnm_io.cpp)
+ *******************************************************************************/
+#include <cstddef>
+#include <cstdint>
+
+#include "unpack_kernels.hpp"
+
+// SP, HT, LF, VT, FF and CR
+static inline bool is_ascii_white(uint8_t c) { return c == ' ' || (c >= 9 && c <= 13); }
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+/**
+ * @brief Lookup tables of the SIMD paths, indexed by a bit mask of 8 lanes of 16 bits
+ *
+ * pick[0] moves the low bytes of the selected lanes to the front (8-bit samples), pick[1] the selected
+ * lanes with their bytes swapped (16-bit big-endian samples); count is the number of selected lanes and
+ * last the index of the highest one (-1 if there is none).
+ */
+struct ascii_idx {
+  alignas(16) int8_t pick[2][256][16];
+  uint8_t count[256];
+  int8_t last[256];
+};
+static constexpr ascii_idx make_ascii_idx() {
+  ascii_idx t{};
+  for (int m = 0; m < 256; ++m) {
+    int n = 0;
+    t.last[m] = -1;
+    for (int i = 0; i < 16; ++i) {
+      t.pick[0][m][i] = t.pick[1][m][i] = -1;
+    }
+    for (int i = 0; i < 8; ++i) {
+      if (m & (1 << i)) {
+        t.pick[0][m][n]         = static_cast<int8_t>(2 * i);
+        t.pick[1][m][2 * n]     = static_cast<int8_t>(2 * i + 1);
+        t.pick[1][m][2 * n + 1] = static_cast<int8_t>(2 * i);
+        t.last[m]               = static_cast<int8_t>(i);
+        ++n;
+      }
+    }
+    t.count[m] = static_cast<uint8_t>(n);
+  }
+  return t;
+}
+static constexpr ascii_idx ascii_tbl = make_ascii_idx();
+
+// a > b in unsigned 16-bit lanes
+static inline __m128i cmpgt_epu16(__m128i a, __m128i b) {
+  return _mm_xor_si128(_mm_cmpeq_epi16(_mm_max_epu16(a, b), b), _mm_set1_epi8(-1));
+}
+
+  #if defined(__AVX2__)
+// 16 lanes of 16 bits moved up by K lanes, zeros shifted in
+template <int K>
+static inline __m256i lanes_up(__m256i v) {
+  return _mm256_alignr_epi8(v, _mm256_permute2x128_si256(v, v, 0x08), 16 - 2 * K);
+}
+
+static inline __m256i cmpgt_epu16(__m256i a, __m256i b) {
+  return _mm256_xor_si256(_mm256_cmpeq_epi16(_mm256_max_epu16(a, b), b), _mm256_set1_epi8(-1));
+}
+  #else
+// 16 lanes of 16 bits held in (lo, hi) moved up by K lanes, zeros shifted in
+template <int K>
+static inline void lanes_up(__m128i lo, __m128i hi, __m128i &ulo, __m128i &uhi) {
+  ulo = _mm_slli_si128(lo, 2 * K);
+  uhi = _mm_alignr_epi8(hi, lo, 16 - 2 * K);
+}
+  #endif
+
+/**
+ * @brief SIMD part of parse_ascii(): 16 bytes per step, each beginning at white space (or at the start of
+ * the input)
+ *
+ * The digits are widened to 16-bit lanes, where the value of the run of digits ending at each lane is
+ * accumulated in three steps (runs of 2, 4 and 5 digits; Five = false drops the last one, as 5 digits are
+ * out of range for maxval < 10000, and is the only variant of the SSE4.1 path); the lanes followed by white
+ * space hold a sample each and are compressed to the output. The step then advances to the last white space
+ * of the block, so that a run of digits at its end is parsed by the next step as a whole. The loop stops in
+ * front of a block holding anything else and leaves it to the scalar loop.
+ *
+ * @param n number of samples stored, updated
+ * @return number of bytes consumed
+ */
+template <int Bytes, bool Five>
+static size_t parse_ascii_simd(const uint8_t *src, size_t len, uint8_t *dst, size_t num, uint32_t maxval,
+                               size_t &n) {
+  const __m128i c0   = _mm_set1_epi8('0');
+  const __m128i c9   = _mm_set1_epi8(9);
+  const __m128i c4   = _mm_set1_epi8(4);
+  const __m128i sp   = _mm_set1_epi8(' ');
+  const __m128i keep = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0);
+  #if defined(__AVX2__)
+  const __m256i ten   = _mm256_set1_epi16(10);
+  const __m256i hundr = _mm256_set1_epi16(100);
+  const __m256i tenk  = _mm256_set1_epi16(10000);
+  const __m256i six   = _mm256_set1_epi16(6);
+  const __m256i vmax  = _mm256_set1_epi16(static_cast<int16_t>(maxval));
+  #else
+  const __m128i ten   = _mm_set1_epi16(10);
+  const __m128i hundr = _mm_set1_epi16(100);
+  const __m128i vmax  = _mm_set1_epi16(static_cast<int16_t>(maxval));
+  #endif
+  size_t pos = 0;
+  // at most 8 samples end in 16 bytes, each store writes 8
+  while (pos + 16 <= len && n + 16 <= num) {
+    const __m128i c   = _mm_loadu_si128((const __m128i *)(src + pos));
+    const __m128i d   = _mm_sub_epi8(c, c0);
+    const __m128i dig = _mm_cmpeq_epi8(_mm_min_epu8(d, c9), d);
+    const __m128i w   = _mm_sub_epi8(c, c9);  // HT - CR as 0 - 4
+    const __m128i sep = _mm_or_si128(_mm_cmpeq_epi8(c, sp), _mm_cmpeq_epi8(_mm_min_epu8(w, c4), w));
+    const int dm      = _mm_movemask_epi8(dig);
+    const int sm      = _mm_movemask_epi8(sep);
+    const int ls      = (sm >> 8) ? 8 + ascii_tbl.last[sm >> 8] : ascii_tbl.last[sm & 0xFF];
+    if ((dm | sm) != 0xFFFF || ls <= 0) {
+      break;  // other bytes, or a run of 15 or more digits
+    }
+    // samples end at digits followed by white space within the block
+    const __m128i end = _mm_and_si128(_mm_andnot_si128(_mm_srli_si128(dig, 1), dig), keep);
+
+    // t: value of the run of digits ending at each lane, m: digit, r2 / r4: run of at least 2 / 4 digits,
+    // d5: fifth digit, s: sample, e: lanes that cannot be stored
+    const __m128i dv = _mm_and_si128(d, dig);
+    __m128i sl, sh, el, eh;
+  #if defined(__AVX2__)
+    const __m256i m  = _mm256_cvtepi8_epi16(dig);
+    __m256i t        = _mm256_cvtepu8_epi16(dv);
+    const __m256i r2 = _mm256_and_si256(m, lanes_up<1>(m));
+    t = _mm256_add_epi16(t, _mm256_and_si256(_mm256_mullo_epi16(lanes_up<1>(t), ten), lanes_up<1>(m)));
+    t = _mm256_add_epi16(t, _mm256_and_si256(_mm256_mullo_epi16(lanes_up<2>(t), hundr),
+                                             _mm256_and_si256(r2, lanes_up<2>(m))));
+    const __m256i r4 = _mm256_and_si256(r2, lanes_up<2>(r2));
+    const __m256i d5 = _mm256_and_si256(r4, lanes_up<4>(m));
+    __m256i s = t, e = d5;
+    if constexpr (Five) {
+      // neither the product nor the sum may exceed 16 bits, a sixth digit is left to the caller
+      const __m256i u = lanes_up<4>(t);
+      s               = _mm256_add_epi16(t, _mm256_and_si256(_mm256_mullo_epi16(u, tenk), d5));
+      e = _mm256_or_si256(_mm256_and_si256(r4, lanes_up<4>(r2)), _mm256_cmpgt_epi16(u, six));
+      e = _mm256_or_si256(_mm256_and_si256(e, d5), cmpgt_epu16(t, s));
+    }
+    e  = _mm256_and_si256(_mm256_or_si256(e, cmpgt_epu16(s, vmax)), _mm256_cvtepi8_epi16(end));
+    sl = _mm256_castsi256_si128(s);
+    sh = _mm256_extracti128_si256(s, 1);
+    el = _mm256_castsi256_si128(e);
+    eh = _mm256_extracti128_si256(e, 1);
+  #else
+    __m128i tl = _mm_cvtepu8_epi16(dv), th = _mm_cvtepu8_epi16(_mm_srli_si128(dv, 8));
+    const __m128i ml = _mm_cvtepi8_epi16(dig), mh = _mm_cvtepi8_epi16(_mm_srli_si128(dig, 8));
+    __m128i ul, uh, vl, vh, xl, xh;
+    lanes_up<1>(tl, th, ul, uh);
+    lanes_up<1>(ml, mh, vl, vh);
+    tl                = _mm_add_epi16(tl, _mm_and_si128(_mm_mullo_epi16(ul, ten), vl));
+    th                = _mm_add_epi16(th, _mm_and_si128(_mm_mullo_epi16(uh, ten), vh));
+    const __m128i r2l = _mm_and_si128(ml, vl), r2h = _mm_and_si128(mh, vh);
+    lanes_up<2>(tl, th, ul, uh);
+    lanes_up<2>(ml, mh, vl, vh);
+    tl = _mm_add_epi16(tl, _mm_and_si128(_mm_mullo_epi16(ul, hundr), _mm_and_si128(r2l, vl)));
+    th = _mm_add_epi16(th, _mm_and_si128(_mm_mullo_epi16(uh, hundr), _mm_and_si128(r2h, vh)));
+    lanes_up<2>(r2l, r2h, xl, xh);
+    const __m128i r4l = _mm_and_si128(r2l, xl), r4h = _mm_and_si128(r2h, xh);
+    // a fifth digit is left to the scalar loop
+    static_assert(!Five, "the SSE4.1 path takes up to 4 digits");
+    lanes_up<4>(ml, mh, vl, vh);
+    sl = tl;
+    sh = th;
+    el = _mm_or_si128(_mm_and_si128(r4l, vl), cmpgt_epu16(tl, vmax));
+    eh = _mm_or_si128(_mm_and_si128(r4h, vh), cmpgt_epu16(th, vmax));
+    el = _mm_and_si128(el, _mm_cvtepi8_epi16(end));
+    eh = _mm_and_si128(eh, _mm_cvtepi8_epi16(_mm_srli_si128(end, 8)));
+  #endif
+    if (_mm_movemask_epi8(_mm_or_si128(el, eh))) {
+      break;
+    }
+    const int em     = _mm_movemask_epi8(end);
+    const int lo     = em & 0xFF;
+    const int hi     = em >> 8;
+    const __m128i pl = _mm_shuffle_epi8(sl, _mm_load_si128((const __m128i *)ascii_tbl.pick[Bytes - 1][lo]));
+    const __m128i ph = _mm_shuffle_epi8(sh, _mm_load_si128((const __m128i *)ascii_tbl.pick[Bytes - 1][hi]));
+    if constexpr (Bytes == 1) {
+      _mm_storel_epi64((__m128i *)(dst + n), pl);
+      n += ascii_tbl.count[lo];
+      _mm_storel_epi64((__m128i *)(dst + n), ph);
+    } else {
+      _mm_storeu_si128((__m128i *)(dst + 2 * n), pl);
+      n += ascii_tbl.count[lo];
+      _mm_storeu_si128((__m128i *)(dst + 2 * n), ph);
+    }
+    n += ascii_tbl.count[hi];
+    pos += static_cast<size_t>(ls);
+  }
+  return pos;
+}
+#endif
+
+/**
+ * @brief Parse up to num samples of src[0, len) into dst (Bytes = 1: 8-bit, 2: 16-bit big-endian)
+ *
+ * @param used receives the number of bytes consumed; src[used] is white space or the first byte of what the
+ * kernel leaves to the caller
+ * @return number of samples stored
+ */
+template <int Bytes>
+static size_t parse_ascii(const uint8_t *src, size_t len, uint8_t *dst, size_t num, uint32_t maxval,
+                          size_t &used) {
+  size_t pos = 0, n = 0;
+#if defined(__AVX2__)
+  pos = (maxval >= 10000) ? parse_ascii_simd<Bytes, true>(src, len, dst, num, maxval, n)
+                          : parse_ascii_simd<Bytes, false>(src, len, dst, num, maxval, n);
+#elif defined(__SSE4_1__)
+  // on two halves of 8 lanes the fifth digit costs more than the scalar loop takes for such samples
+  if (maxval < 10000) {
+    pos = parse_ascii_simd<Bytes, false>(src, len, dst, num, maxval, n);
+  }
+#endif
+  while (n < num) {
+    while (pos < len && is_ascii_white(src[pos])) {
+      ++pos;
+    }
+    const size_t start = pos;
+    uint32_t v         = 0;
+    while (pos < len && pos - start < 6 && src[pos] >= '0' && src[pos] <= '9') {
+      v = v * 10 + (src[pos] - '0');
+      ++pos;
+    }
+    if (pos == start || pos - start > 5 || v > maxval || (pos < len && !is_ascii_white(src[pos]))) {
+      pos = start;
+      break;
+    }
+    if constexpr (Bytes == 1) {
+      dst[n] = static_cast<uint8_t>(v);
+    } else {
+      dst[2 * n]     = static_cast<uint8_t>(v >> 8);
+      dst[2 * n + 1] = static_cast<uint8_t>(v);
+    }
+    ++n;
+  }
+  used = pos;
+  return n;
+}
+
+// plain samples into 8-bit samples
+static size_t parse_ascii_to_u8(const uint8_t *src, size_t len, uint8_t *dst, size_t num, uint32_t maxval,
+                                size_t &used) {
+  return parse_ascii<1>(src, len, dst, num, maxval, used);
+}
+
+// plain samples into 16-bit big-endian samples
+static size_t parse_ascii_to_big_u16(const uint8_t *src, size_t len, uint8_t *dst, size_t num,
+                                     uint32_t maxval, size_t &used) {
+  return parse_ascii<2>(src, len, dst, num, maxval, used);
+}
@@ -0,0 +1,487 @@
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include "async_loader.hpp"
+
+#if !defined(_MSC_VER)
+  #include <fcntl.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+  #define IMAGE_IO_IO_URING
+  #include <linux/io_uring.h>
+  #include <sys/mman.h>
+  #include <sys/syscall.h>
+#endif
+
+const char *async_backend_name(async_backend b) {
+  switch (b) {
+    case async_backend::AUTO:
+      return "auto";
+    case async_backend::IO_URING:
+      return "io_uring";
+    case async_backend::PREAD:
+      return "pread";
+  }
+  return "unknown";
+}
+
+// an image whose files are being read
+struct pending_image {
+  std::vector<std::string> filenames;
+  std::vector<file_view> views;  // views[i] holds filenames[i] once it is read
+  std::vector<int> status;       // EXIT_SUCCESS once filenames[i] is read
+  std::atomic<size_t> remaining;  // files not read yet
+  sample_storage storage;
+  std::promise<std::unique_ptr<image>> result;
+};
+
+/********************************************************************************
+ * backend reading the files of pending images
+ *******************************************************************************/
+class file_reader {
+ protected:
+  async_loader &loader;
+  plane_pool *pool;
+
+  void done(const std::shared_ptr<pending_image> &img) { loader.file_done(img); }
+
+ public:
+  file_reader(async_loader &loader, plane_pool *pool) : loader(loader), pool(pool) {}
+  virtual ~file_reader() = default;
+  // read file i of img into img->views[i], set img->status[i] and call done(img), possibly later
+  virtual void submit(const std::shared_ptr<pending_image> &img, size_t i) = 0;
+};
+
+// read a whole file into fv on the calling thread
+static int read_whole_file(const std::string &filename, plane_pool *pool, file_view &fv) {
+#if !defined(_MSC_VER)
+  instrument::stage_timer timer(instrument::stage::READ);
+  const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    printf("ERROR: File %s is not found.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  struct stat sb;
+  if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode)) {
+    const size_t size = static_cast<size_t>(sb.st_size);
+    auto data         = aligned_uptr<uint8_t>(64, size, pool);
+    size_t pos        = 0;
+    while (data != nullptr && pos < size) {
+      const ssize_t n = pread(fd, data.get() + pos, size - pos, static_cast<off_t>(pos));
+      if (n <= 0 && errno != EINTR) {
+        break;
+      }
+      pos += (n > 0) ? static_cast<size_t>(n) : 0;
+    }
+    close(fd);
+    if (pos < size || data == nullptr) {
+      printf("ERROR: File %s cannot be read.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+    fv.adopt(std::move(data), size);
+    timer.set_bytes(size);
+    return EXIT_SUCCESS;
+  }
+  close(fd);
+  timer.stop();
+#endif
+  // pipes and other files of unknown size
+  if (fv.open(filename, io_mode::STDIO, pool)) {
+    printf("ERROR: File %s is not found.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+/********************************************************************************
+ * pread() on a pool of I/O threads
+ *******************************************************************************/
+class pread_reader : public file_reader {
+ private:
+  thread_pool io;
+
+ public:
+  pread_reader(async_loader &loader, plane_pool *pool, unsigned num_threads)
+      : file_reader(loader, pool), io(num_threads) {}
+  void submit(const std::shared_ptr<pending_image> &img, size_t i) override {
+    io.enqueue([this, img, i] {
+      img->status[i] = read_whole_file(img->filenames[i], pool, img->views[i]);
+      done(img);
+    });
+  }
+};
+
+#if defined(IMAGE_IO_IO_URING)
+/********************************************************************************
+ * io_uring through the raw system calls (no liburing)
+ * a file is read in chunks of up to uring_chunk_bytes, submitted from the
+ * calling thread; a reaper thread handles completions, resubmits the rest of
+ * short reads and hands finished files back to the loader
+ *******************************************************************************/
+constexpr uint32_t uring_chunk_bytes = 1 << 20;
+
+class uring_reader : public file_reader {
+ private:
+  struct open_file {
+    std::shared_ptr<pending_image> img;
+    size_t index;
+    int fd;
+    unique_ptr_aligned<uint8_t> data;
+    size_t size;
+    size_t chunks_left;  // touched by the reaper only once every chunk is submitted
+    bool failed;
+    std::chrono::steady_clock::time_point start;
+  };
+  // the part of a file still to be read by one submission
+  struct chunk {
+    open_file *file;
+    uint64_t offset;
+    uint32_t len;
+  };
+
+  int ring_fd;
+  unsigned entries;
+  void *sq_ptr, *cq_ptr;
+  size_t sq_len, cq_len;
+  io_uring_sqe *sqes;
+  size_t sqes_len;
+  unsigned *sq_tail, *sq_mask, *sq_array;
+  unsigned *cq_head, *cq_tail, *cq_mask;
+  io_uring_cqe *cqes;
+
+  // guards the submission queue and in_flight
+  std::mutex mtx;
+  std::condition_variable space;
+  unsigned in_flight;  // submitted and not completed; at most entries, so the CQ cannot overflow
+  std::thread reaper;
+
+  static int setup(unsigned n, io_uring_params *p) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, n, p));
+  }
+  int enter(unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return static_cast<int>(
+        syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, 0));
+  }
+
+  // queue c, or a NOP stopping the reaper if c is null; mtx shall be held
+  void push(chunk *c) {
+    const unsigned tail = *sq_tail;
+    const unsigned idx  = tail & *sq_mask;
+    io_uring_sqe &sqe   = sqes[idx];
+    memset(&sqe, 0, sizeof(sqe));
+    if (c != nullptr) {
+      sqe.opcode = IORING_OP_READ;
+      sqe.fd     = c->file->fd;
+      sqe.off    = c->offset;
+      sqe.addr   = reinterpret_cast<uint64_t>(c->file->data.get() + c->offset);
+      sqe.len    = c->len;
+    } else {
+      sqe.opcode = IORING_OP_NOP;
+    }
+    sqe.user_data = reinterpret_cast<uint64_t>(c);
+    sq_array[idx] = idx;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    while (enter(1, 0, 0) < 0 && (errno == EINTR || errno == EAGAIN || errno == EBUSY)) {
+      std::this_thread::yield();
+    }
+  }
+
+  void finish(open_file *f) {
+    close(f->fd);
+    pending_image &img = *f->img;
+    if (f->failed) {
+      printf("ERROR: File %s cannot be read.\n", img.filenames[f->index].c_str());
+    } else {
+      const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - f->start);
+      instrument::add(instrument::stage::READ, static_cast<uint64_t>(ns.count()), f->size);
+      img.views[f->index].adopt(std::move(f->data), f->size);
+      img.status[f->index] = EXIT_SUCCESS;
+    }
+    std::shared_ptr<pending_image> p = std::move(f->img);
+    delete f;
+    done(p);
+  }
+
+  void complete(chunk *c, int res) {
+    open_file *f = c->file;
+    if (res == -EINTR || res == -EAGAIN || (res > 0 && static_cast<uint32_t>(res) < c->len)) {
+      // keep the slot of c for the rest of it
+      if (res > 0) {
+        c->offset += static_cast<uint32_t>(res);
+        c->len -= static_cast<uint32_t>(res);
+      }
+      std::lock_guard<std::mutex> lock(mtx);
+      push(c);
+      return;
+    }
+    // res == 0: the file shrank after fstat()
+    f->failed |= (res <= 0);
+    delete c;
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      in_flight--;
+    }
+    space.notify_one();
+    if (--f->chunks_left == 0) {
+      finish(f);
+    }
+  }
+
+  void reap() {
+    // the wait between polls of the completion queue while io_uring_enter() fails; the reads in flight
+    // still complete into the queue, only the blocking wait for them is lost
+    constexpr auto max_backoff = std::chrono::milliseconds(100);
+    std::chrono::microseconds backoff(0);
+    bool reported = false;
+    for (;;) {
+      unsigned head       = *cq_head;
+      const unsigned tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+      if (head == tail) {
+        if (enter(0, 1, IORING_ENTER_GETEVENTS) >= 0 || errno == EINTR) {
+          backoff = std::chrono::microseconds(0);
+          continue;
+        }
+        if (errno != EAGAIN && errno != EBUSY && !reported) {
+          printf("ERROR: io_uring_enter() failed: %s.\n", strerror(errno));
+          reported = true;
+        }
+        backoff = std::min<std::chrono::microseconds>(std::max(2 * backoff, std::chrono::microseconds(50)),
+                                                      max_backoff);
+        std::this_thread::sleep_for(backoff);
+        continue;
+      }
+      for (; head != tail; ++head) {
+        const io_uring_cqe &cqe = cqes[head & *cq_mask];
+        chunk *c                = reinterpret_cast<chunk *>(cqe.user_data);
+        const int res           = cqe.res;
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+        if (c == nullptr) {
+          return;
+        }
+        complete(c, res);
+      }
+    }
+  }
+
+ public:
+  uring_reader(async_loader &loader, plane_pool *pool)
+      : file_reader(loader, pool),
+        ring_fd(-1),
+        entries(0),
+        sq_ptr(MAP_FAILED),
+        cq_ptr(MAP_FAILED),
+        sq_len(0),
+        cq_len(0),
+        sqes(static_cast<io_uring_sqe *>(MAP_FAILED)),
+        sqes_len(0),
+        in_flight(0) {}
+
+  // error message, empty on success; the reason of errno is appended where a system call failed
+  std::string open(unsigned queue_depth) {
+    auto failed = [](const char *what) { return std::string(what) + ": " + strerror(errno); };
+    io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    ring_fd = setup(std::max(queue_depth, 1U), &p);
+    if (ring_fd < 0) {
+      return failed("io_uring_setup() failed");
+    }
+    // IORING_OP_READ needs Linux 5.6
+    std::vector<uint8_t> probe_mem(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+    auto *probe = reinterpret_cast<io_uring_probe *>(probe_mem.data());
+    if (syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_PROBE, probe, 256) < 0) {
+      return failed("IORING_REGISTER_PROBE failed");
+    }
+    if (probe->last_op < IORING_OP_READ || !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED)) {
+      return "IORING_OP_READ is not supported";
+    }
+    entries = p.sq_entries;
+    sq_len  = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_len  = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+      sq_len = cq_len = std::max(sq_len, cq_len);
+    }
+    sq_ptr = mmap(nullptr, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                  IORING_OFF_SQ_RING);
+    if (sq_ptr == MAP_FAILED) {
+      return failed("cannot map the io_uring submission queue");
+    }
+    if (p.features & IORING_FEAT_SINGLE_MMAP) {
+      cq_ptr = sq_ptr;
+    } else {
+      cq_ptr = mmap(nullptr, cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd,
+                    IORING_OFF_CQ_RING);
+      if (cq_ptr == MAP_FAILED) {
+        return failed("cannot map the io_uring completion queue");
+      }
+    }
+    sqes_len = p.sq_entries * sizeof(io_uring_sqe);
+    sqes     = static_cast<io_uring_sqe *>(mmap(nullptr, sqes_len, PROT_READ | PROT_WRITE,
+                                                MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED) {
+      return failed("cannot map the io_uring submission queue entries");
+    }
+    uint8_t *sq = static_cast<uint8_t *>(sq_ptr);
+    uint8_t *cq = static_cast<uint8_t *>(cq_ptr);
+    sq_tail     = reinterpret_cast<unsigned *>(sq + p.sq_off.tail);
+    sq_mask     = reinterpret_cast<unsigned *>(sq + p.sq_off.ring_mask);
+    sq_array    = reinterpret_cast<unsigned *>(sq + p.sq_off.array);
+    cq_head     = reinterpret_cast<unsigned *>(cq + p.cq_off.head);
+    cq_tail     = reinterpret_cast<unsigned *>(cq + p.cq_off.tail);
+    cq_mask     = reinterpret_cast<unsigned *>(cq + p.cq_off.ring_mask);
+    cqes        = reinterpret_cast<io_uring_cqe *>(cq + p.cq_off.cqes);
+    reaper      = std::thread([this] { reap(); });
+    return std::string();
+  }
+
+  ~uring_reader() override {
+    if (reaper.joinable()) {
+      {
+        std::unique_lock<std::mutex> lock(mtx);
+        space.wait(lock, [this] { return in_flight < entries; });
+        in_flight++;
+        push(nullptr);
+      }
+      reaper.join();
+    }
+    if (sqes != MAP_FAILED) {
+      munmap(sqes, sqes_len);
+    }
+    if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) {
+      munmap(cq_ptr, cq_len);
+    }
+    if (sq_ptr != MAP_FAILED) {
+      munmap(sq_ptr, sq_len);
+    }
+    if (ring_fd >= 0) {
+      close(ring_fd);
+    }
+  }
+
+  void submit(const std::shared_ptr<pending_image> &img, size_t i) override {
+    const std::string &filename = img->filenames[i];
+    const int fd                = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat sb;
+    if (fd < 0 || fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size == 0) {
+      // missing, empty or non-regular files take the synchronous path and its messages
+      if (fd >= 0) {
+        close(fd);
+      }
+      img->status[i] = read_whole_file(filename, pool, img->views[i]);
+      done(img);
+      return;
+    }
+    const size_t size       = static_cast<size_t>(sb.st_size);
+    const size_t num_chunks = (size + uring_chunk_bytes - 1) / uring_chunk_bytes;
+    auto data               = aligned_uptr<uint8_t>(64, size, pool);
+    if (data == nullptr) {
+      close(fd);
+      printf("ERROR: File %s cannot be read.\n", filename.c_str());
+      done(img);
+      return;
+    }
+    const auto start = std::chrono::steady_clock::now();
+    open_file *f     = new open_file{img, i, fd, std::move(data), size, num_chunks, false, start};
+    // f may be finished by the reaper as soon as its last chunk is queued
+    for (size_t k = 0; k < num_chunks; ++k) {
+      const uint64_t offset = static_cast<uint64_t>(k) * uring_chunk_bytes;
+      const uint64_t len    = std::min<uint64_t>(uring_chunk_bytes, size - offset);
+      chunk *c              = new chunk{f, offset, static_cast<uint32_t>(len)};
+      std::unique_lock<std::mutex> lock(mtx);
+      space.wait(lock, [this] { return in_flight < entries; });
+      in_flight++;
+      push(c);
+    }
+  }
+};
+#endif
+
+async_loader::async_loader(thread_pool &workers, plane_pool *pool, async_backend backend,
+                           unsigned queue_depth)
+    : workers(workers), pool(pool), backend(async_backend::PREAD), pending(0) {
+  if (backend != async_backend::PREAD) {
+#if defined(IMAGE_IO_IO_URING)
+    auto uring       = std::make_unique<uring_reader>(*this, pool);
+    const std::string fail = uring->open(queue_depth);
+    if (fail.empty()) {
+      reader        = std::move(uring);
+      this->backend = async_backend::IO_URING;
+    } else {
+      fallback = fail;
+    }
+#else
+    fallback = "io_uring is not available on this platform";
+#endif
+  } else {
+    fallback = "pread was requested";
+  }
+  if (reader == nullptr) {
+    reader = std::make_unique<pread_reader>(*this, pool, std::min(std::max(queue_depth, 1U), 8U));
+  }
+}
+
+async_loader::~async_loader() {
+  std::unique_lock<std::mutex> lock(mtx);
+  idle.wait(lock, [this] { return pending == 0; });
+}
+
+std::future<std::unique_ptr<image>> async_loader::load(const std::vector<std::string> &filenames,
+                                                        sample_storage storage) {
+  auto img       = std::make_shared<pending_image>();
+  img->filenames = filenames;
+  img->views.resize(filenames.size());
+  img->status.assign(filenames.size(), EXIT_FAILURE);
+  img->remaining = std::max<size_t>(filenames.size(), 1);
+  img->storage   = storage;
+  auto ret       = img->result.get_future();
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    pending++;
+  }
+  if (filenames.empty()) {
+    file_done(img);
+  }
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    reader->submit(img, i);
+  }
+  return ret;
+}
+
+void async_loader::file_done(const std::shared_ptr<pending_image> &img) {
+  if (img->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+    return;
+  }
+  workers.enqueue([this, img] { decode(*img); });
+}
+
+void async_loader::decode(pending_image &img) {
+  std::unique_ptr<image> out;
+  std::exception_ptr error;
+  try {
+    for (size_t i = 0; i < img.filenames.size(); ++i) {
+      if (img.status[i]) {
+        printf("ERROR: file %zu (%s) cannot be read.\n", i, img.filenames[i].c_str());
+        throw image_read_error(i, img.filenames[i]);
+      }
+    }
+    out = std::make_unique<image>(img.filenames, img.views, img.storage, pool);
+  } catch (...) {
+    error = std::current_exception();
+  }
+  // the file buffers go back to pool before the caller may release it
+  img.views.clear();
+  if (error) {
+    img.result.set_exception(error);
+  } else {
+    img.result.set_value(std::move(out));
+  }
+  std::lock_guard<std::mutex> lock(mtx);
+  pending--;
+  idle.notify_all();
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "image_io.hpp"
+#include "thread_pool.hpp"
+
+/********************************************************************************
+ * asynchronous loading of images
+ * the files of an image are read through io_uring on Linux, or with pread() on a
+ * few I/O threads where io_uring is unavailable (old kernels, seccomp filters of
+ * containers, other platforms); once every file of an image is in memory, the
+ * image is decoded on a thread pool, so the caller can keep converting image N
+ * while image N + 1 is loaded
+ *******************************************************************************/
+enum class async_backend { AUTO, IO_URING, PREAD };
+
+// name of b: auto, io_uring or pread
+const char *async_backend_name(async_backend b);
+
+struct pending_image;
+class file_reader;
+
+class async_loader {
+ private:
+  friend class file_reader;
+  thread_pool &workers;
+  plane_pool *pool;
+  std::unique_ptr<file_reader> reader;
+  async_backend backend;
+  std::string fallback;  // why io_uring is not used
+  // images submitted and not yet decoded, the destructor waits for zero
+  std::mutex mtx;
+  std::condition_variable idle;
+  size_t pending;
+
+  // called by the reader once a file of img is read or has failed
+  void file_done(const std::shared_ptr<pending_image> &img);
+  void decode(pending_image &img);
+
+ public:
+  /**
+   * @brief Open the backend; AUTO and IO_URING fall back to PREAD if io_uring cannot be used
+   *
+   * @param workers decodes the images; a future of load() shall not be waited for on a task of workers
+   * @param pool source of the file buffers and of the planes, shall outlive the loader and the images
+   * @param queue_depth reads in flight: io_uring queue entries, or I/O threads (up to 8) for pread
+   */
+  explicit async_loader(thread_pool &workers, plane_pool *pool = nullptr,
+                        async_backend backend = async_backend::AUTO, unsigned queue_depth = 64);
+  // waits for the images in flight
+  ~async_loader();
+  async_loader(const async_loader &)            = delete;
+  async_loader &operator=(const async_loader &) = delete;
+
+  // IO_URING or PREAD
+  async_backend get_backend() const { return backend; }
+  // why io_uring is not used, nullptr if it is
+  const char *fallback_reason() const {
+    return (backend == async_backend::PREAD) ? fallback.c_str() : nullptr;
+  }
+
+  /**
+   * @brief Start loading the image made of filenames (see image(filenames)) and return at once
+   *
+   * @return the decoded image; get() throws image_read_error, naming the lowest failing file
+   */
+  std::future<std::unique_ptr<image>> load(const std::vector<std::string> &filenames,
+                                           sample_storage storage = sample_storage::INT32);
+};
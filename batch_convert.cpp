@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#include "batch_convert.hpp"
+#include "spsc_queue.hpp"
+
+int collect_batch_inputs(const std::string &path, std::vector<batch_input> &inputs) {
+  std::error_code ec;
+  if (std::filesystem::is_directory(path, ec)) {
+    std::vector<std::string> names;
+    for (const auto &entry : std::filesystem::directory_iterator(path, ec)) {
+      const std::string ext = entry.path().extension().string();
+      if (entry.is_regular_file(ec) && (ext == ".ppm" || ext == ".PPM")) {
+        names.push_back(entry.path().string());
+      }
+    }
+    if (ec) {
+      printf("ERROR: cannot list %s.\n", path.c_str());
+      return EXIT_FAILURE;
+    }
+    std::sort(names.begin(), names.end());
+    for (auto &n : names) {
+      inputs.push_back({{n}});
+    }
+    return EXIT_SUCCESS;
+  }
+  std::ifstream list(path);
+  if (!list) {
+    printf("ERROR: File %s is not found.\n", path.c_str());
+    return EXIT_FAILURE;
+  }
+  std::string line;
+  while (std::getline(list, line)) {
+    std::istringstream words(line.substr(0, line.find('#')));
+    batch_input in;
+    std::string f;
+    while (words >> f) {
+      in.files.push_back(f);
+    }
+    if (!in.files.empty()) {
+      inputs.push_back(std::move(in));
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
+std::string batch_output_name(const batch_input &input, const batch_options &opt, uint16_t c) {
+  const std::filesystem::path first(input.files[0]);
+  const std::filesystem::path dir =
+      (opt.out_dir.empty()) ? first.parent_path() : std::filesystem::path(opt.out_dir);
+  char suffix[16];
+  snprintf(suffix, sizeof(suffix), "_xyb_%02d.pgx", c);
+  return (dir / (first.stem().string() + suffix)).string();
+}
+
+namespace {
+// an image travelling through the pipeline; a null pointer ends the stream, a null rgb marks a
+// failed read
+struct batch_item {
+  size_t index;
+  std::unique_ptr<image> rgb;
+  std::unique_ptr<image> xyb;
+};
+using item_ptr = std::unique_ptr<batch_item>;
+}  // namespace
+
+// rgb2xyb requires three unsigned components of one sample type, each of the image size or halved
+static bool convertible(const image &img) {
+  if (img.get_num_components() != 3) {
+    return false;
+  }
+  uint32_t sx, sy;
+  for (uint16_t c = 0; c < 3; ++c) {
+    if ((img.get_Ssiz_value(c) & 0x80) || !img.get_subsampling(c, sx, sy)
+        || img.get_sample_type(c) != img.get_sample_type(0)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// inputs of one stem (e.g. a/x.ppm and b/x.ppm with -o) would overwrite each other's output
+static bool distinct_outputs(const std::vector<batch_input> &inputs, const batch_options &opt) {
+  std::set<std::string> names;
+  for (const auto &in : inputs) {
+    const std::filesystem::path first = batch_output_name(in, opt, 0);
+    const std::string name            = first.lexically_normal().string();
+    if (!names.insert(name).second) {
+      printf("ERROR: more than one input of the batch is written to %s.\n", name.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+int batch_convert(const std::vector<batch_input> &inputs, const batch_options &opt, thread_pool &pool,
+                  batch_result *result) {
+  if (!distinct_outputs(inputs, opt)) {
+    return EXIT_FAILURE;
+  }
+  if (!opt.out_dir.empty()) {
+    std::error_code ec;
+    std::filesystem::create_directories(opt.out_dir, ec);
+    if (ec) {
+      printf("ERROR: cannot create %s.\n", opt.out_dir.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  // declared first, so that it outlives every plane of the batch
+  plane_pool own_pool;
+  plane_pool *planes = (opt.pool != nullptr) ? opt.pool : &own_pool;
+  spsc_queue<item_ptr> decoded(opt.queue_depth);
+  spsc_queue<item_ptr> converted(opt.queue_depth);
+  // written by the writer, read after it has been joined
+  size_t num_written = 0, num_pixels = 0;
+
+  std::unique_ptr<async_loader> loader;
+  if (opt.async_io) {
+    loader = std::make_unique<async_loader>(pool, planes);
+  }
+  // every exception is caught per item, so that the stages always pass on the end of the stream and
+  // the threads can be joined
+  auto read_stage = [&] {
+    // with async_io, the reads of the next queue_depth images are in flight
+    std::deque<std::future<std::unique_ptr<image>>> ahead;
+    size_t next = 0;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      item_ptr item;
+      try {
+        item        = std::make_unique<batch_item>();
+        item->index = i;
+        if (loader) {
+          for (; next < inputs.size() && next < i + std::max<size_t>(opt.queue_depth, 1); ++next) {
+            try {
+              ahead.push_back(loader->load(inputs[next].files, opt.storage));
+            } catch (...) {
+              // keeps ahead in step with the inputs; get() rethrows for this item
+              std::promise<std::unique_ptr<image>> failed;
+              failed.set_exception(std::current_exception());
+              ahead.push_back(failed.get_future());
+            }
+          }
+          std::future<std::unique_ptr<image>> f = std::move(ahead.front());
+          ahead.pop_front();
+          item->rgb = f.get();
+        } else {
+          item->rgb = std::make_unique<image>(inputs[i].files, io_mode::MMAP, opt.storage, planes, &pool);
+        }
+      } catch (const image_read_error &) {
+        // already reported; the converter skips an item without planes
+      } catch (const std::exception &e) {
+        printf("ERROR: cannot read %s: %s.\n", inputs[i].files[0].c_str(), e.what());
+      } catch (...) {
+        printf("ERROR: cannot read %s.\n", inputs[i].files[0].c_str());
+      }
+      if (item) {
+        decoded.push(std::move(item));
+      }
+    }
+    decoded.push(item_ptr());
+  };
+  auto write_stage = [&] {
+    for (item_ptr item = converted.pop(); item; item = converted.pop()) {
+      const image &xyb = *item->xyb;
+      uint16_t c       = 0;
+      try {
+        while (c < xyb.get_num_components()
+               && xyb.write_pgx(c, batch_output_name(inputs[item->index], opt, c)) == EXIT_SUCCESS) {
+          c++;
+        }
+      } catch (const std::exception &e) {
+        printf("ERROR: cannot write the XYB of %s: %s.\n", inputs[item->index].files[0].c_str(), e.what());
+      } catch (...) {
+        printf("ERROR: cannot write the XYB of %s.\n", inputs[item->index].files[0].c_str());
+      }
+      if (c == xyb.get_num_components()) {
+        num_written++;
+        num_pixels += static_cast<size_t>(xyb.get_width()) * xyb.get_height();
+      }
+    }
+  };
+  std::thread reader, writer;
+  try {
+    reader = std::thread(read_stage);
+    writer = std::thread(write_stage);
+  } catch (const std::system_error &e) {
+    printf("ERROR: cannot start the batch threads: %s.\n", e.what());
+    if (reader.joinable()) {
+      while (decoded.pop()) {
+      }
+      reader.join();
+    }
+    return EXIT_FAILURE;
+  }
+
+  // the calling thread converts, each image is spread over pool
+  for (item_ptr item = decoded.pop(); item; item = decoded.pop()) {
+    if (!item->rgb) {
+      continue;
+    }
+    image &rgb = *item->rgb;
+    if (!convertible(rgb)) {
+      printf("ERROR: %s cannot be converted to XYB.\n", inputs[item->index].files[0].c_str());
+      continue;
+    }
+    try {
+      item->xyb = std::make_unique<image>(rgb.get_width(), rgb.get_height(), opt.chroma, xyb_bpp, true,
+                                          sample_type::S32, planes);
+      rgb2xyb_parallel(rgb, *item->xyb, pool, nullptr, xyb_method(opt.cbrt, opt.lut3d_grid));
+    } catch (const std::exception &e) {
+      printf("ERROR: cannot convert %s: %s.\n", inputs[item->index].files[0].c_str(), e.what());
+      continue;
+    } catch (...) {
+      printf("ERROR: cannot convert %s.\n", inputs[item->index].files[0].c_str());
+      continue;
+    }
+    // the RGB planes are not needed while the item waits for the writer
+    item->rgb.reset();
+    converted.push(std::move(item));
+  }
+  converted.push(item_ptr());
+  reader.join();
+  writer.join();
+
+  if (result != nullptr) {
+    result->converted  = num_written;
+    result->failed     = inputs.size() - num_written;
+    result->pixels     = num_pixels;
+    result->pool_stats = planes->get_stats();
+    result->reader     = (loader) ? async_backend_name(loader->get_backend()) : "mmap";
+  }
+  return (num_written == inputs.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "async_loader.hpp"
+#include "image_io.hpp"
+#include "thread_pool.hpp"
+#include "xyb_convert.hpp"
+
+/********************************************************************************
+ * batch conversion of many independent images to XYB
+ * a reader, a converter and a writer thread are linked by bounded lock-free
+ * queues, so that reading and writing files overlaps the conversion; the
+ * converter distributes each image over the thread pool; the planes of finished
+ * images are recycled for the following ones through a plane_pool
+ *******************************************************************************/
+
+// one image of a batch: a PPM or several PGM/PGX files forming the RGB components
+struct batch_input {
+  std::vector<std::string> files;
+};
+
+struct batch_options {
+  std::string out_dir;                                   // empty: directory of each input
+  sample_storage storage    = sample_storage::NARROW;    // storage of the decoded RGB planes
+  size_t queue_depth        = 4;                         // images buffered between two stages
+  plane_pool *pool          = nullptr;                   // recycles the planes; null: a pool of the batch
+  bool async_io             = false;                     // read through async_loader instead of mmap
+  cbrt_method cbrt          = cbrt_method::LUT256;       // cube root of the XYB transfer function
+  i32 lut3d_grid            = 0;                         // 17 or 33: 3D LUT engine of 8 - 10 bpp inputs
+  chroma_subsampling chroma = chroma_subsampling::S444;  // layout of the X and B planes written
+};
+
+/**
+ * @brief Collect the inputs of a batch from a directory (every *.ppm file in it, sorted by name)
+ * or a list file (one image per line, whitespace-separated files of one image, '#' starts a comment)
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int collect_batch_inputs(const std::string &path, std::vector<batch_input> &inputs);
+
+/**
+ * @brief Output name of component c of input: <dir>/<stem>_xyb_<c>.pgx, where dir is opt.out_dir or
+ * the directory of the first file of input and stem is the name of that file without extension
+ */
+std::string batch_output_name(const batch_input &input, const batch_options &opt, uint16_t c);
+
+struct batch_result {
+  size_t converted = 0;
+  size_t failed    = 0;
+  size_t pixels    = 0;  // pixels of the converted images
+  plane_pool_stats pool_stats;
+  const char *reader = "mmap";  // how the files were read: mmap, io_uring or pread
+};
+
+/**
+ * @brief Convert every input to XYB and write its components with batch_output_name()
+ *
+ * An image that cannot be read, converted or written is reported and skipped. Nothing is converted if
+ * two inputs share an output name (e.g. a/x.ppm and b/x.ppm with an out_dir).
+ *
+ * @param result if not null, receives the number of converted and failed images
+ * @return EXIT_SUCCESS if every image was converted, otherwise EXIT_FAILURE
+ */
+int batch_convert(const std::vector<batch_input> &inputs, const batch_options &opt, thread_pool &pool,
+                  batch_result *result = nullptr);
@@ -9,9 +9,9 @@
 
 constexpr ui32 MAXVAL = 65535U;
 
-static ui64 _u64d_div__(ui64 b, ui64 c) { return b / c; }
+inline ui64 _u64d_div__(ui64 b, ui64 c) { return b / c; }
 
-static ui16 div64(ui32 a, ui32 b) {
+inline ui16 div64(ui32 a, ui32 b) {
   ui64 ret;
   if (b == 0U) {
     ret = UINT64_MAX;
@@ -39,7 +39,7 @@ T cbrt_fix(T N) {
  * @return cubic root of N
  */
 template <>
-ui16 cbrt_fix<ui16>(ui16 N) {
+inline ui16 cbrt_fix<ui16>(ui16 N) {
   ui16 x_n;
   ui16 x_n_1;
   ui8 N_sqrt;
@@ -73,7 +73,7 @@ ui16 cbrt_fix<ui16>(ui16 N) {
  * @return cubic root of N
  */
 template <>
-i32 cbrt_fix<i32>(i32 N) {
+inline i32 cbrt_fix<i32>(i32 N) {
   ui32 numerator;
   //  mat_coeff k1_3(21845U, 2);  // = 1/3 * 2^16
   i32 x_n, x_n_1;
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cmath>
+#include <string>
+
+#include "cbrt_calc_fix.hpp"  // fixed-point calculation of cubic root by newton method
+#include "cbrt_poly_fix.hpp"  // fixed-point calculation of cubic root by polynomial
+#include "cbrt_tbl_fix.hpp"   //  fixed-point calculation of cubic root by LUT
+
+/********************************************************************************
+ * cube-root policies of the XYB transfer function
+ * each policy maps a Q16 input (0.0 - 1.0 as 0 - 65535) to its Q16 cube root;
+ * rgb2xyb_scalar() takes a policy as template parameter, so every strategy is
+ * compiled into one binary and chosen per conversion with cbrt_method; the SIMD
+ * kernels implement LUT256 and POLY (bit-exact with cbrt_lut256 and cbrt_polynomial)
+ *******************************************************************************/
+enum class cbrt_method { LUT256, LUT1024, NEWTON16, NEWTON32, EXACT, POLY };
+
+// 256-entry table with linear interpolation (cbrt_lut)
+struct cbrt_lut256 {
+  static constexpr cbrt_method method = cbrt_method::LUT256;
+  static i32 eval(i32 N) { return cbrt_lut(static_cast<ui16>(N)); }
+};
+
+// 1024-entry table with linear interpolation (cbrt_lut_fine)
+struct cbrt_lut1024 {
+  static constexpr cbrt_method method = cbrt_method::LUT1024;
+  static i32 eval(i32 N) { return cbrt_lut_fine(static_cast<ui16>(N)); }
+};
+
+// five Newton iterations in 16-bit fixed point (cbrt_fix<ui16>)
+struct cbrt_newton16 {
+  static constexpr cbrt_method method = cbrt_method::NEWTON16;
+  static i32 eval(i32 N) { return cbrt_fix<ui16>(static_cast<ui16>(N)); }
+};
+
+// five Newton iterations in 32-bit fixed point (cbrt_fix<i32>)
+struct cbrt_newton32 {
+  static constexpr cbrt_method method = cbrt_method::NEWTON32;
+  static i32 eval(i32 N) { return cbrt_fix<i32>(N); }
+};
+
+// single-precision std::cbrt, rounded to Q16
+struct cbrt_exact {
+  static constexpr cbrt_method method = cbrt_method::EXACT;
+  static i32 eval(i32 N) { return static_cast<i32>(std::cbrt(N / 65535.0f) * 65535.0f + 0.5f); }
+};
+
+// quadratic seed and one Newton step, no table lookups (cbrt_poly)
+struct cbrt_polynomial {
+  static constexpr cbrt_method method = cbrt_method::POLY;
+  static i32 eval(i32 N) { return cbrt_poly(static_cast<ui16>(N)); }
+};
+
+// name of m: lut256, lut1024, newton16, newton32, exact or poly
+inline const char *cbrt_method_name(cbrt_method m) {
+  switch (m) {
+    case cbrt_method::LUT256:
+      return "lut256";
+    case cbrt_method::LUT1024:
+      return "lut1024";
+    case cbrt_method::NEWTON16:
+      return "newton16";
+    case cbrt_method::NEWTON32:
+      return "newton32";
+    case cbrt_method::EXACT:
+      return "exact";
+    case cbrt_method::POLY:
+      return "poly";
+  }
+  return "unknown";
+}
+
+// inverse of cbrt_method_name(); false if name is unknown
+inline bool parse_cbrt_method(const std::string &name, cbrt_method &m) {
+  for (const auto c : {cbrt_method::LUT256, cbrt_method::LUT1024, cbrt_method::NEWTON16,
+                       cbrt_method::NEWTON32, cbrt_method::EXACT, cbrt_method::POLY}) {
+    if (name == cbrt_method_name(c)) {
+      m = c;
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "cbrt_tbl_fix.hpp"
+#include "typedef.hpp"
+
+/********************************************************************************
+ * branch-free fixed-point cubic root without table lookups
+ * N (Q16, 1 - 65535) is split into N = m * 2^-t with m in [0.5, 1) and t = 3q + r;
+ * a quadratic seed of cbrt(m) is scaled by 2^(-r/3) and refined by one Newton
+ * step against f = N << 3q (= m * 2^-r) whose step size 1/(3 cbrt(f)^2) comes
+ * from a second quadratic; the root of f is finally shifted right by q. Every
+ * product is one the SIMD kernels have in a single instruction on 32-bit lanes
+ * (16-bit high half, 16-bit rounding Q15, 32 x 32 -> 64-bit for the cube), so
+ * they compute exactly the same values as cbrt_poly() below
+ *******************************************************************************/
+// cbrt(0.5 + x) = a0 + x (a1 - a2 x), x = d / 2^16 in [0, 0.5): Q15 coefficients
+constexpr i32 cbrt_poly_a0 = 26025;
+constexpr i32 cbrt_poly_a1 = 16583;
+constexpr i32 cbrt_poly_a2 = 6275;
+// Newton step size (0.5 + x)^(-2/3) / 3 = k0 - x (k1 - k2 x): Q15 coefficients
+constexpr i32 cbrt_poly_k0 = 17252;
+constexpr i32 cbrt_poly_k1 = 19655;
+constexpr i32 cbrt_poly_k2 = 14213;
+// 2^(-r/3) in Q15 (1.0 as 32767, the seed needs no more) and 2^(2r/3) in Q13 for r = 0, 1, 2
+constexpr i32 cbrt_poly_root_scale[3] = {32767, 26008, 20643};
+constexpr i32 cbrt_poly_step_scale[3] = {8192, 13004, 20643};
+// both scales of r in one 32-bit lane, as the SIMD kernels select them
+static constexpr i32 cbrt_poly_scale_pair(i32 r) {
+  return cbrt_poly_root_scale[r] | (cbrt_poly_step_scale[r] << 16);
+}
+// (65535 / 65536)^(2/3) = 1 - 683 / 2^26: the roots are those of N / 65535 scaled by 65535 (as tbl_cbrt)
+constexpr i32 cbrt_poly_range = 683;
+
+/**
+ * @brief Derive cubic root of input (Q16 format of value 0.0 - 1.0) by polynomial and Newton refinement
+ *
+ * @param N input
+ * @return cbrt(N), within 1 of the correctly rounded root (see cbrt_poly_within())
+ */
+static constexpr ui16 cbrt_poly(ui16 N) {
+  const ui32 n = (N == 0U) ? 1U : N;
+  // b = floor(log2(n)); the SIMD kernels read it from the exponent of float(n)
+  i32 b = (n >> 8) ? 8 : 0;
+  b += (n >> (b + 4)) ? 4 : 0;
+  b += (n >> (b + 2)) ? 2 : 0;
+  b += (n >> (b + 1)) ? 1 : 0;
+  const i32 t = 15 - b;
+  const i32 q = (t * 11) >> 5;  // = t / 3 for t < 16
+  const i32 r = t - 3 * q;
+  const i32 d = static_cast<i32>(n << t) - 32768;
+  const i32 f = static_cast<i32>(n << (3 * q));
+  // seed of cbrt(f) in Q15
+  i32 c = cbrt_poly_a0 + (((cbrt_poly_a1 - ((cbrt_poly_a2 * d) >> 16)) * d) >> 16);
+  c     = (c * cbrt_poly_root_scale[r] + (1 << 14)) >> 15;
+  // Newton step size 1/(3c^2) in Q13
+  i32 k = cbrt_poly_k0 - (((cbrt_poly_k1 - ((cbrt_poly_k2 * d) >> 16)) * d) >> 16);
+  k     = (k * cbrt_poly_step_scale[r] + (1 << 14)) >> 15;
+  // c^3 in Q24
+  const i32 cube = static_cast<i32>((static_cast<ui64>(c * c) * static_cast<ui32>(c)) >> 21);
+  const i32 err  = (f << 8) - cube;
+  i32 root       = (c << 9) + ((err * k + (1 << 12)) >> 13);  // Q24
+  root -= (((root >> 8) * cbrt_poly_range) >> 16) >> 2;
+  const i32 y = (root + (128 << q)) >> (8 + q);
+  return (N == 0U) ? 0U : static_cast<ui16>((y > 65535) ? 65535 : y);
+}
+
+/**
+ * @brief Exhaustive check of cbrt_poly() against the correctly rounded cubic root of every input
+ *
+ * The rounded root of N is y if and only if (2y - 1)^3 <= 8 N 65535^2 < (2y + 1)^3, so the check needs no
+ * floating point and can run at compile time.
+ *
+ * @param tol largest allowed difference
+ * @return true if |cbrt_poly(N) - round(cbrt(N / 65535) * 65535)| <= tol for N = 0 - 65535
+ */
+static constexpr bool cbrt_poly_within(i32 tol) {
+  for (ui32 N = 0; N < 65536; ++N) {
+    const i64 y  = cbrt_poly(static_cast<ui16>(N));
+    const i64 lo = 2 * (y - tol) - 1;
+    const i64 hi = 2 * (y + tol) + 1;
+    const i64 v  = 8 * static_cast<i64>(N) * 65535 * 65535;
+    if ((lo > 0 && lo * lo * lo > v) || hi * hi * hi <= v) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * @brief Check of cbrt_poly() against the nodes of tbl_cbrt, the table of cbrt_lut()
+ *
+ * @param tol largest allowed difference
+ * @return true if |cbrt_poly(256 i) - tbl_cbrt[i]| <= tol for i = 0 - 255
+ */
+static constexpr bool cbrt_poly_matches_tbl(i32 tol) {
+  for (ui32 i = 0; i < 256; ++i) {
+    const i32 diff = static_cast<i32>(cbrt_poly(static_cast<ui16>(i << 8))) - tbl_cbrt[i];
+    if (diff > tol || diff < -tol) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -5,6 +5,9 @@
 #ifndef IMAGE_IO_TEST_TBL_CBRT_H
 #define IMAGE_IO_TEST_TBL_CBRT_H
 
+#include <array>
+#include <cstddef>
+
 #include "typedef.hpp"
 
 constexpr ui16 tbl_cbrt_fine[1024] = {
@@ -164,4 +167,19 @@ inline ui16 cbrt_lut_fine(ui16 N) {
   return ret;
 }
 
+/**
+ * @brief tbl_cbrt followed by the interpolation end point (65535), so that a single 32-bit load at
+ * index idx returns tbl_cbrt[idx] in the lower and tbl_cbrt[idx + 1] in the upper 16 bits
+ */
+static constexpr std::array<ui16, 258> make_tbl_cbrt_pair() {
+  std::array<ui16, 258> tbl{};
+  for (size_t i = 0; i < 256; ++i) {
+    tbl[i] = tbl_cbrt[i];
+  }
+  tbl[256] = 65535U;
+  tbl[257] = 65535U;
+  return tbl;
+}
+alignas(32) static constexpr std::array<ui16, 258> tbl_cbrt_pair = make_tbl_cbrt_pair();
+
 #endif  // IMAGE_IO_TEST_TBL_CBRT_H
@@ -1,296 +1,1035 @@
 #include <algorithm>
+#include <cerrno>
+#include <cstring>
 
 #include "image_io.hpp"
 #if defined(USE_OPENMP)
   #include <omp.h>
 #endif
 
-#if defined(MSVC)
+#if defined(_MSC_VER)
 #else
   #include <fcntl.h>
   #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
 #endif
-image::image(const std::vector<std::string> &filenames) : width(0), height(0), buf(nullptr) {
-  size_t num_files = filenames.size();
+
+file_view::~file_view() {
+#if !defined(_MSC_VER)
+  if (mapped) {
+    munmap(const_cast<uint8_t *>(ptr), len);
+  }
+#endif
+}
+
+int file_view::open(const std::string &filename, io_mode mode, plane_pool *pool) {
+  instrument::stage_timer timer(instrument::stage::READ);
+#if !defined(_MSC_VER)
+  if (mode == io_mode::MMAP) {
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return EXIT_FAILURE;
+    }
+    struct stat sb;
+    if (fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+      void *p = mmap(nullptr, static_cast<size_t>(sb.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p != MAP_FAILED) {
+        madvise(p, static_cast<size_t>(sb.st_size), MADV_SEQUENTIAL);
+        ptr    = static_cast<const uint8_t *>(p);
+        len    = static_cast<size_t>(sb.st_size);
+        mapped = true;
+        close(fd);
+        timer.set_bytes(len);
+        return EXIT_SUCCESS;
+      }
+    }
+    close(fd);
+  }
+#endif
+  // STDIO
+  FILE *fp = fopen(filename.c_str(), "rb");
+  if (fp == nullptr) {
+    return EXIT_FAILURE;
+  }
+  long size = -1;
+  if (fseek(fp, 0, SEEK_END) == 0) {
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+  }
+  if (size >= 0) {
+    heap = aligned_uptr<uint8_t>(64, static_cast<size_t>(size), pool);
+    len  = fread(heap.get(), sizeof(uint8_t), static_cast<size_t>(size), fp);
+  } else {  // non-seekable input: grow the buffer until EOF
+    size_t capacity = 1 << 16;
+    size_t n;
+    heap = aligned_uptr<uint8_t>(64, capacity, pool);
+    while ((n = fread(heap.get() + len, sizeof(uint8_t), capacity - len, fp)) > 0) {
+      len += n;
+      if (len == capacity) {
+        auto tmp = aligned_uptr<uint8_t>(64, capacity * 2, pool);
+        std::copy(heap.get(), heap.get() + len, tmp.get());
+        heap = std::move(tmp);
+        capacity *= 2;
+      }
+    }
+  }
+  fclose(fp);
+  ptr = heap.get();
+  timer.set_bytes(len);
+  return EXIT_SUCCESS;
+}
+
+#if defined(_MSC_VER)
+positioned_file::positioned_file() : fp(nullptr), len(0) {}
+
+positioned_file::~positioned_file() {
+  if (fp != nullptr) {
+    fclose(fp);
+  }
+}
+
+int positioned_file::open(const std::string &filename) {
+  fp = fopen(filename.c_str(), "rb");
+  if (fp == nullptr || _fseeki64(fp, 0, SEEK_END) != 0) {
+    return EXIT_FAILURE;
+  }
+  len = static_cast<uint64_t>(_ftelli64(fp));
+  return EXIT_SUCCESS;
+}
+
+bool positioned_file::read(uint64_t offset, uint8_t *dst, size_t n) {
+  instrument::stage_timer timer(instrument::stage::READ, n);
+  return offset <= len && n <= len - offset && _fseeki64(fp, static_cast<int64_t>(offset), SEEK_SET) == 0
+         && fread(dst, 1, n, fp) == n;
+}
+#else
+positioned_file::positioned_file() : fd(-1), len(0) {}
+
+positioned_file::~positioned_file() {
+  if (fd >= 0) {
+    close(fd);
+  }
+}
+
+int positioned_file::open(const std::string &filename) {
+  fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat sb;
+  if (fd < 0 || fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode)) {
+    return EXIT_FAILURE;
+  }
+  len = static_cast<uint64_t>(sb.st_size);
+  return EXIT_SUCCESS;
+}
+
+bool positioned_file::read(uint64_t offset, uint8_t *dst, size_t n) {
+  instrument::stage_timer timer(instrument::stage::READ, n);
+  if (offset > len || n > len - offset) {
+    return false;
+  }
+  while (n > 0) {
+    const ssize_t got = pread(fd, dst, n, static_cast<off_t>(offset));
+    if (got <= 0) {
+      if (got < 0 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    dst += got;
+    offset += static_cast<uint64_t>(got);
+    n -= static_cast<size_t>(got);
+  }
+  return true;
+}
+#endif
+
+// format of an image file from its extension
+static bool format_of(const std::string &fname, imgformat &format) {
+  const size_t ext_pos = fname.find_last_of(".");
+  if (ext_pos == std::string::npos) {
+    return false;
+  }
+  const std::string ext_name = fname.substr(ext_pos);
+  if (ext_name == ".pgm" || ext_name == ".PGM") {
+    format = imgformat::PGM;
+  } else if (ext_name == ".ppm" || ext_name == ".PPM") {
+    format = imgformat::PPM;
+  } else if (ext_name == ".pgx" || ext_name == ".PGX") {
+    format = imgformat::PGX;
+  } else if (ext_name == ".pam" || ext_name == ".PAM") {
+    format = imgformat::PAM;
+  } else if (ext_name == ".pfm" || ext_name == ".PFM") {
+    format = imgformat::PFM;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// number of components of a PAM (its depth) or PFM file held by fv, from its header
+static int num_components_of(imgformat format, const file_view &fv, const std::string &filename,
+                             uint16_t &ncmp) {
+  byte_stream bs(fv.data(), fv.size());
+  if (format == imgformat::PAM) {
+    pam_header hdr;
+    if (parse_pam_header(bs, filename, hdr)) {
+      return EXIT_FAILURE;
+    }
+    ncmp = static_cast<uint16_t>(hdr.depth);
+  } else {
+    pfm_header hdr;
+    if (parse_pfm_header(bs, filename, hdr)) {
+      return EXIT_FAILURE;
+    }
+    ncmp = hdr.num_components;
+  }
+  return EXIT_SUCCESS;
+}
+
+// log2 of a reduction factor of 1, 2, 4 or 8
+static uint8_t log2_reduction_of(uint32_t reduction) {
+  switch (reduction) {
+    case 1:
+      return 0;
+    case 2:
+      return 1;
+    case 4:
+      return 2;
+    case 8:
+      return 3;
+    default:
+      printf("ERROR: reduction factor shall be 1, 2, 4 or 8.\n");
+      throw std::exception();
+  }
+}
+
+image::image(const std::vector<std::string> &filenames, io_mode mode, sample_storage storage,
+             plane_pool *pool, thread_pool *workers, uint32_t reduction)
+    : width(0),
+      height(0),
+      buf(nullptr),
+      mode(mode),
+      storage(storage),
+      pool(pool),
+      log2_reduction(log2_reduction_of(reduction)) {
+  read_files(filenames, nullptr, workers);
+}
+
+image::image(const std::vector<std::string> &filenames, std::vector<file_view> &views,
+             sample_storage storage, plane_pool *pool, uint32_t reduction)
+    : width(0),
+      height(0),
+      buf(nullptr),
+      mode(io_mode::MMAP),
+      storage(storage),
+      pool(pool),
+      log2_reduction(log2_reduction_of(reduction)) {
+  assert(views.size() == filenames.size());
+  read_files(filenames, &views, nullptr);
+}
+
+void image::read_files(const std::vector<std::string> &filenames, std::vector<file_view> *views,
+                       thread_pool *workers) {
+  const size_t num_files = filenames.size();
   if (num_files > 16384) {
     printf("ERROR: over 16384 components are not supported in the spec.\n");
     throw std::exception();
   }
+  // create every component in file order, so that indices do not depend on the reading order
+  std::vector<imgformat> formats(num_files);
+  std::vector<uint16_t> first_component(num_files);
+  // the number of components of a PAM or PFM file is given by its header: such files are opened here, on
+  // the calling thread, and decoded from these views below
+  std::vector<file_view> opened(num_files);
   num_components = 0;
-  for (const auto &fname : filenames) {
-    size_t ext_pos       = fname.find_last_of(".");
-    std::string ext_name = fname.substr(ext_pos, fname.size() - ext_pos);
-    if (ext_name == ".pgm" || ext_name == ".PGM") {
-      num_components++;
+  for (size_t i = 0; i < num_files; ++i) {
+    if (!format_of(filenames[i], formats[i])) {
+      printf("ERROR: file %zu (%s) is not a PGM, PPM, PGX, PAM or PFM file.\n", i, filenames[i].c_str());
+      throw image_read_error(i, filenames[i]);
     }
-    if (ext_name == ".ppm" || ext_name == ".PPM") {
-      num_components += 3;
+    if (log2_reduction > 0 && (formats[i] == imgformat::PGX || formats[i] == imgformat::PFM)) {
+      printf("ERROR: file %zu (%s) is not a PGM, PPM or PAM file, which reduced reads support.\n", i,
+             filenames[i].c_str());
+      throw image_read_error(i, filenames[i]);
     }
-    if (ext_name == ".pgx" || ext_name == ".PGX") {
-      num_components++;
+    first_component[i] = num_components;
+    uint16_t ncmp      = (formats[i] == imgformat::PPM) ? 3 : 1;
+    if (formats[i] == imgformat::PAM || formats[i] == imgformat::PFM) {
+      if (views == nullptr && opened[i].open(filenames[i], mode, pool)) {
+        printf("ERROR: File %s is not found.\n", filenames[i].c_str());
+        throw image_read_error(i, filenames[i]);
+      }
+      const file_view &fv = (views != nullptr) ? (*views)[i] : opened[i];
+      if (num_components_of(formats[i], fv, filenames[i], ncmp)) {
+        printf("ERROR: file %zu (%s) cannot be read.\n", i, filenames[i].c_str());
+        throw image_read_error(i, filenames[i]);
+      }
     }
+    if (num_components + ncmp > 16384) {
+      printf("ERROR: over 16384 components are not supported in the spec.\n");
+      throw image_read_error(i, filenames[i]);
+    }
+    for (uint16_t c = num_components; c < num_components + ncmp; ++c) {
+      if (formats[i] == imgformat::PGX) {
+        components.emplace_back(std::make_unique<pgx_component>(c));
+      } else {
+        components.emplace_back(std::make_unique<pgm_component>(c));
+      }
+      components.back()->set_io_mode(mode);
+      components.back()->set_sample_storage(storage);
+      components.back()->set_log2_reduction(log2_reduction);
+      components.back()->set_pool(pool);
+    }
+    num_components += ncmp;
   }
   // allocate memory once
-  if (this->buf == nullptr) {
-    // this->buf =
-    //     std::make_unique<std::unique_ptr<int32_t[]>[]>(this->num_components);
-    this->buf = std::make_unique<unique_ptr_aligned<int32_t>[]>(this->num_components);
-  }
-  components.reserve(num_components);
-  uint16_t c = 0;
-  imgformat format;
-  for (const auto &fname : filenames) {
-    size_t ext_pos       = fname.find_last_of(".");
-    std::string ext_name = fname.substr(ext_pos, fname.size() - ext_pos);
-    if (ext_name == ".pgm" || ext_name == ".PGM") {
-      format = imgformat::PGM;
-    }
-    if (ext_name == ".ppm" || ext_name == ".PPM") {
-      format = imgformat::PPM;
-    }
-    if (ext_name == ".pgx" || ext_name == ".PGX") {
-      format = imgformat::PGX;
-    }
-    switch (format) {
-      case imgformat::PGM:
-        printf("PGM\n");
-        components.emplace_back(std::make_unique<pgm_component>(c));
-        if (components[components.size() - 1]->read(fname)) {
-          exit(EXIT_FAILURE);
-        }
-        component_width.push_back(components[components.size() - 1]->get_width());
-        component_height.push_back(components[components.size() - 1]->get_height());
-        bits_per_pixel.push_back(components[components.size() - 1]->get_bpp());
-        is_signed.push_back(components[components.size() - 1]->get_is_signed());
-        this->buf[components.size() - 1] = components[components.size() - 1]->move_buf();
-        c++;
-        break;
+  this->buf = std::make_unique<unique_ptr_aligned<uint8_t>[]>(this->num_components);
+
+  // each file fills only its own components, so the files are read concurrently
+  std::vector<int> status(num_files, EXIT_FAILURE);
+  auto read_file = [&](size_t i) {
+    const uint16_t c    = first_component[i];
+    const file_view &fv = (views != nullptr) ? (*views)[i] : opened[i];
+    switch (formats[i]) {
       case imgformat::PPM:
-        printf("PPM\n");
-        components.emplace_back(std::make_unique<pgm_component>(c));
-        components.emplace_back(std::make_unique<pgm_component>(c + 1));
-        components.emplace_back(std::make_unique<pgm_component>(c + 2));
-        if (read_ppm(fname, c)) {
-          exit(EXIT_FAILURE);
-        }
-        for (uint16_t i = c; i < c + 3; ++i) {
-          component_width.push_back(components[i]->get_width());
-          component_height.push_back(components[i]->get_height());
-          bits_per_pixel.push_back(components[i]->get_bpp());
-          is_signed.push_back(false);
-          this->buf[i] = components[i]->move_buf();
-        }
-        c += 3;
+        status[i] = (views != nullptr) ? decode_ppm(fv, filenames[i], c) : read_ppm(filenames[i], c);
         break;
-      case imgformat::PGX:
-        printf("PGX\n");
-        components.emplace_back(std::make_unique<pgx_component>(c));
-        if (components[components.size() - 1]->read(fname)) {
-          exit(EXIT_FAILURE);
-        }
-        component_width.push_back(components[components.size() - 1]->get_width());
-        component_height.push_back(components[components.size() - 1]->get_height());
-        bits_per_pixel.push_back(components[components.size() - 1]->get_bpp());
-        is_signed.push_back(components[components.size() - 1]->get_is_signed());
-        this->buf[components.size() - 1] = components[components.size() - 1]->move_buf();
-        c++;
+      case imgformat::PAM:
+        status[i] = decode_pam(fv, filenames[i], c);
         break;
-      deafult:
-        printf("ERROR\n");
+      case imgformat::PFM:
+        status[i] = decode_pfm(fv, filenames[i], c);
+        break;
+      default:
+        status[i] = (views != nullptr) ? components[c]->decode(fv, filenames[i])
+                                       : components[c]->read(filenames[i]);
+        break;
+    }
+  };
+  if (views != nullptr || num_files == 1) {
+    // files in memory are only unpacked, which is left to the caller's threads
+    for (size_t i = 0; i < num_files; ++i) {
+      read_file(i);
     }
+  } else if (num_files > 1) {
+    std::unique_ptr<thread_pool> own_workers;
+    if (workers == nullptr) {
+      own_workers = std::make_unique<thread_pool>(
+          std::min(num_files, static_cast<size_t>(std::thread::hardware_concurrency())));
+      workers = own_workers.get();
+    }
+    std::vector<std::future<void>> done;
+    done.reserve(num_files);
+    for (size_t i = 0; i < num_files; ++i) {
+      done.emplace_back(workers->enqueue([&read_file, i] { read_file(i); }));
+    }
+    // wait for every task before leaving, they refer to this frame
+    for (size_t i = 0; i < num_files; ++i) {
+      try {
+        done[i].get();
+      } catch (...) {
+        status[i] = EXIT_FAILURE;
+      }
+    }
+  }
+  for (size_t i = 0; i < num_files; ++i) {
+    if (status[i]) {
+      printf("ERROR: file %zu (%s) cannot be read.\n", i, filenames[i].c_str());
+      throw image_read_error(i, filenames[i]);
+    }
+  }
+  collect_components();
+}
+
+void image::collect_components() {
+  for (uint16_t c = 0; c < num_components; ++c) {
+    component_width.push_back(components[c]->get_width());
+    component_height.push_back(components[c]->get_height());
+    bits_per_pixel.push_back(components[c]->get_bpp());
+    is_signed.push_back(components[c]->get_is_signed());
+    sample_types.push_back(components[c]->get_sample_type());
+    this->buf[c] = components[c]->move_buf();
+  }
+  if (num_components > 0) {
+    width  = *std::max_element(component_width.begin(), component_width.end());
+    height = *std::max_element(component_height.begin(), component_height.end());
+  }
+}
+
+image::image(uint32_t w, uint32_t h, chroma_subsampling cs, uint8_t bpp, bool issigned, sample_type type,
+             plane_pool *pool)
+    : width(w),
+      height(h),
+      num_components(3),
+      mode(io_mode::MMAP),
+      storage(sample_storage::INT32),
+      pool(pool),
+      log2_reduction(0) {
+  this->buf = std::make_unique<unique_ptr_aligned<uint8_t>[]>(this->num_components);
+  for (uint16_t c = 0; c < num_components; ++c) {
+    const bool chroma = c != 1;
+    component_width.push_back((chroma && cs != chroma_subsampling::S444) ? (w + 1) / 2 : w);
+    component_height.push_back((chroma && cs == chroma_subsampling::S420) ? (h + 1) / 2 : h);
+    bits_per_pixel.push_back(bpp);
+    is_signed.push_back(issigned);
+    sample_types.push_back(type);
+    const size_t num_samples = static_cast<size_t>(component_width[c]) * component_height[c];
+    this->buf[c]             = aligned_uptr<uint8_t>(32, num_samples * sample_size(type), pool);
   }
-  width  = *std::max_element(component_width.begin(), component_width.end());
-  height = *std::max_element(component_height.begin(), component_height.end());
 }
 
 int image::read_ppm(const std::string &filename, uint16_t compidx) {
-  FILE *fp = fopen(filename.c_str(), "rb");
-  if (fp == nullptr) {
+  file_view fv;
+  if (fv.open(filename, mode, pool)) {
     printf("ERROR: File %s is not found.\n", filename.c_str());
     return EXIT_FAILURE;
   }
-  status st = status::READ_WIDTH;
-  int d;
-  uint32_t val = 0;
-  char comment[256];
-  d = fgetc(fp);
-  if (d != 'P') {
-    printf("ERROR: %s is not a PPM file.\n", filename.c_str());
-    fclose(fp);
+  return decode_ppm(fv, filename, compidx);
+}
+
+int image::decode_ppm(const file_view &fv, const std::string &filename, uint16_t compidx) {
+  byte_stream bs(fv.data(), fv.size());
+  pnm_header hdr;
+  if (parse_pnm_header(bs, filename, 3, hdr)) {
     return EXIT_FAILURE;
   }
+  // the planes are of the reduced size if the image is read reduced
+  const uint32_t out_w = reduced_size(hdr.width, log2_reduction);
+  const uint32_t out_h = reduced_size(hdr.height, log2_reduction);
+  for (size_t i = compidx; i < compidx + 3u; ++i) {
+    components[i]->set_width(out_w);
+    components[i]->set_height(out_h);
+    components[i]->set_bpp(hdr.bpp);
+  }
 
-  d = fgetc(fp);
-  switch (d) {
-    // PPM
-    case '3':
-      printf("ASCII PPM is not supported.\n");
-      fclose(fp);
-      return EXIT_FAILURE;
+  // P6 (binary) read, P3 (ASCII) samples are parsed into the same layout first
+  const uint32_t byte_per_sample = hdr.byte_per_sample();
+  const uint32_t component_gap   = 3 * byte_per_sample;
+  const size_t num_samples       = static_cast<size_t>(hdr.width) * hdr.height;
+  const size_t length            = component_gap * num_samples;
+  unique_ptr_aligned<uint8_t> parsed;
+  const uint8_t *src = pnm_raster(bs, hdr, filename, 3 * num_samples, parsed, pool);
+  if (src == nullptr) {
+    return EXIT_FAILURE;
+  }
+  // allocate memory
+  const sample_type type = (storage == sample_storage::NARROW)
+                               ? narrowest_sample_type(components[compidx]->get_bpp(), false)
+                               : sample_type::S32;
+  for (size_t i = compidx; i < compidx + 3u; ++i) {
+    components[i]->create_buf(static_cast<size_t>(out_w) * out_h, type);
+  }
+  instrument::stage_timer timer(instrument::stage::UNPACK, length);
+  unpack_raster(src, compidx, 3, byte_per_sample, hdr.width, hdr.height);
+  return EXIT_SUCCESS;
+}
+
+void image::unpack_interleaved(const uint8_t *src, uint16_t compidx, uint16_t depth,
+                               uint32_t byte_per_sample, size_t len) {
+  const kernel_table &k = get_kernels();
+  switch (components[compidx]->get_sample_type()) {
+    case sample_type::U8: {
+      uint8_t *d[4];
+      for (uint16_t ch = 0; ch < depth; ++ch) {
+        d[ch] = components[compidx + ch]->get_buf<uint8_t>();
+      }
+      if (depth == 1) {
+        memcpy(d[0], src, len);
+      } else if (depth == 3) {
+        k.unpack_rgb_u8_to_u8(src, d[0], d[1], d[2], len);
+      } else if (depth == 4) {
+        k.unpack_rgba_u8_to_u8(src, d[0], d[1], d[2], d[3], len);
+      } else {
+        unpack_interleaved_scalar(src, d, depth, 1, len);
+      }
       break;
-    case '6':
+    }
+    case sample_type::U16: {
+      uint16_t *d[4];
+      for (uint16_t ch = 0; ch < depth; ++ch) {
+        d[ch] = components[compidx + ch]->get_buf<uint16_t>();
+      }
+      if (depth == 1) {
+        k.unpack_big_16_to_16(src, d[0], len);
+      } else if (depth == 3) {
+        k.unpack_rgb_big_u16_to_u16(src, d[0], d[1], d[2], len);
+      } else if (depth == 4) {
+        k.unpack_rgba_big_u16_to_u16(src, d[0], d[1], d[2], d[3], len);
+      } else {
+        unpack_interleaved_scalar(src, d, depth, 2, len);
+      }
       break;
-    // error
-    default:
-      printf("ERROR: %s is not a PPM file.\n", filename.c_str());
-      fclose(fp);
-      return EXIT_FAILURE;
+    }
+    default: {
+      int32_t *d[4];
+      for (uint16_t ch = 0; ch < depth; ++ch) {
+        d[ch] = components[compidx + ch]->get_buf();
+      }
+      unpack_interleaved_s32(src, d, depth, byte_per_sample, len);
       break;
+    }
   }
-  while (st != status::DONE) {
-    d = fgetc(fp);
-    eat_white(d, fp, comment);
-    // read numerical value
-    while (d != SP && d != LF && d != CR) {
-      val *= 10;
-      val += d - '0';
-      d = fgetc(fp);
-    }
-    // update status
-    switch (st) {
-      case status::READ_WIDTH:
-        this->components[compidx]->set_width(val);
-        this->components[compidx + 1]->set_width(val);
-        this->components[compidx + 2]->set_width(val);
-        val = 0;
-        st  = status::READ_HEIGHT;
-        break;
-      case status::READ_HEIGHT:
-        this->components[compidx]->set_height(val);
-        this->components[compidx + 1]->set_height(val);
-        this->components[compidx + 2]->set_height(val);
-        val = 0;
-        st  = status::READ_MAXVAL;
-        break;
-      case status::READ_MAXVAL:
-        this->components[compidx]->set_bpp(static_cast<uint8_t>(log2(static_cast<float>(val)) + 1.0f));
-        this->components[compidx + 1]->set_bpp(static_cast<uint8_t>(log2(static_cast<float>(val)) + 1.0f));
-        this->components[compidx + 2]->set_bpp(static_cast<uint8_t>(log2(static_cast<float>(val)) + 1.0f));
-        val = 0;
-        st  = status::DONE;
-        break;
-      default:
-        break;
+}
+
+void image::unpack_raster(const uint8_t *src, uint16_t compidx, uint16_t depth, uint32_t byte_per_sample,
+                          uint32_t w, uint32_t h) {
+  if (log2_reduction == 0) {
+    unpack_interleaved(src, compidx, depth, byte_per_sample, static_cast<size_t>(w) * h);
+    return;
+  }
+  uint8_t *planes[4];
+  for (uint16_t ch = 0; ch < depth; ++ch) {
+    planes[ch] = components[compidx + ch]->get_bytes();
+  }
+  unpack_reduced(src, w, h, depth, byte_per_sample, log2_reduction, components[compidx]->get_sample_type(),
+                 planes, pool);
+}
+
+int image::decode_pam(const file_view &fv, const std::string &filename, uint16_t compidx) {
+  byte_stream bs(fv.data(), fv.size());
+  pam_header hdr;
+  if (parse_pam_header(bs, filename, hdr)) {
+    return EXIT_FAILURE;
+  }
+  const uint16_t depth = static_cast<uint16_t>(hdr.depth);
+  // the planes are of the reduced size if the image is read reduced
+  const uint32_t out_w = reduced_size(hdr.width, log2_reduction);
+  const uint32_t out_h = reduced_size(hdr.height, log2_reduction);
+  for (size_t i = compidx; i < compidx + depth; ++i) {
+    components[i]->set_width(out_w);
+    components[i]->set_height(out_h);
+    components[i]->set_bpp(hdr.bpp);
+  }
+
+  const uint32_t byte_per_sample = hdr.byte_per_sample();
+  const size_t num_samples       = static_cast<size_t>(hdr.width) * hdr.height;
+  const size_t length            = depth * byte_per_sample * num_samples;
+  if (bs.remaining() < length) {
+    printf("ERROR: not enough samples in the given pam file.\n");
+    return EXIT_FAILURE;
+  }
+  const sample_type type = (storage == sample_storage::NARROW) ? narrowest_sample_type(hdr.bpp, false)
+                                                               : sample_type::S32;
+  for (size_t i = compidx; i < compidx + depth; ++i) {
+    components[i]->create_buf(static_cast<size_t>(out_w) * out_h, type);
+  }
+  instrument::stage_timer timer(instrument::stage::UNPACK, length);
+  unpack_raster(bs.ptr(), compidx, depth, byte_per_sample, hdr.width, hdr.height);
+  return EXIT_SUCCESS;
+}
+
+// sample of a PFM raster at p
+static inline float load_f32(const uint8_t *p, bool little_endian) {
+  const uint32_t b0 = (little_endian) ? p[0] : p[3];
+  const uint32_t b1 = (little_endian) ? p[1] : p[2];
+  const uint32_t b2 = (little_endian) ? p[2] : p[1];
+  const uint32_t b3 = (little_endian) ? p[3] : p[0];
+  const uint32_t u  = b0 | (b1 << 8) | (b2 << 16) | (b3 << 24);
+  float f;
+  memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+int image::decode_pfm(const file_view &fv, const std::string &filename, uint16_t compidx) {
+  byte_stream bs(fv.data(), fv.size());
+  pfm_header hdr;
+  if (parse_pfm_header(bs, filename, hdr)) {
+    return EXIT_FAILURE;
+  }
+  const uint16_t ncmp = hdr.num_components;
+  for (size_t i = compidx; i < compidx + ncmp; ++i) {
+    components[i]->set_width(hdr.width);
+    components[i]->set_height(hdr.height);
+    components[i]->set_bpp(32);
+    components[i]->set_is_signed(true);
+  }
+
+  const size_t num_samples = static_cast<size_t>(hdr.width) * hdr.height;
+  const size_t row_bytes   = sizeof(float) * ncmp * hdr.width;
+  if (bs.remaining() / (sizeof(float) * ncmp) < num_samples) {
+    printf("ERROR: not enough samples in the given pfm file.\n");
+    return EXIT_FAILURE;
+  }
+  float *d[3];
+  for (uint16_t ch = 0; ch < ncmp; ++ch) {
+    components[compidx + ch]->create_buf(num_samples, sample_type::F32);
+    d[ch] = components[compidx + ch]->get_buf<float>();
+  }
+  instrument::stage_timer timer(instrument::stage::UNPACK, row_bytes * hdr.height);
+  for (uint32_t y = 0; y < hdr.height; ++y) {
+    // rows are stored from the bottom up
+    const uint8_t *src  = bs.ptr() + (hdr.height - 1 - y) * row_bytes;
+    const size_t offset = static_cast<size_t>(y) * hdr.width;
+    for (size_t x = offset; x < offset + hdr.width; ++x) {
+      for (uint16_t ch = 0; ch < ncmp; ++ch, src += sizeof(float)) {
+        d[ch][x] = load_f32(src, hdr.little_endian);
+      }
     }
   }
-  eat_white(d, fp, comment);
-  fseek(fp, -1, SEEK_CUR);
-  long offset = ftell(fp);
+  return EXIT_SUCCESS;
+}
 
-  const uint32_t byte_per_sample      = (components[compidx]->get_bpp() + 8 - 1) / 8;
-  const uint32_t component_gap        = 3 * byte_per_sample;
-  const uint32_t compw                = components[compidx]->get_width();
-  const uint32_t comph                = components[compidx]->get_height();
-  const uint32_t length               = component_gap * compw * comph;
-  std::unique_ptr<uint8_t[]> line_buf = std::make_unique<uint8_t[]>(component_gap * compw);
-  // allocate memory
-  for (size_t i = compidx; i < compidx + 3; ++i) {
-    components[i]->create_buf(compw * comph);
-    //   this->buf[i] = std::make_unique<int32_t[]>(compw * comph);
+// true if the n bytes at p hold the whole header of a PGM/PPM (4 tokens) or PAM (up to ENDHDR) file and
+// the byte that ends it; a broken header is reported by the parser once the whole file is read
+static bool holds_header(const uint8_t *p, size_t n, imgformat format) {
+  byte_stream bs(p, n);
+  for (int t = 1;; ++t) {
+    bs.skip_white();
+    const std::string token = bs.read_token();
+    if (token.empty()) {
+      return false;
+    }
+    if ((format == imgformat::PAM) ? token == "ENDHDR" : t == 4) {
+      return bs.remaining() > 0;
+    }
   }
-  auto tmp = aligned_uptr<uint8_t>(32, length);
-  if (fread(tmp.get(), sizeof(uint8_t), length, fp) < length) {
+}
+
+image::image(const std::vector<std::string> &filenames, const image_roi &roi, sample_storage storage,
+             plane_pool *pool)
+    : width(0),
+      height(0),
+      buf(nullptr),
+      mode(io_mode::STDIO),
+      storage(storage),
+      pool(pool),
+      log2_reduction(0) {
+  num_components = 0;
+  for (size_t i = 0; i < filenames.size(); ++i) {
+    imgformat format;
+    if (!format_of(filenames[i], format)
+        || (format != imgformat::PGM && format != imgformat::PPM && format != imgformat::PAM)) {
+      printf("ERROR: file %zu (%s) is not a PGM, PPM or PAM file, which ROI reads support.\n", i,
+             filenames[i].c_str());
+      throw image_read_error(i, filenames[i]);
+    }
+    if (read_window(filenames[i], format, roi)) {
+      printf("ERROR: file %zu (%s) cannot be read.\n", i, filenames[i].c_str());
+      throw image_read_error(i, filenames[i]);
+    }
+  }
+  this->buf = std::make_unique<unique_ptr_aligned<uint8_t>[]>(this->num_components);
+  collect_components();
+}
+
+int image::read_window(const std::string &filename, imgformat format, const image_roi &roi) {
+  positioned_file f;
+  if (f.open(filename)) {
+    printf("ERROR: File %s is not found.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  // the header, read in growing prefixes of the file
+  const size_t file_size = static_cast<size_t>(std::min<uint64_t>(f.size(), SIZE_MAX));
+  std::vector<uint8_t> head(std::min<size_t>(file_size, 4096));
+  if (!f.read(0, head.data(), head.size())) {
+    printf("ERROR: File %s cannot be read.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  while (!holds_header(head.data(), head.size(), format) && head.size() < file_size) {
+    const size_t have = head.size();
+    head.resize(std::min(2 * have, file_size));
+    if (!f.read(have, head.data() + have, head.size() - have)) {
+      printf("ERROR: File %s cannot be read.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  byte_stream bs(head.data(), head.size());
+  uint32_t w, h, depth, byte_per_sample;
+  uint8_t bpp;
+  if (format == imgformat::PAM) {
+    pam_header hdr;
+    if (parse_pam_header(bs, filename, hdr)) {
+      return EXIT_FAILURE;
+    }
+    w               = hdr.width;
+    h               = hdr.height;
+    depth           = hdr.depth;
+    bpp             = hdr.bpp;
+    byte_per_sample = hdr.byte_per_sample();
+  } else {
+    pnm_header hdr;
+    if (parse_pnm_header(bs, filename, (format == imgformat::PPM) ? 3 : 1, hdr)) {
+      return EXIT_FAILURE;
+    }
+    if (hdr.is_ascii()) {
+      printf("ERROR: %s has a plain (ASCII) raster, ROI reads require a binary one.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+    w               = hdr.width;
+    h               = hdr.height;
+    depth           = hdr.num_components();
+    bpp             = hdr.bpp;
+    byte_per_sample = hdr.byte_per_sample();
+  }
+  if (roi.width == 0 || roi.height == 0 || roi.x0 >= w || roi.width > w - roi.x0 || roi.y0 >= h
+      || roi.height > h - roi.y0) {
+    printf("ERROR: window %ux%u at (%u, %u) is not inside %s (%ux%u).\n", roi.width, roi.height, roi.x0,
+           roi.y0, filename.c_str(), w, h);
+    return EXIT_FAILURE;
+  }
+  const uint64_t raster    = bs.tell();
+  const uint64_t unit      = static_cast<uint64_t>(depth) * byte_per_sample;  // bytes per pixel
+  const uint64_t row_bytes = unit * w;
+  if (f.size() - raster < row_bytes * h) {
     printf("ERROR: not enough samples in the given pnm file.\n");
-    fclose(fp);
     return EXIT_FAILURE;
   }
-  auto R   = components[compidx]->get_buf();
-  auto G   = components[compidx + 1]->get_buf();
-  auto B   = components[compidx + 2]->get_buf();
-  auto src = tmp.get();
-
-  const size_t simdgap = (byte_per_sample == 1) ? 16 : 8;
-  const size_t simdlen = compw * comph - (compw * comph) % simdgap;
-#if defined(USE_ARM_NEON)
-  switch (byte_per_sample) {
-    case 1:  // <= 8bpp
-
-      for (size_t i = 0; i < simdlen; i += simdgap) {
-        uint8x16x3_t vsrc = vld3q_u8((src + i * component_gap));
-        store_u8_to_u32(vsrc.val[0], R + i);
-        store_u8_to_u32(vsrc.val[1], G + i);
-        store_u8_to_u32(vsrc.val[2], B + i);
-      }
-      for (size_t i = simdlen; i < compw * comph; ++i) {
-        R[i] = src[component_gap * i];
-        G[i] = src[component_gap * i + byte_per_sample];
-        B[i] = src[component_gap * i + 2 * byte_per_sample];
+
+  // the column span of the rows of the window, packed into one raster of the size of the window
+  const size_t span       = static_cast<size_t>(unit * roi.width);
+  const size_t num_pixels = static_cast<size_t>(roi.width) * roi.height;
+  auto crop               = aligned_uptr<uint8_t>(64, span * roi.height, pool);
+  const uint64_t first    = raster + row_bytes * roi.y0 + unit * roi.x0;
+  if (roi.width == w) {  // whole rows are contiguous in the file
+    if (!f.read(first, crop.get(), span * roi.height)) {
+      printf("ERROR: File %s cannot be read.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+  } else {
+    for (uint32_t y = 0; y < roi.height; ++y) {
+      if (!f.read(first + row_bytes * y, crop.get() + span * y, span)) {
+        printf("ERROR: File %s cannot be read.\n", filename.c_str());
+        return EXIT_FAILURE;
       }
+    }
+  }
+
+  const uint16_t compidx = num_components;
+  const sample_type type =
+      (storage == sample_storage::NARROW) ? narrowest_sample_type(bpp, false) : sample_type::S32;
+  for (uint16_t c = compidx; c < compidx + depth; ++c) {
+    components.emplace_back(std::make_unique<pgm_component>(c));
+    components.back()->set_io_mode(mode);
+    components.back()->set_sample_storage(storage);
+    components.back()->set_pool(pool);
+    components.back()->set_width(roi.width);
+    components.back()->set_height(roi.height);
+    components.back()->set_bpp(bpp);
+    components.back()->create_buf(num_pixels, type);
+  }
+  num_components += static_cast<uint16_t>(depth);
+  instrument::stage_timer timer(instrument::stage::UNPACK, span * roi.height);
+  unpack_interleaved(crop.get(), compidx, static_cast<uint16_t>(depth), byte_per_sample, num_pixels);
+  return EXIT_SUCCESS;
+}
+
+// open filename for writing and put the header
+static FILE *open_output(const std::string &filename, const char *header) {
+  FILE *fp = fopen(filename.c_str(), "wb");
+  if (fp == nullptr) {
+    printf("ERROR: cannot open %s for writing.\n", filename.c_str());
+    return nullptr;
+  }
+  fputs(header, fp);
+  return fp;
+}
+
+static int close_output(FILE *fp, const std::string &filename, int status) {
+  if (fclose(fp) != 0 || status != EXIT_SUCCESS) {
+    printf("ERROR: failed to write %s.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+// write len 16-bit native-endian samples in big-endian order
+static int write_raster_16(FILE *fp, const uint16_t *src, size_t len, plane_pool *pool) {
+  // the byte swap of the reader is its own inverse
+  return write_raster(
+      fp, len, 2,
+      [&](size_t first, size_t n, uint8_t *dst) {
+        get_kernels().unpack_big_16_to_16(reinterpret_cast<const uint8_t *>(src + first),
+                                          reinterpret_cast<uint16_t *>(dst), n);
+      },
+      pool);
+}
+
+// write len int32 samples narrowed by pack
+static int write_raster_32(FILE *fp, const int32_t *src, size_t len, size_t bytes, pack_fn pack,
+                           plane_pool *pool) {
+  return write_raster(
+      fp, len, bytes, [&](size_t first, size_t n, uint8_t *dst) { pack(src + first, dst, n); }, pool);
+}
+
+int image::write_pgm(uint16_t c, const std::string &filename) const {
+  const uint8_t bpp = bits_per_pixel[c];
+  if (is_signed[c] || bpp > 16) {
+    printf("ERROR: component %d (%d bpp, signed = %d) cannot be stored in PGM.\n", c, bpp,
+           static_cast<int>(is_signed[c]));
+    return EXIT_FAILURE;
+  }
+  const size_t len = static_cast<size_t>(component_width[c]) * component_height[c];
+  char header[64];
+  snprintf(header, sizeof(header), "P5\n%u %u\n%u\n", component_width[c], component_height[c],
+           (1U << bpp) - 1);
+  instrument::stage_timer timer(instrument::stage::WRITE, strlen(header) + len * ((bpp > 8) ? 2 : 1));
+  FILE *fp = open_output(filename, header);
+  if (fp == nullptr) {
+    return EXIT_FAILURE;
+  }
+  const kernel_table &k = get_kernels();
+  int status            = EXIT_SUCCESS;
+  switch (sample_types[c]) {
+    case sample_type::U8:
+      status = (fwrite(get_buf<uint8_t>(c), 1, len, fp) == len) ? EXIT_SUCCESS : EXIT_FAILURE;
       break;
-    case 2:  // > 8bpp
-      for (size_t i = 0; i < simdlen; i += simdgap) {
-        uint16x8x3_t vsrc = vld3q_u16((uint16_t *)(src + i * component_gap));
-        store_big_u16_to_u32(vsrc.val[0], R + i);
-        store_big_u16_to_u32(vsrc.val[1], G + i);
-        store_big_u16_to_u32(vsrc.val[2], B + i);
-      }
-      for (size_t i = simdlen; i < compw * comph; ++i) {
-        R[i] = src[component_gap * i] << 8;
-        R[i] |= src[component_gap * i + 1];
-        G[i] = src[component_gap * i + 2] << 8;
-        G[i] |= src[component_gap * i + 3];
-        B[i] = src[component_gap * i + 4] << 8;
-        B[i] |= src[component_gap * i + 5];
-      }
+    case sample_type::U16:
+      status = write_raster_16(fp, get_buf<uint16_t>(c), len, pool);
       break;
     default:
+      status = (bpp > 8) ? write_raster_32(fp, get_buf(c), len, 2, k.pack_s32_to_big_u16, pool)
+                         : write_raster_32(fp, get_buf(c), len, 1, k.pack_s32_to_u8, pool);
       break;
   }
-#elif defined(__AVX2__)
-  switch (byte_per_sample) {
-    case 1:  // <= 8bpp
-      for (size_t i = 0; i < compw * comph - (compw * comph) % 16; i += 16) {
-        load_u8_store_s32(src + component_gap * i, R + i, G + i, B + i);
-      }
+  return close_output(fp, filename, status);
+}
 
-      for (size_t i = compw * comph - (compw * comph) % 16; i < compw * comph; ++i) {
-        R[i] = src[component_gap * i];
-        G[i] = src[component_gap * i + byte_per_sample];
-        B[i] = src[component_gap * i + 2 * byte_per_sample];
-      }
+int image::write_ppm(const std::string &filename) const {
+  if (num_components != 3) {
+    printf("ERROR: PPM requires 3 components, the image has %d.\n", num_components);
+    return EXIT_FAILURE;
+  }
+  const uint8_t bpp = bits_per_pixel[0];
+  for (uint16_t c = 0; c < 3; ++c) {
+    if (component_width[c] != component_width[0] || component_height[c] != component_height[0]
+        || bits_per_pixel[c] != bpp || sample_types[c] != sample_types[0] || is_signed[c] || bpp > 16) {
+      printf("ERROR: components cannot be stored in PPM.\n");
+      return EXIT_FAILURE;
+    }
+  }
+  const size_t len = static_cast<size_t>(component_width[0]) * component_height[0];
+  char header[64];
+  snprintf(header, sizeof(header), "P6\n%u %u\n%u\n", component_width[0], component_height[0],
+           (1U << bpp) - 1);
+  instrument::stage_timer timer(instrument::stage::WRITE, strlen(header) + 3 * len * ((bpp > 8) ? 2 : 1));
+  FILE *fp = open_output(filename, header);
+  if (fp == nullptr) {
+    return EXIT_FAILURE;
+  }
+  const kernel_table &k = get_kernels();
+  int status            = EXIT_SUCCESS;
+  switch (sample_types[0]) {
+    case sample_type::U8: {
+      const uint8_t *R = get_buf<uint8_t>(0), *G = get_buf<uint8_t>(1), *B = get_buf<uint8_t>(2);
+      status = write_raster(
+          fp, len, 3,
+          [&](size_t first, size_t n, uint8_t *dst) {
+            k.pack_rgb_u8_to_u8(R + first, G + first, B + first, dst, n);
+          },
+          pool);
       break;
-    case 2:  // > 8bpp
-  #pragma omp parallel for
-      for (size_t i = 0; i < compw * comph - (compw * comph) % 8; i += 8) {
-        load_u16_store_s32((uint16_t *)(src + component_gap * i), R + i, G + i, B + i);
-      }
-      for (size_t i = compw * comph - (compw * comph) % 16; i < compw * comph; ++i) {
-        R[i] = src[component_gap * i] << 8;
-        G[i] = src[component_gap * i + byte_per_sample] << 8;
-        B[i] = src[component_gap * i + 2 * byte_per_sample] << 8;
-        R[i] |= src[component_gap * i + 1];
-        G[i] |= src[component_gap * i + byte_per_sample + 1];
-        B[i] |= src[component_gap * i + 2 * byte_per_sample + 1];
+    }
+    case sample_type::U16: {
+      const uint16_t *R = get_buf<uint16_t>(0), *G = get_buf<uint16_t>(1), *B = get_buf<uint16_t>(2);
+      status = write_raster(
+          fp, len, 6,
+          [&](size_t first, size_t n, uint8_t *dst) {
+            k.pack_rgb_u16_to_big_u16(R + first, G + first, B + first, dst, n);
+          },
+          pool);
+      break;
+    }
+    default: {
+      const int32_t *R = get_buf(0), *G = get_buf(1), *B = get_buf(2);
+      const pack_rgb_fn pack = (bpp > 8) ? k.pack_rgb_s32_to_big_u16 : k.pack_rgb_s32_to_u8;
+      status = write_raster(
+          fp, len, (bpp > 8) ? 6 : 3,
+          [&](size_t first, size_t n, uint8_t *dst) { pack(R + first, G + first, B + first, dst, n); },
+          pool);
+      break;
+    }
+  }
+  return close_output(fp, filename, status);
+}
+
+int image::write_pgx(uint16_t c, const std::string &filename) const {
+  const uint8_t bpp = bits_per_pixel[c];
+  if (bpp == 0 || bpp > 32) {
+    printf("ERROR: component %d has %d bpp, PGX supports 1 - 32 bpp.\n", c, bpp);
+    return EXIT_FAILURE;
+  }
+  if (sample_types[c] == sample_type::F32) {
+    printf("ERROR: component %d holds float samples, PGX stores integers.\n", c);
+    return EXIT_FAILURE;
+  }
+  const bool issigned = is_signed[c];
+  const size_t len    = static_cast<size_t>(component_width[c]) * component_height[c];
+  char header[64];
+  snprintf(header, sizeof(header), "PG ML %c%d %u %u\n", (issigned) ? '-' : '+', bpp, component_width[c],
+           component_height[c]);
+  const size_t unit_bytes = (bpp > 16) ? 4 : (bpp > 8) ? 2 : 1;
+  instrument::stage_timer timer(instrument::stage::WRITE, strlen(header) + len * unit_bytes);
+  FILE *fp = open_output(filename, header);
+  if (fp == nullptr) {
+    return EXIT_FAILURE;
+  }
+  const kernel_table &k = get_kernels();
+  int status            = EXIT_SUCCESS;
+  switch (sample_types[c]) {
+    case sample_type::U8:
+      status = (fwrite(get_buf<uint8_t>(c), 1, len, fp) == len) ? EXIT_SUCCESS : EXIT_FAILURE;
+      break;
+    case sample_type::U16:
+      status = write_raster_16(fp, get_buf<uint16_t>(c), len, pool);
+      break;
+    case sample_type::S16: {
+      const int16_t *src = get_buf<int16_t>(c);
+      if (bpp > 8) {
+        status = write_raster_16(fp, reinterpret_cast<const uint16_t *>(src), len, pool);
+      } else {
+        status = write_raster(
+            fp, len, 1,
+            [&](size_t first, size_t n, uint8_t *dst) { k.pack_s16_to_s8(src + first, dst, n); }, pool);
       }
       break;
+    }
     default:
+      if (bpp > 16) {
+        status = write_raster_32(fp, get_buf(c), len, 4, k.pack_s32_to_big_s32, pool);
+      } else if (bpp > 8) {
+        const pack_fn pack = (issigned) ? k.pack_s32_to_big_s16 : k.pack_s32_to_big_u16;
+        status             = write_raster_32(fp, get_buf(c), len, 2, pack, pool);
+      } else {
+        const pack_fn pack = (issigned) ? k.pack_s32_to_s8 : k.pack_s32_to_u8;
+        status             = write_raster_32(fp, get_buf(c), len, 1, pack, pool);
+      }
       break;
   }
-#else
-  switch (byte_per_sample) {
-    case 1:  // <= 8bpp
-      for (size_t i = 0; i < compw * comph; ++i) {
-        R[i] = src[component_gap * i];
-        G[i] = src[component_gap * i + byte_per_sample];
-        B[i] = src[component_gap * i + 2 * byte_per_sample];
+  return close_output(fp, filename, status);
+}
+
+// interleave pixels [first, first + n) of depth planes of T into samples of 1 or 2 (big-endian) bytes
+template <class T>
+static void pack_interleaved(const T *const *src, uint16_t depth, size_t byte_per_sample, size_t first,
+                             size_t n, uint8_t *dst) {
+  for (size_t i = first; i < first + n; ++i) {
+    for (uint16_t ch = 0; ch < depth; ++ch) {
+      const uint32_t v = static_cast<uint32_t>(src[ch][i]);
+      if (byte_per_sample == 2) {
+        *dst++ = static_cast<uint8_t>(v >> 8);
+      }
+      *dst++ = static_cast<uint8_t>(v);
+    }
+  }
+}
+
+int image::write_pam(const std::string &filename) const {
+  static const char *const tupltype[4] = {"GRAYSCALE", "GRAYSCALE_ALPHA", "RGB", "RGB_ALPHA"};
+  const uint16_t depth                 = num_components;
+  if (depth == 0 || depth > 4) {
+    printf("ERROR: PAM of depth 1 - 4 is supported, the image has %d components.\n", depth);
+    return EXIT_FAILURE;
+  }
+  const uint8_t bpp = bits_per_pixel[0];
+  for (uint16_t c = 0; c < depth; ++c) {
+    if (component_width[c] != component_width[0] || component_height[c] != component_height[0]
+        || bits_per_pixel[c] != bpp || sample_types[c] != sample_types[0] || is_signed[c] || bpp > 16) {
+      printf("ERROR: components cannot be stored in PAM.\n");
+      return EXIT_FAILURE;
+    }
+  }
+  const size_t len             = static_cast<size_t>(component_width[0]) * component_height[0];
+  const size_t byte_per_sample = (bpp > 8) ? 2 : 1;
+  char header[128];
+  snprintf(header, sizeof(header), "P7\nWIDTH %u\nHEIGHT %u\nDEPTH %d\nMAXVAL %u\nTUPLTYPE %s\nENDHDR\n",
+           component_width[0], component_height[0], depth, (1U << bpp) - 1, tupltype[depth - 1]);
+  instrument::stage_timer timer(instrument::stage::WRITE, strlen(header) + depth * len * byte_per_sample);
+  FILE *fp = open_output(filename, header);
+  if (fp == nullptr) {
+    return EXIT_FAILURE;
+  }
+  const size_t unit_bytes = depth * byte_per_sample;
+  int status              = EXIT_SUCCESS;
+  switch (sample_types[0]) {
+    case sample_type::U8: {
+      const uint8_t *src[4];
+      for (uint16_t c = 0; c < depth; ++c) {
+        src[c] = get_buf<uint8_t>(c);
       }
+      status = write_raster(
+          fp, len, unit_bytes,
+          [&](size_t first, size_t n, uint8_t *dst) { pack_interleaved(src, depth, 1, first, n, dst); },
+          pool);
       break;
-    case 2:  // > 8bpp
-      for (size_t i = 0; i < compw * comph; ++i) {
-        R[i] = src[component_gap * i] << 8;
-        G[i] = src[component_gap * i + byte_per_sample] << 8;
-        B[i] = src[component_gap * i + 2 * byte_per_sample] << 8;
-        R[i] |= src[component_gap * i + 1];
-        G[i] |= src[component_gap * i + byte_per_sample + 1];
-        B[i] |= src[component_gap * i + 2 * byte_per_sample + 1];
+    }
+    case sample_type::U16: {
+      const uint16_t *src[4];
+      for (uint16_t c = 0; c < depth; ++c) {
+        src[c] = get_buf<uint16_t>(c);
       }
+      status = write_raster(
+          fp, len, unit_bytes,
+          [&](size_t first, size_t n, uint8_t *dst) { pack_interleaved(src, depth, 2, first, n, dst); },
+          pool);
       break;
-    default:
+    }
+    default: {
+      const int32_t *src[4];
+      for (uint16_t c = 0; c < depth; ++c) {
+        src[c] = get_buf(c);
+      }
+      status = write_raster(
+          fp, len, unit_bytes,
+          [&](size_t first, size_t n, uint8_t *dst) {
+            pack_interleaved(src, depth, byte_per_sample, first, n, dst);
+          },
+          pool);
       break;
+    }
   }
-#endif
-  fclose(fp);
-  return EXIT_SUCCESS;
+  return close_output(fp, filename, status);
+}
+
+int image::write_pfm(const std::string &filename) const {
+  const uint16_t ncmp = num_components;
+  if (ncmp != 1 && ncmp != 3) {
+    printf("ERROR: PFM requires 1 or 3 components, the image has %d.\n", ncmp);
+    return EXIT_FAILURE;
+  }
+  for (uint16_t c = 0; c < ncmp; ++c) {
+    if (component_width[c] != component_width[0] || component_height[c] != component_height[0]
+        || sample_types[c] != sample_type::F32) {
+      printf("ERROR: components cannot be stored in PFM.\n");
+      return EXIT_FAILURE;
+    }
+  }
+  const uint32_t w = component_width[0];
+  const uint32_t h = component_height[0];
+  const size_t len = static_cast<size_t>(w) * h;
+  char header[64];
+  snprintf(header, sizeof(header), "%s\n%u %u\n-1.0\n", (ncmp == 3) ? "PF" : "Pf", w, h);
+  instrument::stage_timer timer(instrument::stage::WRITE, strlen(header) + sizeof(float) * ncmp * len);
+  FILE *fp = open_output(filename, header);
+  if (fp == nullptr) {
+    return EXIT_FAILURE;
+  }
+  const float *src[3];
+  for (uint16_t c = 0; c < ncmp; ++c) {
+    src[c] = get_buf<float>(c);
+  }
+  // pixel i of the raster is pixel (i % w, h - 1 - i / w) of the image, stored little-endian
+  const int status = write_raster(
+      fp, len, sizeof(float) * ncmp,
+      [&](size_t first, size_t n, uint8_t *dst) {
+        size_t x = first % w;
+        size_t y = h - 1 - first / w;
+        for (size_t i = 0; i < n; ++i) {
+          for (uint16_t c = 0; c < ncmp; ++c) {
+            uint32_t u;
+            memcpy(&u, src[c] + y * w + x, sizeof(u));
+            *dst++ = static_cast<uint8_t>(u);
+            *dst++ = static_cast<uint8_t>(u >> 8);
+            *dst++ = static_cast<uint8_t>(u >> 16);
+            *dst++ = static_cast<uint8_t>(u >> 24);
+          }
+          if (++x == w) {
+            x = 0;
+            --y;
+          }
+        }
+      },
+      pool);
+  return close_output(fp, filename, status);
 }
 
 uint32_t image::get_component_width(uint16_t c) const {
@@ -309,6 +1048,13 @@ uint32_t image::get_component_height(uint16_t c) const {
   return this->component_height[c];
 }
 
+bool image::get_subsampling(uint16_t c, uint32_t &sx, uint32_t &sy) const {
+  const uint32_t w = get_component_width(c), h = get_component_height(c);
+  sx               = (w == width) ? 0 : 1;
+  sy               = (h == height) ? 0 : 1;
+  return (w == width || w == (width + 1) / 2) && (h == height || h == (height + 1) / 2);
+}
+
 uint8_t image::get_Ssiz_value(uint16_t c) const {
   return (this->is_signed[c]) ? (this->bits_per_pixel[c] - 1) | 0x80 : this->bits_per_pixel[c] - 1;
 }
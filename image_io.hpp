@@ -1,9 +1,23 @@
 #pragma once
 
+#include <exception>
+
 #include "image_io_local.hpp"
+#include "pam_io.hpp"
+#include "pfm_io.hpp"
 #include "pgm_io.hpp"
 #include "pgx_io.hpp"
-#include "ppm_io.hpp"
+#include "pnm_io.hpp"
+#include "thread_pool.hpp"
+
+// thrown by image(filenames) when a file cannot be read; index is its position in filenames
+class image_read_error : public std::exception {
+ public:
+  const size_t index;
+  const std::string filename;
+  image_read_error(size_t index, const std::string &filename) : index(index), filename(filename) {}
+  const char *what() const noexcept override { return "an image file cannot be read"; }
+};
 
 class image {
  private:
@@ -13,33 +27,98 @@ class image {
   std::vector<std::unique_ptr<image_component>> components;
   std::vector<uint32_t> component_width;
   std::vector<uint32_t> component_height;
-  // std::unique_ptr<std::unique_ptr<int32_t[]>[]> buf;
-  std::unique_ptr<unique_ptr_aligned<int32_t>[]> buf;
+  // samples of plane c are of type sample_types[c]
+  std::unique_ptr<unique_ptr_aligned<uint8_t>[]> buf;
+  std::vector<sample_type> sample_types;
   std::vector<uint8_t> bits_per_pixel;
   std::vector<bool> is_signed;
+  io_mode mode;
+  sample_storage storage;
+  plane_pool *pool;  // source of the planes and of temporary buffers, nullptr for the system allocator
+  uint8_t log2_reduction;  // the files are read box-filtered by 2^log2_reduction (see unpack_reduced())
+
+  // create the components of filenames and read them, from views if not null
+  void read_files(const std::vector<std::string> &filenames, std::vector<file_view> *views,
+                  thread_pool *workers);
+  // fill the per-component vectors and planes from components, once every file is read
+  void collect_components();
+  int decode_ppm(const file_view &fv, const std::string &filename, uint16_t compidx);
+  int decode_pam(const file_view &fv, const std::string &filename, uint16_t compidx);
+  int decode_pfm(const file_view &fv, const std::string &filename, uint16_t compidx);
+  // deinterleave len pixels of depth samples (1 or 2 big-endian bytes each) into the planes of the
+  // components compidx, ..., compidx + depth - 1
+  void unpack_interleaved(const uint8_t *src, uint16_t compidx, uint16_t depth, uint32_t byte_per_sample,
+                          size_t len);
+  // unpack_interleaved() of a raster of w x h pixels, or its box filter if the image is read reduced
+  void unpack_raster(const uint8_t *src, uint16_t compidx, uint16_t depth, uint32_t byte_per_sample,
+                     uint32_t w, uint32_t h);
+  // append the components of the window roi of filename
+  int read_window(const std::string &filename, imgformat format, const image_roi &roi);
 
  public:
-  explicit image(const std::vector<std::string> &filenames);
-  explicit image(uint32_t w, uint32_t h, uint16_t nc, uint8_t bpp, bool issigned) {
+  // planes and temporary buffers are recycled through pool if given; pool shall outlive the image
+  // several files are read concurrently on workers, or on a temporary pool if workers is null;
+  // the constructor shall not run on a task of workers; throws image_read_error
+  // a reduction of 2, 4 or 8 (PGM, PPM and PAM files only) reads thumbnails: each block of reduction x
+  // reduction pixels is averaged while unpacking, and the planes are of the reduced size
+  explicit image(const std::vector<std::string> &filenames, io_mode mode = io_mode::MMAP,
+                 sample_storage storage = sample_storage::INT32, plane_pool *pool = nullptr,
+                 thread_pool *workers = nullptr, uint32_t reduction = 1);
+  // decode files already in memory, views[i] holding filenames[i]; on the calling thread
+  explicit image(const std::vector<std::string> &filenames, std::vector<file_view> &views,
+                 sample_storage storage = sample_storage::INT32, plane_pool *pool = nullptr,
+                 uint32_t reduction = 1);
+  // read only the window roi of each file (binary PGM, PPM or PAM) with positioned reads of the column
+  // span of its rows, into planes of the size of the window; on the calling thread
+  explicit image(const std::vector<std::string> &filenames, const image_roi &roi,
+                 sample_storage storage = sample_storage::INT32, plane_pool *pool = nullptr);
+  explicit image(uint32_t w, uint32_t h, uint16_t nc, uint8_t bpp, bool issigned,
+                 sample_type type = sample_type::S32, plane_pool *pool = nullptr)
+      : mode(io_mode::MMAP), storage(sample_storage::INT32), pool(pool), log2_reduction(0) {
     width          = w;
     height         = h;
     num_components = nc;
-    this->buf      = std::make_unique<unique_ptr_aligned<int32_t>[]>(this->num_components);
+    this->buf      = std::make_unique<unique_ptr_aligned<uint8_t>[]>(this->num_components);
     for (int c = 0; c < num_components; ++c) {
       component_width.push_back(width);
       component_height.push_back(height);
       bits_per_pixel.push_back(bpp);
       is_signed.push_back(issigned);
-      this->buf[c] = aligned_uptr<int32_t>(32, width * height);
+      sample_types.push_back(type);
+      const size_t num_bytes = static_cast<size_t>(width) * height * sample_size(type);
+      this->buf[c]           = aligned_uptr<uint8_t>(32, num_bytes, pool);
     }
   }
+  // 3 components of a w x h image, planes 0 and 2 subsampled as cs (e.g. X and B of subsampled XYB)
+  explicit image(uint32_t w, uint32_t h, chroma_subsampling cs, uint8_t bpp, bool issigned,
+                 sample_type type = sample_type::S32, plane_pool *pool = nullptr);
   int read_ppm(const std::string &filename, uint16_t compidx);
+  // write component c as binary PGM (P5); the component shall be unsigned and up to 16 bpp
+  int write_pgm(uint16_t c, const std::string &filename) const;
+  // write components 0-2 as binary PPM (P6); they shall share size, bpp and sample type
+  int write_ppm(const std::string &filename) const;
+  // write component c as big-endian PGX of its bpp and signedness (1, 2 or 4 bytes per sample)
+  int write_pgx(uint16_t c, const std::string &filename) const;
+  // write every component (1 - 4: GRAYSCALE, GRAYSCALE_ALPHA, RGB or RGB_ALPHA) as PAM (P7); they shall
+  // share size, bpp and sample type, be unsigned and up to 16 bpp
+  int write_pam(const std::string &filename) const;
+  // write 3 (PF) or 1 (Pf) float components as little-endian PFM; they shall share size
+  int write_pfm(const std::string &filename) const;
   uint32_t get_width() const { return this->width; }
   uint32_t get_height() const { return this->height; }
   uint32_t get_component_width(uint16_t c) const;
   uint32_t get_component_height(uint16_t c) const;
+  // sx (sy) is 1 if plane c is halved horizontally (vertically) against the image size, rounded up, and 0
+  // if it is of the full size; returns false for planes of any other size
+  bool get_subsampling(uint16_t c, uint32_t &sx, uint32_t &sy) const;
   uint16_t get_num_components() const { return this->num_components; }
   uint8_t get_Ssiz_value(uint16_t c) const;
   uint8_t get_max_bpp() const;
-  int32_t *get_buf(uint16_t c) const { return this->buf[c].get(); }
+  sample_type get_sample_type(uint16_t c) const { return this->sample_types[c]; }
+  // T shall match get_sample_type(c)
+  template <class T = int32_t>
+  T *get_buf(uint16_t c) const {
+    assert(sample_type_of<T>::value == this->sample_types[c]);
+    return reinterpret_cast<T *>(this->buf[c].get());
+  }
 };
@@ -0,0 +1,1164 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "async_loader.hpp"
+#include "cbrt_policy.hpp"
+#include "image_io.hpp"
+#include "perf_counters.hpp"
+#include "xyb_convert.hpp"
+#include "xyb_lut3d.hpp"
+
+/********************************************************************************
+ * benchmark of the readers (also through async_loader), the SIMD kernels of
+ * every available level (including the ASCII parser of plain PGM/PPM) and the
+ * cbrt variants; every case is checked against a reference and reported with
+ * MB/s and ns/pixel of the median run after warmup runs
+ *
+ * usage: image_io_bench [-r reps] [-w warmup] [-n samples] [-s WxH]... [-only section] [-perf] [-csv]
+ *   -r     timed runs per case (default 10)
+ *   -w     untimed warmup runs per case (default 2)
+ *   -n     samples per kernel call (default 1048576)
+ *   -s     size of the synthetic reader inputs, repeatable (default 512x512 and 2048x2048)
+ *   -only  run a single section: unpack, pack, rgb2xyb, cbrt, lut3d, ascii, reader, reduce or
+ *          subsample
+ *   -perf  add hardware counters per pixel (Linux perf_event_open): cycles, IPC,
+ *          LLC, dTLB and branch misses; skipped with a note where unavailable
+ *   -csv   comma separated output
+ * returns EXIT_FAILURE if any case mismatches its reference
+ *******************************************************************************/
+
+// keep the reference loops scalar; GCC would otherwise auto-vectorize them at -O3
+#if defined(__GNUC__) && !defined(__clang__)
+  #define SCALAR_REFERENCE __attribute__((optimize("no-tree-vectorize")))
+#else
+  #define SCALAR_REFERENCE
+#endif
+
+SCALAR_REFERENCE static void scalar_u8(const uint8_t *src, int32_t *dst, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    dst[i] = src[i];
+  }
+}
+SCALAR_REFERENCE static void scalar_s8(const uint8_t *src, int32_t *dst, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    dst[i] = static_cast<int8_t>(src[i]);
+  }
+}
+SCALAR_REFERENCE static void scalar_big_u16(const uint8_t *src, int32_t *dst, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    dst[i] = (src[2 * i] << 8) | src[2 * i + 1];
+  }
+}
+SCALAR_REFERENCE static void scalar_little_u16(const uint8_t *src, int32_t *dst, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    dst[i] = src[2 * i] | (src[2 * i + 1] << 8);
+  }
+}
+SCALAR_REFERENCE static void scalar_big_s16(const uint8_t *src, int32_t *dst, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    dst[i] = static_cast<int16_t>((src[2 * i] << 8) | src[2 * i + 1]);
+  }
+}
+SCALAR_REFERENCE static void scalar_little_s16(const uint8_t *src, int32_t *dst, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    dst[i] = static_cast<int16_t>(src[2 * i] | (src[2 * i + 1] << 8));
+  }
+}
+
+SCALAR_REFERENCE static void scalar_rgb_u8(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    R[i] = src[3 * i];
+    G[i] = src[3 * i + 1];
+    B[i] = src[3 * i + 2];
+  }
+}
+SCALAR_REFERENCE static void scalar_rgb_big_u16(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B,
+                                                size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    R[i] = (src[6 * i] << 8) | src[6 * i + 1];
+    G[i] = (src[6 * i + 2] << 8) | src[6 * i + 3];
+    B[i] = (src[6 * i + 4] << 8) | src[6 * i + 5];
+  }
+}
+SCALAR_REFERENCE static void scalar_rgba_u8(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B,
+                                            int32_t *A, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    R[i] = src[4 * i];
+    G[i] = src[4 * i + 1];
+    B[i] = src[4 * i + 2];
+    A[i] = src[4 * i + 3];
+  }
+}
+SCALAR_REFERENCE static void scalar_rgba_big_u16(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B,
+                                                 int32_t *A, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    R[i] = (src[8 * i] << 8) | src[8 * i + 1];
+    G[i] = (src[8 * i + 2] << 8) | src[8 * i + 3];
+    B[i] = (src[8 * i + 4] << 8) | src[8 * i + 5];
+    A[i] = (src[8 * i + 6] << 8) | src[8 * i + 7];
+  }
+}
+
+// SIMD unpack kernels against the scalar loops above
+struct unpack_case {
+  const char *name;
+  uint32_t byte_per_sample;
+  unpack_fn scalar;
+  unpack_fn kernel_table::*simd;
+};
+
+struct unpack_rgb_case {
+  const char *name;
+  uint32_t byte_per_sample;
+  unpack_rgb_fn scalar;
+  unpack_rgb_fn kernel_table::*simd;
+};
+
+struct unpack_rgba_case {
+  const char *name;
+  uint32_t byte_per_sample;
+  unpack_rgba_fn scalar;
+  unpack_rgba_fn kernel_table::*simd;
+};
+
+// pack kernels and the narrow unpack kernels against the baseline level
+struct pack_case {
+  const char *name;
+  uint32_t byte_per_sample;
+  pack_fn kernel_table::*simd;
+};
+
+struct pack_rgb_case {
+  const char *name;
+  uint32_t byte_per_sample;
+  pack_rgb_fn kernel_table::*simd;
+};
+
+struct bench_config {
+  int reps     = 10;
+  int warmup   = 2;
+  size_t len   = 1 << 20;
+  bool csv     = false;
+  std::string only;
+  const perf_counters *counters = nullptr;  // hardware counters of the timed runs, if requested
+  std::vector<std::pair<uint32_t, uint32_t>> sizes;
+  bool enabled(const char *section) const { return only.empty() || only == section; }
+};
+
+// kernel tables of the available levels, baseline first
+using level_list = std::vector<const kernel_table *>;
+
+// seconds per run
+struct timing {
+  double min;
+  double median;
+  double max;
+  double cv;           // standard deviation / mean
+  perf_sample events;  // sum over the timed runs
+  int reps;
+};
+
+// cfg.warmup untimed runs of fn() followed by cfg.reps timed runs
+template <class F>
+static timing measure(F &&fn, const bench_config &cfg) {
+  const int reps = cfg.reps;
+  for (int r = 0; r < cfg.warmup; ++r) {
+    fn();
+  }
+  perf_sample events;
+  std::vector<double> sec(static_cast<size_t>(reps));
+  for (auto &s : sec) {
+    const perf_sample before = (cfg.counters) ? cfg.counters->read() : perf_sample();
+    auto start               = std::chrono::high_resolution_clock::now();
+    fn();
+    auto duration = std::chrono::high_resolution_clock::now() - start;
+    s             = std::chrono::duration<double>(duration).count();
+    if (cfg.counters) {
+      events += cfg.counters->read() - before;
+    }
+  }
+  std::sort(sec.begin(), sec.end());
+  double mean = 0.0, var = 0.0;
+  for (double s : sec) {
+    mean += s / reps;
+  }
+  for (double s : sec) {
+    var += (s - mean) * (s - mean) / reps;
+  }
+  const size_t mid = sec.size() / 2;
+  timing t;
+  t.min    = sec.front();
+  t.max    = sec.back();
+  t.median = (sec.size() % 2) ? sec[mid] : (sec[mid - 1] + sec[mid]) / 2;
+  t.cv     = (mean > 0.0) ? std::sqrt(var) / mean : 0.0;
+  t.events = events;
+  t.reps   = reps;
+  return t;
+}
+
+class reporter {
+ private:
+  bool csv;
+  const perf_counters *counters;  // adds the hardware counter columns if not null
+  int status;
+
+  // cycles/px, IPC, LLC misses/px, dTLB misses/px and branch misses/px; "-" if unavailable
+  void perf_columns(const timing &t, size_t pixels) const {
+    const double runs_px = static_cast<double>(t.reps) * pixels;
+    auto per_px          = [&](perf_event e, const char *fmt) {
+      if (counters->available(e)) {
+        printf(fmt, t.events[e] / runs_px);
+      } else {
+        printf((csv) ? ",-" : " %9s", "-");
+      }
+    };
+    per_px(perf_event::CYCLES, (csv) ? ",%.3f" : " %9.3f");
+    if (counters->available(perf_event::CYCLES) && counters->available(perf_event::INSTRUCTIONS)
+        && t.events[perf_event::CYCLES]) {
+      printf((csv) ? ",%.2f" : " %6.2f",
+             static_cast<double>(t.events[perf_event::INSTRUCTIONS]) / t.events[perf_event::CYCLES]);
+    } else {
+      printf((csv) ? ",-" : " %6s", "-");
+    }
+    per_px(perf_event::LLC_MISSES, (csv) ? ",%.5f" : " %9.5f");
+    per_px(perf_event::DTLB_MISSES, (csv) ? ",%.5f" : " %9.5f");
+    per_px(perf_event::BRANCH_MISSES, (csv) ? ",%.5f" : " %9.5f");
+  }
+
+ public:
+  reporter(bool csv, const perf_counters *counters) : csv(csv), counters(counters), status(EXIT_SUCCESS) {
+    if (csv) {
+      printf("section,case,level,mb_per_s,ns_per_px,median_ms,min_ms,max_ms,cv_pct,speedup,match%s\n",
+             (counters) ? ",cycles_per_px,ipc,llc_miss_per_px,dtlb_miss_per_px,branch_miss_per_px" : "");
+    }
+  }
+  void section(const char *title) const {
+    if (!csv) {
+      printf("\n[%s]\n%-42s %-7s %10s %9s %10s %10s %10s %6s %8s", title, "case", "level", "MB/s", "ns/px",
+             "median ms", "min ms", "max ms", "cv %", "speedup");
+      if (counters) {
+        printf(" %9s %6s %9s %9s %9s", "cyc/px", "IPC", "LLC/px", "dTLB/px", "brmis/px");
+      }
+      printf("\n");
+    }
+  }
+  // bytes and pixels processed per run; speedup against the median `ref` of the reference run
+  void row(const char *section, const std::string &name, const char *level, const timing &t, size_t bytes,
+           size_t pixels, double ref, bool match) {
+    const double mbps = bytes / t.median / 1.0e6;
+    const double nspx = t.median * 1.0e9 / pixels;
+    if (csv) {
+      printf("%s,%s,%s,%.1f,%.3f,%.3f,%.3f,%.3f,%.1f,%.2f,%d", section, name.c_str(), level, mbps, nspx,
+             t.median * 1e3, t.min * 1e3, t.max * 1e3, t.cv * 100, ref / t.median, match);
+    } else {
+      printf("%-42s %-7s %10.1f %9.3f %10.3f %10.3f %10.3f %6.1f %7.2fx", name.c_str(), level, mbps, nspx,
+             t.median * 1e3, t.min * 1e3, t.max * 1e3, t.cv * 100, ref / t.median);
+    }
+    if (counters) {
+      perf_columns(t, pixels);
+    }
+    printf("%s\n", (match || csv) ? "" : " MISMATCH");
+    if (!match) {
+      status = EXIT_FAILURE;
+    }
+  }
+  int get_status() const { return status; }
+};
+
+// time run(k) on every level; check() compares the output of the last run with the reference
+template <class Run, class Check>
+static void run_levels(reporter &rep, const bench_config &cfg, const level_list &levels,
+                       const char *section, const std::string &name, size_t bytes, size_t pixels,
+                       double ref, Run &&run, Check &&check) {
+  for (const auto *k : levels) {
+    timing t = measure([&] { run(k); }, cfg);
+    rep.row(section, name, simd_level_name(k->level), t, bytes, pixels, ref, check());
+  }
+}
+
+static void bench_unpack(reporter &rep, const bench_config &cfg, const level_list &levels,
+                         std::mt19937 &rng) {
+  const std::vector<unpack_case> cases = {
+      {"u8 (PGM/PGX)", 1, scalar_u8, &kernel_table::unpack_u8_to_s32},
+      {"s8 (PGX)", 1, scalar_s8, &kernel_table::unpack_s8_to_s32},
+      {"big u16 (PGM/PGX)", 2, scalar_big_u16, &kernel_table::unpack_big_u16_to_s32},
+      {"little u16 (PGX)", 2, scalar_little_u16, &kernel_table::unpack_little_u16_to_s32},
+      {"big s16 (PGX)", 2, scalar_big_s16, &kernel_table::unpack_big_s16_to_s32},
+      {"little s16 (PGX)", 2, scalar_little_s16, &kernel_table::unpack_little_s16_to_s32},
+  };
+  const std::vector<unpack_rgb_case> rgb_cases = {
+      {"rgb u8 (PPM)", 1, scalar_rgb_u8, &kernel_table::unpack_rgb_u8_to_s32},
+      {"rgb big u16 (PPM)", 2, scalar_rgb_big_u16, &kernel_table::unpack_rgb_big_u16_to_s32},
+  };
+  const std::vector<unpack_rgba_case> rgba_cases = {
+      {"rgba u8 (PAM)", 1, scalar_rgba_u8, &kernel_table::unpack_rgba_u8_to_s32},
+      {"rgba big u16 (PAM)", 2, scalar_rgba_big_u16, &kernel_table::unpack_rgba_big_u16_to_s32},
+  };
+  const size_t len = cfg.len;
+  std::vector<uint8_t> src(8 * len);
+  for (auto &v : src) {
+    v = static_cast<uint8_t>(rng());
+  }
+  // output of the reference and of the kernel under test, large enough for four int32 planes
+  auto ref = aligned_uptr<uint8_t>(64, 16 * len);
+  auto dst = aligned_uptr<uint8_t>(64, 16 * len);
+  auto ref32 = reinterpret_cast<int32_t *>(ref.get());
+  auto dst32 = reinterpret_cast<int32_t *>(dst.get());
+
+  rep.section("unpack");
+  for (const auto &c : cases) {
+    const size_t bytes = len * c.byte_per_sample;
+    timing t           = measure([&] { c.scalar(src.data(), ref32, len); }, cfg);
+    rep.row("unpack", c.name, "loop", t, bytes, len, t.median, true);
+    run_levels(
+        rep, cfg, levels, "unpack", c.name, bytes, len, t.median,
+        [&](const kernel_table *k) { (k->*c.simd)(src.data(), dst32, len); },
+        [&] { return memcmp(ref32, dst32, len * sizeof(int32_t)) == 0; });
+  }
+  for (const auto &c : rgb_cases) {
+    const size_t bytes = 3 * len * c.byte_per_sample;
+    timing t = measure([&] { c.scalar(src.data(), ref32, ref32 + len, ref32 + 2 * len, len); }, cfg);
+    rep.row("unpack", c.name, "loop", t, bytes, len, t.median, true);
+    run_levels(
+        rep, cfg, levels, "unpack", c.name, bytes, len, t.median,
+        [&](const kernel_table *k) { (k->*c.simd)(src.data(), dst32, dst32 + len, dst32 + 2 * len, len); },
+        [&] { return memcmp(ref32, dst32, 3 * len * sizeof(int32_t)) == 0; });
+  }
+  for (const auto &c : rgba_cases) {
+    const size_t bytes = 4 * len * c.byte_per_sample;
+    timing t = measure(
+        [&] { c.scalar(src.data(), ref32, ref32 + len, ref32 + 2 * len, ref32 + 3 * len, len); }, cfg);
+    rep.row("unpack", c.name, "loop", t, bytes, len, t.median, true);
+    run_levels(
+        rep, cfg, levels, "unpack", c.name, bytes, len, t.median,
+        [&](const kernel_table *k) {
+          (k->*c.simd)(src.data(), dst32, dst32 + len, dst32 + 2 * len, dst32 + 3 * len, len);
+        },
+        [&] { return memcmp(ref32, dst32, 4 * len * sizeof(int32_t)) == 0; });
+  }
+
+  // narrow planes; the baseline level is the reference
+  const kernel_table *base = levels.front();
+  struct narrow_case {
+    const char *name;
+    size_t bytes;      // input bytes
+    size_t out_bytes;  // output bytes
+    void (*run)(const kernel_table *, const uint8_t *, uint8_t *, size_t);
+  };
+  const std::vector<narrow_case> narrow_cases = {
+      {"s8 -> s16 (PGX)", len, 2 * len,
+       [](const kernel_table *k, const uint8_t *s, uint8_t *d, size_t n) {
+         k->unpack_s8_to_s16(s, reinterpret_cast<int16_t *>(d), n);
+       }},
+      {"big 16 -> 16 (PGM/PGX)", 2 * len, 2 * len,
+       [](const kernel_table *k, const uint8_t *s, uint8_t *d, size_t n) {
+         k->unpack_big_16_to_16(s, reinterpret_cast<uint16_t *>(d), n);
+       }},
+      {"rgb u8 -> u8 (PPM)", 3 * len, 3 * len,
+       [](const kernel_table *k, const uint8_t *s, uint8_t *d, size_t n) {
+         k->unpack_rgb_u8_to_u8(s, d, d + n, d + 2 * n, n);
+       }},
+      {"rgb big u16 -> u16 (PPM)", 6 * len, 6 * len,
+       [](const kernel_table *k, const uint8_t *s, uint8_t *d, size_t n) {
+         uint16_t *d16 = reinterpret_cast<uint16_t *>(d);
+         k->unpack_rgb_big_u16_to_u16(s, d16, d16 + n, d16 + 2 * n, n);
+       }},
+      {"rgba u8 -> u8 (PAM)", 4 * len, 4 * len,
+       [](const kernel_table *k, const uint8_t *s, uint8_t *d, size_t n) {
+         k->unpack_rgba_u8_to_u8(s, d, d + n, d + 2 * n, d + 3 * n, n);
+       }},
+      {"rgba big u16 -> u16 (PAM)", 8 * len, 8 * len,
+       [](const kernel_table *k, const uint8_t *s, uint8_t *d, size_t n) {
+         uint16_t *d16 = reinterpret_cast<uint16_t *>(d);
+         k->unpack_rgba_big_u16_to_u16(s, d16, d16 + n, d16 + 2 * n, d16 + 3 * n, n);
+       }},
+  };
+  for (const auto &c : narrow_cases) {
+    timing t = measure([&] { c.run(base, src.data(), ref.get(), len); }, cfg);
+    run_levels(
+        rep, cfg, levels, "unpack", c.name, c.bytes, len, t.median,
+        [&](const kernel_table *k) { c.run(k, src.data(), dst.get(), len); },
+        [&] { return memcmp(ref.get(), dst.get(), c.out_bytes) == 0; });
+  }
+}
+
+static void bench_pack(reporter &rep, const bench_config &cfg, const level_list &levels,
+                       std::mt19937 &rng) {
+  const std::vector<pack_case> cases = {
+      {"u8 (PGM/PGX)", 1, &kernel_table::pack_s32_to_u8},
+      {"s8 (PGX)", 1, &kernel_table::pack_s32_to_s8},
+      {"big u16 (PGM/PGX)", 2, &kernel_table::pack_s32_to_big_u16},
+      {"big s16 (PGX)", 2, &kernel_table::pack_s32_to_big_s16},
+      {"big s32 (PGX)", 4, &kernel_table::pack_s32_to_big_s32},
+  };
+  const std::vector<pack_rgb_case> rgb_cases = {
+      {"rgb u8 (PPM)", 1, &kernel_table::pack_rgb_s32_to_u8},
+      {"rgb big u16 (PPM)", 2, &kernel_table::pack_rgb_s32_to_big_u16},
+  };
+  const size_t len = cfg.len;
+  // 16-bit samples with out-of-range values on both sides
+  auto src = aligned_uptr<int32_t>(64, 3 * len);
+  for (size_t i = 0; i < 3 * len; ++i) {
+    src.get()[i] = static_cast<int32_t>(rng() & 0x1FFFF) - 0x8000;
+  }
+  const int32_t *const plane[3] = {src.get(), src.get() + len, src.get() + 2 * len};
+  std::vector<uint8_t> ref(12 * len), dst(12 * len);
+  const kernel_table *base = levels.front();
+
+  rep.section("pack");
+  for (const auto &c : cases) {
+    const size_t bytes = len * c.byte_per_sample;
+    timing t = measure([&] { (base->*c.simd)(src.get(), ref.data(), len); }, cfg);
+    run_levels(
+        rep, cfg, levels, "pack", c.name, bytes, len, t.median,
+        [&](const kernel_table *k) { (k->*c.simd)(src.get(), dst.data(), len); },
+        [&] { return memcmp(ref.data(), dst.data(), bytes) == 0; });
+  }
+  for (const auto &c : rgb_cases) {
+    const size_t bytes = 3 * len * c.byte_per_sample;
+    timing t = measure([&] { (base->*c.simd)(plane[0], plane[1], plane[2], ref.data(), len); }, cfg);
+    run_levels(
+        rep, cfg, levels, "pack", c.name, bytes, len, t.median,
+        [&](const kernel_table *k) { (k->*c.simd)(plane[0], plane[1], plane[2], dst.data(), len); },
+        [&] { return memcmp(ref.data(), dst.data(), bytes) == 0; });
+  }
+
+  // PGX deeper than 16 bits (e.g. the XYB output) written and read back: 4-byte samples both ways
+  std::error_code ec;
+  const auto path = std::filesystem::temp_directory_path(ec) / "image_io_bench_pack.pgx";
+  if (ec) {
+    return;
+  }
+  const simd_level active = get_simd_level();
+  const uint32_t w        = 1024;
+  const uint32_t h        = static_cast<uint32_t>(std::max<size_t>(1, len / w));
+  const size_t num        = static_cast<size_t>(w) * h;
+  for (const auto &depth : {std::make_pair(17, false), std::make_pair(24, true), std::make_pair(31, false),
+                            std::make_pair(32, true)}) {
+    const int bpp       = depth.first;
+    const bool issigned = depth.second;
+    image img(w, h, 1, static_cast<uint8_t>(bpp), issigned);
+    const uint32_t mask = (bpp == 32) ? 0xFFFFFFFFU : (1U << bpp) - 1;
+    for (size_t i = 0; i < num; ++i) {
+      const uint32_t v   = rng() & mask;
+      img.get_buf(0)[i] = (issigned && bpp < 32) ? static_cast<int32_t>(v << (32 - bpp)) >> (32 - bpp)
+                                                 : static_cast<int32_t>(v);
+    }
+    const std::string name = std::string("pgx ") + (issigned ? "s" : "u") + std::to_string(bpp)
+                             + " write + read";
+    double ref = 0.0;
+    for (const auto *k : levels) {
+      set_simd_level(k->level);
+      timing t = measure(
+          [&] {
+            img.write_pgx(0, path.string());
+            image back({path.string()});
+          },
+          cfg);
+      if (ref == 0.0) {
+        ref = t.median;
+      }
+      bool match = img.write_pgx(0, path.string()) == EXIT_SUCCESS;
+      if (match) {
+        image back({path.string()});
+        match = back.get_component_width(0) == w && back.get_component_height(0) == h
+                && memcmp(back.get_buf(0), img.get_buf(0), num * sizeof(int32_t)) == 0;
+      }
+      rep.row("pack", name, simd_level_name(k->level), t, 2 * num * 4, num, ref, match);
+    }
+  }
+  std::filesystem::remove(path, ec);
+  set_simd_level(active);
+}
+
+static void bench_rgb2xyb(reporter &rep, const bench_config &cfg, const level_list &levels,
+                          std::mt19937 &rng) {
+  const size_t len         = cfg.len;
+  const kernel_table *base = levels.front();
+  auto rgb                 = aligned_uptr<int32_t>(64, 3 * len);
+  auto rgb16               = aligned_uptr<uint16_t>(64, 3 * len);
+  auto rgb8                = aligned_uptr<uint8_t>(64, 3 * len);
+  auto ref                 = aligned_uptr<int32_t>(64, 3 * len);
+  auto dst                 = aligned_uptr<int32_t>(64, 3 * len);
+  int32_t *const ref_plane[3] = {ref.get(), ref.get() + len, ref.get() + 2 * len};
+  int32_t *const dst_plane[3] = {dst.get(), dst.get() + len, dst.get() + 2 * len};
+  const int32_t *const p32[3] = {rgb.get(), rgb.get() + len, rgb.get() + 2 * len};
+  const uint16_t *const p16[3] = {rgb16.get(), rgb16.get() + len, rgb16.get() + 2 * len};
+  const uint8_t *const p8[3]   = {rgb8.get(), rgb8.get() + len, rgb8.get() + 2 * len};
+
+  // the baseline kernel on int32 planes is the reference of every plane type
+  rep.section("rgb2xyb");
+  for (const int bpp : {8, 10, 12, 16}) {
+    for (size_t i = 0; i < 3 * len; ++i) {
+      rgb.get()[i]   = static_cast<int32_t>(rng() & ((1U << bpp) - 1));
+      rgb16.get()[i] = static_cast<uint16_t>(rgb.get()[i]);
+      rgb8.get()[i]  = static_cast<uint8_t>(rgb.get()[i]);
+    }
+    xyb_stats ref_stats, dst_stats;
+    timing t = measure(
+        [&] {
+          base->rgb2xyb(p32[0], p32[1], p32[2], ref_plane[0], ref_plane[1], ref_plane[2], len, bpp,
+                        ref_stats);
+        },
+        cfg);
+    auto check = [&] {
+      return memcmp(ref.get(), dst.get(), 3 * len * sizeof(int32_t)) == 0
+             && memcmp(&ref_stats, &dst_stats, sizeof(xyb_stats)) == 0;
+    };
+    const size_t bytes = 3 * len * sizeof(int32_t);
+    run_levels(
+        rep, cfg, levels, "rgb2xyb", "i32 planes, " + std::to_string(bpp) + " bpp", bytes, len, t.median,
+        [&](const kernel_table *k) {
+          k->rgb2xyb(p32[0], p32[1], p32[2], dst_plane[0], dst_plane[1], dst_plane[2], len, bpp, dst_stats);
+        },
+        check);
+    run_levels(
+        rep, cfg, levels, "rgb2xyb", "u16 planes, " + std::to_string(bpp) + " bpp", 3 * len * 2, len,
+        t.median,
+        [&](const kernel_table *k) {
+          k->rgb2xyb_u16(p16[0], p16[1], p16[2], dst_plane[0], dst_plane[1], dst_plane[2], len, bpp,
+                         dst_stats);
+        },
+        check);
+    if (bpp <= 8) {
+      run_levels(
+          rep, cfg, levels, "rgb2xyb", "u8 planes, " + std::to_string(bpp) + " bpp", 3 * len, len, t.median,
+          [&](const kernel_table *k) {
+            k->rgb2xyb_u8(p8[0], p8[1], p8[2], dst_plane[0], dst_plane[1], dst_plane[2], len, bpp,
+                          dst_stats);
+          },
+          check);
+    }
+
+    // the same conversions with the polynomial cube root, against its scalar kernel
+    base->rgb2xyb_poly(p32[0], p32[1], p32[2], ref_plane[0], ref_plane[1], ref_plane[2], len, bpp,
+                       ref_stats);
+    run_levels(
+        rep, cfg, levels, "rgb2xyb", "i32 planes, " + std::to_string(bpp) + " bpp, poly", bytes, len,
+        t.median,
+        [&](const kernel_table *k) {
+          k->rgb2xyb_poly(p32[0], p32[1], p32[2], dst_plane[0], dst_plane[1], dst_plane[2], len, bpp,
+                          dst_stats);
+        },
+        check);
+    run_levels(
+        rep, cfg, levels, "rgb2xyb", "u16 planes, " + std::to_string(bpp) + " bpp, poly", 3 * len * 2, len,
+        t.median,
+        [&](const kernel_table *k) {
+          k->rgb2xyb_u16_poly(p16[0], p16[1], p16[2], dst_plane[0], dst_plane[1], dst_plane[2], len, bpp,
+                              dst_stats);
+        },
+        check);
+    if (bpp <= 8) {
+      run_levels(
+          rep, cfg, levels, "rgb2xyb", "u8 planes, " + std::to_string(bpp) + " bpp, poly", 3 * len, len,
+          t.median,
+          [&](const kernel_table *k) {
+            k->rgb2xyb_u8_poly(p8[0], p8[1], p8[2], dst_plane[0], dst_plane[1], dst_plane[2], len, bpp,
+                               dst_stats);
+          },
+          check);
+    }
+  }
+}
+
+// cube-root policies of cbrt_policy.hpp: the root alone over random Q16 inputs, with its error against
+// the correctly rounded root over the whole input range, then rgb2xyb on 16-bit planes with the error of
+// X, Y and B against cbrt_exact; LUT256 (the SIMD kernels) is the reference for the speedup
+template <class Cbrt>
+static i32 cbrt_eval(ui16 n) {
+  return Cbrt::eval(n);
+}
+
+static void bench_cbrt(reporter &rep, const bench_config &cfg, std::mt19937 &rng) {
+  struct cbrt_case {
+    cbrt_method method;
+    i32 (*fn)(ui16);
+  };
+  const std::vector<cbrt_case> cases = {
+      {cbrt_method::LUT256, cbrt_eval<cbrt_lut256>},   {cbrt_method::LUT1024, cbrt_eval<cbrt_lut1024>},
+      {cbrt_method::NEWTON16, cbrt_eval<cbrt_newton16>}, {cbrt_method::NEWTON32, cbrt_eval<cbrt_newton32>},
+      {cbrt_method::EXACT, cbrt_eval<cbrt_exact>},     {cbrt_method::POLY, cbrt_eval<cbrt_polynomial>},
+  };
+  const size_t len = cfg.len;
+  std::vector<ui16> src(len);
+  for (auto &v : src) {
+    v = static_cast<ui16>(rng());
+  }
+  std::vector<i32> dst(len);
+  rep.section("cbrt");
+  double ref = 0.0;
+  for (const auto &c : cases) {
+    timing t = measure(
+        [&] {
+          for (size_t i = 0; i < len; ++i) {
+            dst[i] = c.fn(src[i]);
+          }
+        },
+        cfg);
+    if (ref == 0.0) {
+      ref = t.median;
+    }
+    // deviation from the correctly rounded root over the whole input range
+    i32 err     = 0;
+    double mean = 0.0;
+    for (ui32 n = 0; n < 65536; ++n) {
+      const i32 exact = static_cast<i32>(std::lround(std::cbrt(n / 65535.0) * 65535.0));
+      const i32 e     = std::abs(c.fn(static_cast<ui16>(n)) - exact);
+      err             = std::max(err, e);
+      mean += e;
+    }
+    char name[96];
+    snprintf(name, sizeof(name), "%s, err max %d mean %.3f", cbrt_method_name(c.method), err,
+             mean / 65536);
+    // the polynomial is within 1 of every rounded root and of the nodes of tbl_cbrt (see cbrt_poly_fix.hpp)
+    const bool bound = (c.method != cbrt_method::POLY) || (err <= 1 && cbrt_poly_matches_tbl(1));
+    rep.row("cbrt", name, "scalar", t, len * sizeof(ui16), len, ref, bound);
+  }
+
+  // whole conversions of 16-bit planes
+  auto rgb = aligned_uptr<uint16_t>(64, 3 * len);
+  auto xyb = aligned_uptr<int32_t>(64, 6 * len);
+  for (size_t i = 0; i < 3 * len; ++i) {
+    rgb.get()[i] = static_cast<uint16_t>(rng());
+  }
+  const uint16_t *const p16[3] = {rgb.get(), rgb.get() + len, rgb.get() + 2 * len};
+  int32_t *const exact[3]      = {xyb.get(), xyb.get() + len, xyb.get() + 2 * len};
+  int32_t *const out[3]        = {xyb.get() + 3 * len, xyb.get() + 4 * len, xyb.get() + 5 * len};
+  xyb_stats stats;
+  const xyb_kernels ek = get_xyb_kernels(cbrt_method::EXACT, 16);
+  ek.u16(p16[0], p16[1], p16[2], exact[0], exact[1], exact[2], len, 16, stats);
+  ref = 0.0;
+  for (const auto &c : cases) {
+    const xyb_kernels k = get_xyb_kernels(c.method, 16);
+    timing t = measure([&] { k.u16(p16[0], p16[1], p16[2], out[0], out[1], out[2], len, 16, stats); }, cfg);
+    if (ref == 0.0) {
+      ref = t.median;
+    }
+    i32 err     = 0;
+    double mean = 0.0;
+    for (size_t i = 0; i < 3 * len; ++i) {
+      const i32 e = std::abs(out[0][i] - exact[0][i]);
+      err         = std::max(err, e);
+      mean += e;
+    }
+    char name[96];
+    snprintf(name, sizeof(name), "rgb2xyb %s, err max %d mean %.3f", cbrt_method_name(c.method), err,
+             mean / (3 * len));
+    const bool simd   = (c.method == cbrt_method::LUT256 || c.method == cbrt_method::POLY);
+    const char *level = simd ? simd_level_name(get_simd_level()) : "scalar";
+    rep.row("cbrt", name, level, t, 3 * len * sizeof(uint16_t), len, ref, true);
+  }
+}
+
+// 3D LUT engine of xyb_lut3d.hpp on 8- and 10-bit planes: every level against the scalar kernel (outputs
+// and statistics), the scalar kernel against rgb2xyb with cbrt_exact and the documented bound of its error
+// (over every RGB triple at 8 bpp, the random planes at 10 bpp), the SIMD pipeline is the speed reference
+static void bench_lut3d(reporter &rep, const bench_config &cfg, const level_list &levels,
+                        std::mt19937 &rng) {
+  const size_t len         = cfg.len;
+  const kernel_table *base = levels.front();
+  const kernel_table *best = levels.back();
+  const xyb_kernels ek     = get_xyb_kernels(cbrt_method::EXACT, 16);
+  auto rgb16               = aligned_uptr<uint16_t>(64, 3 * len);
+  auto rgb8                = aligned_uptr<uint8_t>(64, 3 * len);
+  auto xyb                 = aligned_uptr<int32_t>(64, 9 * len);
+  const uint16_t *const p16[3] = {rgb16.get(), rgb16.get() + len, rgb16.get() + 2 * len};
+  const uint8_t *const p8[3]   = {rgb8.get(), rgb8.get() + len, rgb8.get() + 2 * len};
+  int32_t *const ref[3]        = {xyb.get(), xyb.get() + len, xyb.get() + 2 * len};
+  int32_t *const dst[3]        = {xyb.get() + 3 * len, xyb.get() + 4 * len, xyb.get() + 5 * len};
+  int32_t *const exact[3]      = {xyb.get() + 6 * len, xyb.get() + 7 * len, xyb.get() + 8 * len};
+
+  // largest difference of the scalar kernel from cbrt_exact in X, Y and B over n pixels of p16
+  auto max_error = [&](const xyb_lut3d &lut, size_t n, i32 err[3]) {
+    xyb_stats s;
+    base->rgb2xyb_u16_lut3d(lut, p16[0], p16[1], p16[2], ref[0], ref[1], ref[2], n, nullptr);
+    ek.u16(p16[0], p16[1], p16[2], exact[0], exact[1], exact[2], n, lut.bpp, s);
+    for (int c = 0; c < 3; ++c) {
+      for (size_t i = 0; i < n; ++i) {
+        err[c] = std::max(err[c], std::abs(ref[c][i] - exact[c][i]));
+      }
+    }
+  };
+
+  rep.section("lut3d");
+  for (const int bpp : {8, 10}) {
+    for (const i32 grid : {17, 33}) {
+      const xyb_lut3d &lut = get_xyb_lut3d(grid, bpp);
+      i32 err[3]           = {0, 0, 0};
+      if (bpp == 8 && len >= 65536) {
+        // every RGB triple, 65536 per call
+        for (ui32 b = 0; b < 256; ++b) {
+          for (ui32 i = 0; i < 65536; ++i) {
+            rgb16.get()[i]           = static_cast<uint16_t>(i & 0xFF);
+            rgb16.get()[len + i]     = static_cast<uint16_t>(i >> 8);
+            rgb16.get()[2 * len + i] = static_cast<uint16_t>(b);
+          }
+          max_error(lut, 65536, err);
+        }
+      }
+      for (size_t i = 0; i < 3 * len; ++i) {
+        rgb16.get()[i] = static_cast<uint16_t>(rng() & ((1U << bpp) - 1));
+        rgb8.get()[i]  = static_cast<uint8_t>(rgb16.get()[i]);
+      }
+      max_error(lut, len, err);
+      bool bound = true;
+      for (int c = 0; c < 3; ++c) {
+        bound = bound && err[c] <= lut3d_error_bound(grid, bpp, c);
+      }
+
+      // the pipeline of the best level, whose statistics the engine shall reproduce
+      xyb_stats ref_stats, dst_stats;
+      timing t = measure(
+          [&] {
+            best->rgb2xyb_u16(p16[0], p16[1], p16[2], exact[0], exact[1], exact[2], len, bpp, ref_stats);
+          },
+          cfg);
+      const std::string planes = std::to_string(bpp) + " bpp, " + std::to_string(grid) + "^3";
+      rep.row("lut3d", "u16 planes, " + std::to_string(bpp) + " bpp, pipeline",
+              simd_level_name(best->level), t, 3 * len * 2, len, t.median, true);
+      base->rgb2xyb_u16_lut3d(lut, p16[0], p16[1], p16[2], ref[0], ref[1], ref[2], len, &dst_stats);
+      auto check = [&] {
+        return memcmp(ref[0], dst[0], 3 * len * sizeof(int32_t)) == 0
+               && memcmp(&ref_stats, &dst_stats, sizeof(xyb_stats)) == 0;
+      };
+      char name[96];
+      snprintf(name, sizeof(name), "u16 planes, %s, err %d %d %d", planes.c_str(), err[0], err[1], err[2]);
+      run_levels(
+          rep, cfg, levels, "lut3d", name, 3 * len * 2, len, t.median,
+          [&](const kernel_table *k) {
+            k->rgb2xyb_u16_lut3d(lut, p16[0], p16[1], p16[2], dst[0], dst[1], dst[2], len, &dst_stats);
+          },
+          [&] { return bound && check(); });
+      // without statistics (e.g. the batch mode): the matrix stage is skipped
+      run_levels(
+          rep, cfg, levels, "lut3d", "u16 planes, " + planes + ", no stats", 3 * len * 2, len, t.median,
+          [&](const kernel_table *k) {
+            k->rgb2xyb_u16_lut3d(lut, p16[0], p16[1], p16[2], dst[0], dst[1], dst[2], len, nullptr);
+          },
+          [&] { return memcmp(ref[0], dst[0], 3 * len * sizeof(int32_t)) == 0; });
+      if (bpp <= 8) {
+        run_levels(
+            rep, cfg, levels, "lut3d", "u8 planes, " + planes, 3 * len, len, t.median,
+            [&](const kernel_table *k) {
+              k->rgb2xyb_u8_lut3d(lut, p8[0], p8[1], p8[2], dst[0], dst[1], dst[2], len, &dst_stats);
+            },
+            check);
+      }
+    }
+  }
+}
+
+// plain (ASCII) PGM/PPM samples in lines of up to 70 characters as pnmtoplainpnm writes them: every level
+// against strtoul() over the same text, MB/s of text
+SCALAR_REFERENCE static size_t scalar_ascii(const char *text, uint8_t *dst, size_t num, bool wide) {
+  char *end = const_cast<char *>(text);
+  size_t n  = 0;
+  for (; n < num; ++n) {
+    const unsigned long v = strtoul(end, &end, 10);
+    if (wide) {
+      dst[2 * n]     = static_cast<uint8_t>(v >> 8);
+      dst[2 * n + 1] = static_cast<uint8_t>(v);
+    } else {
+      dst[n] = static_cast<uint8_t>(v);
+    }
+  }
+  return n;
+}
+
+static void bench_ascii(reporter &rep, const bench_config &cfg, const level_list &levels,
+                        std::mt19937 &rng) {
+  const size_t len = cfg.len;
+  auto ref         = aligned_uptr<uint8_t>(64, 2 * len);
+  auto dst         = aligned_uptr<uint8_t>(64, 2 * len);
+
+  rep.section("ascii");
+  for (const uint32_t maxval : {255U, 1023U, 65535U}) {
+    const bool wide = maxval > 255;
+    std::string text;
+    size_t column = 0;
+    for (size_t i = 0; i < len; ++i) {
+      const std::string v = std::to_string(rng() % (maxval + 1));
+      if (column + v.size() + 1 > 70) {
+        text += '\n';
+        column = 0;
+      } else if (column > 0) {
+        text += ' ';
+        ++column;
+      }
+      text += v;
+      column += v.size();
+    }
+    text += '\n';
+    const auto *src  = reinterpret_cast<const uint8_t *>(text.data());
+    const size_t out = len * (wide ? 2 : 1);
+    const auto name  = "maxval " + std::to_string(maxval) + (wide ? " -> big u16" : " -> u8");
+    size_t num       = 0;
+    size_t used      = 0;
+    timing t         = measure([&] { scalar_ascii(text.c_str(), ref.get(), len, wide); }, cfg);
+    rep.row("ascii", name, "strtoul", t, text.size(), len, t.median, true);
+    parse_ascii_fn kernel_table::*parse =
+        (wide) ? &kernel_table::parse_ascii_big_u16 : &kernel_table::parse_ascii_u8;
+    run_levels(
+        rep, cfg, levels, "ascii", name, text.size(), len, t.median,
+        [&](const kernel_table *k) {
+          num = (k->*parse)(src, text.size(), dst.get(), len, maxval, used);
+        },
+        [&] { return num == len && used == text.size() - 1 && memcmp(ref.get(), dst.get(), out) == 0; });
+  }
+}
+
+static int32_t sample_at(const image &img, uint16_t c, size_t i) {
+  switch (img.get_sample_type(c)) {
+    case sample_type::U8:
+      return img.get_buf<uint8_t>(c)[i];
+    case sample_type::U16:
+      return img.get_buf<uint16_t>(c)[i];
+    case sample_type::S16:
+      return img.get_buf<int16_t>(c)[i];
+    default:
+      return img.get_buf(c)[i];
+  }
+}
+
+// whole-file reads of synthetic PGM/PPM/PGX/PAM (RGBA) files written to a temporary directory
+static int bench_reader(reporter &rep, const bench_config &cfg, const level_list &levels,
+                        std::mt19937 &rng) {
+  struct reader_case {
+    imgformat format;
+    uint8_t bpp;
+    bool issigned;
+  };
+  std::vector<reader_case> cases;
+  for (const uint8_t bpp : {8, 10, 12, 16}) {
+    cases.push_back({imgformat::PGM, bpp, false});
+    cases.push_back({imgformat::PPM, bpp, false});
+    cases.push_back({imgformat::PGX, bpp, false});
+    cases.push_back({imgformat::PGX, bpp, true});
+    cases.push_back({imgformat::PAM, bpp, false});
+  }
+  std::error_code ec;
+  const auto dir = std::filesystem::temp_directory_path(ec) / "image_io_bench";
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    printf("ERROR: cannot create %s.\n", dir.string().c_str());
+    return EXIT_FAILURE;
+  }
+  const simd_level active = get_simd_level();
+  thread_pool decoder(1);
+
+  rep.section("reader");
+  for (const auto &size : cfg.sizes) {
+    const uint32_t w = size.first, h = size.second;
+    for (const auto &c : cases) {
+      const uint16_t nc    = (c.format == imgformat::PPM) ? 3 : (c.format == imgformat::PAM) ? 4 : 1;
+      const char *ext      = (c.format == imgformat::PGM)   ? "pgm"
+                             : (c.format == imgformat::PPM) ? "ppm"
+                             : (c.format == imgformat::PAM) ? "pam"
+                                                            : "pgx";
+      const std::string id = std::string(ext) + " " + (c.issigned ? "s" : "u") + std::to_string(c.bpp) + " "
+                             + std::to_string(w) + "x" + std::to_string(h);
+      const std::string path =
+          (dir / (std::string("in_") + std::to_string(c.bpp) + (c.issigned ? "s." : "u.") + ext)).string();
+
+      image src(w, h, nc, c.bpp, c.issigned);
+      const int32_t lo = (c.issigned) ? -(1 << (c.bpp - 1)) : 0;
+      const size_t num = static_cast<size_t>(w) * h;
+      for (uint16_t ch = 0; ch < nc; ++ch) {
+        for (size_t i = 0; i < num; ++i) {
+          src.get_buf(ch)[i] = lo + static_cast<int32_t>(rng() & ((1U << c.bpp) - 1));
+        }
+      }
+      const int written = (c.format == imgformat::PGM)   ? src.write_pgm(0, path)
+                          : (c.format == imgformat::PPM) ? src.write_ppm(path)
+                          : (c.format == imgformat::PAM) ? src.write_pam(path)
+                                                         : src.write_pgx(0, path);
+      if (written) {
+        return EXIT_FAILURE;
+      }
+      const size_t bytes = num * nc * ((c.bpp + 7) / 8);
+
+      auto matches = [&](const image &img) {
+        bool match = img.get_num_components() == nc;
+        for (uint16_t ch = 0; match && ch < nc; ++ch) {
+          for (size_t i = 0; i < num; ++i) {
+            if (sample_at(img, ch, i) != src.get_buf(ch)[i]) {
+              match = false;
+              break;
+            }
+          }
+        }
+        return match;
+      };
+      for (const auto storage : {sample_storage::INT32, sample_storage::NARROW}) {
+        const std::string name = id + ((storage == sample_storage::INT32) ? " int32" : " narrow");
+        double ref             = 0.0;
+        for (const auto *k : levels) {
+          set_simd_level(k->level);
+          timing t = measure([&] { image img({path}, io_mode::MMAP, storage); }, cfg);
+          if (ref == 0.0) {
+            ref = t.median;
+          }
+          image img({path}, io_mode::MMAP, storage);
+          rep.row("reader", name, simd_level_name(k->level), t, bytes, num, ref, matches(img));
+        }
+        // the same file through async_loader (read, then decoded on one worker) at the active level
+        set_simd_level(active);
+        for (const auto b : {async_backend::IO_URING, async_backend::PREAD}) {
+          async_loader loader(decoder, nullptr, b);
+          if (loader.get_backend() != b) {
+            continue;
+          }
+          timing t = measure([&] { loader.load({path}, storage).get(); }, cfg);
+          auto img = loader.load({path}, storage).get();
+          const std::string async_name = name + " async " + async_backend_name(b);
+          rep.row("reader", async_name, simd_level_name(active), t, bytes, num, ref, matches(*img));
+        }
+      }
+      std::filesystem::remove(path, ec);
+    }
+  }
+  std::filesystem::remove(dir, ec);
+  set_simd_level(active);
+  return EXIT_SUCCESS;
+}
+
+// block means of plane c of img by f x f, rounded to nearest, blocks cut by the edges averaging the
+// pixels they hold (the reference of unpack_reduced())
+SCALAR_REFERENCE static void scalar_box_filter(const image &img, uint16_t c, uint32_t f,
+                                               std::vector<int32_t> &out) {
+  const uint32_t w = img.get_component_width(c), h = img.get_component_height(c);
+  const uint32_t ow = (w + f - 1) / f, oh = (h + f - 1) / f;
+  out.assign(static_cast<size_t>(ow) * oh, 0);
+  for (uint32_t y = 0; y < oh; ++y) {
+    for (uint32_t x = 0; x < ow; ++x) {
+      int64_t sum = 0, n = 0;
+      for (uint32_t yy = y * f; yy < std::min(h, y * f + f); ++yy) {
+        for (uint32_t xx = x * f; xx < std::min(w, x * f + f); ++xx, ++n) {
+          sum += sample_at(img, c, static_cast<size_t>(yy) * w + xx);
+        }
+      }
+      out[static_cast<size_t>(y) * ow + x] = static_cast<int32_t>((sum + n / 2) / n);
+    }
+  }
+}
+
+// thumbnail reads of synthetic PPM files (image(..., reduction)); the speedup column is against a full
+// read alone, which a box filter of its planes would only add to
+static int bench_reduce(reporter &rep, const bench_config &cfg, const level_list &levels,
+                        std::mt19937 &rng) {
+  std::error_code ec;
+  const auto dir = std::filesystem::temp_directory_path(ec) / "image_io_bench";
+  std::filesystem::create_directories(dir, ec);
+  if (ec) {
+    printf("ERROR: cannot create %s.\n", dir.string().c_str());
+    return EXIT_FAILURE;
+  }
+  const simd_level active = get_simd_level();
+
+  rep.section("reduce");
+  for (const auto &size : cfg.sizes) {
+    const uint32_t w = size.first, h = size.second;
+    for (const uint8_t bpp : {8, 12}) {
+      const std::string path = (dir / (std::string("reduce_") + std::to_string(bpp) + ".ppm")).string();
+      image src(w, h, 3, bpp, false);
+      const size_t num = static_cast<size_t>(w) * h;
+      for (uint16_t ch = 0; ch < 3; ++ch) {
+        for (size_t i = 0; i < num; ++i) {
+          src.get_buf(ch)[i] = static_cast<int32_t>(rng() & ((1U << bpp) - 1));
+        }
+      }
+      if (src.write_ppm(path)) {
+        return EXIT_FAILURE;
+      }
+      const size_t bytes = 3 * num * ((bpp + 7) / 8);
+      for (const uint32_t f : {2U, 4U, 8U}) {
+        std::vector<int32_t> expected[3];
+        for (uint16_t ch = 0; ch < 3; ++ch) {
+          scalar_box_filter(src, ch, f, expected[ch]);
+        }
+        const std::string id = "ppm u" + std::to_string(bpp) + " " + std::to_string(w) + "x"
+                               + std::to_string(h) + " /" + std::to_string(f);
+        for (const auto storage : {sample_storage::INT32, sample_storage::NARROW}) {
+          const std::string name = id + ((storage == sample_storage::INT32) ? " int32" : " narrow");
+          set_simd_level(active);
+          const timing full = measure([&] { image img({path}, io_mode::MMAP, storage); }, cfg);
+          const char *level = simd_level_name(active);
+          rep.row("reduce", name + " full read", level, full, bytes, num, full.median, true);
+          for (const auto *k : levels) {
+            set_simd_level(k->level);
+            timing t = measure(
+                [&] { image img({path}, io_mode::MMAP, storage, nullptr, nullptr, f); }, cfg);
+            image img({path}, io_mode::MMAP, storage, nullptr, nullptr, f);
+            bool match = img.get_num_components() == 3;
+            for (uint16_t ch = 0; match && ch < 3; ++ch) {
+              for (size_t i = 0; i < expected[ch].size(); ++i) {
+                if (sample_at(img, ch, i) != expected[ch][i]) {
+                  match = false;
+                  break;
+                }
+              }
+            }
+            rep.row("reduce", name, simd_level_name(k->level), t, bytes, num, full.median, match);
+          }
+        }
+      }
+      std::filesystem::remove(path, ec);
+    }
+  }
+  std::filesystem::remove(dir, ec);
+  set_simd_level(active);
+  return EXIT_SUCCESS;
+}
+
+// rgb2xyb_rows() over whole images whose X and B planes (and R and B inputs) are 4:2:2 or 4:2:0; the
+// baseline level is the reference of every level, the speedup column is against its 4:4:4 conversion
+static void bench_subsample(reporter &rep, const bench_config &cfg, const level_list &levels,
+                            std::mt19937 &rng) {
+  const simd_level active = get_simd_level();
+  const std::pair<chroma_subsampling, const char *> layouts[3] = {
+      {chroma_subsampling::S444, "4:4:4"}, {chroma_subsampling::S422, "4:2:2"},
+      {chroma_subsampling::S420, "4:2:0"}};
+
+  rep.section("subsample");
+  for (const auto &size : cfg.sizes) {
+    const uint32_t w = size.first, h = size.second;
+    const size_t num = static_cast<size_t>(w) * h;
+    double full      = 0.0;
+    for (const auto &layout : layouts) {
+      image rgb(w, h, layout.first, 8, false, sample_type::U8);
+      size_t bytes = 0;
+      for (uint16_t c = 0; c < 3; ++c) {
+        const size_t n = static_cast<size_t>(rgb.get_component_width(c)) * rgb.get_component_height(c);
+        uint8_t *p     = rgb.get_buf<uint8_t>(c);
+        for (size_t i = 0; i < n; ++i) {
+          p[i] = static_cast<uint8_t>(rng());
+        }
+        bytes += n;
+      }
+      image ref(w, h, layout.first, xyb_bpp, true);
+      image dst(w, h, layout.first, xyb_bpp, true);
+      xyb_stats stats;
+      set_simd_level(levels.front()->level);
+      rgb2xyb_rows(rgb, ref, 0, h, stats);
+      const std::string name = std::string("u8 ") + layout.second + " " + std::to_string(w) + "x"
+                               + std::to_string(h);
+      for (const auto *k : levels) {
+        set_simd_level(k->level);
+        timing t = measure([&] { rgb2xyb_rows(rgb, dst, 0, h, stats); }, cfg);
+        if (full == 0.0) {
+          full = t.median;
+        }
+        bool match = true;
+        for (uint16_t c = 0; match && c < 3; ++c) {
+          const size_t n = static_cast<size_t>(dst.get_component_width(c)) * dst.get_component_height(c);
+          match          = memcmp(ref.get_buf(c), dst.get_buf(c), n * sizeof(int32_t)) == 0;
+        }
+        rep.row("subsample", name, simd_level_name(k->level), t, bytes, num, full, match);
+      }
+    }
+  }
+  set_simd_level(active);
+}
+
+int main(int argc, char *argv[]) {
+  bench_config cfg;
+  bool perf = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string arg = argv[i];
+    if (arg == "-csv") {
+      cfg.csv = true;
+      continue;
+    }
+    if (arg == "-perf") {
+      perf = true;
+      continue;
+    }
+    if (i + 1 >= argc) {
+      printf("ERROR: missing value of %s.\n", arg.c_str());
+      return EXIT_FAILURE;
+    }
+    const std::string val = argv[++i];
+    if (arg == "-r") {
+      cfg.reps = std::max(1, std::stoi(val));
+    } else if (arg == "-w") {
+      cfg.warmup = std::max(0, std::stoi(val));
+    } else if (arg == "-n") {
+      cfg.len = std::max<size_t>(1, std::stoul(val));
+    } else if (arg == "-only") {
+      cfg.only = val;
+    } else if (arg == "-s") {
+      uint32_t w = 0, h = 0;
+      if (sscanf(val.c_str(), "%ux%u", &w, &h) != 2 || w == 0 || h == 0) {
+        printf("ERROR: size shall be given as WxH.\n");
+        return EXIT_FAILURE;
+      }
+      cfg.sizes.emplace_back(w, h);
+    } else {
+      printf("ERROR: unknown option %s.\n", arg.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  if (cfg.sizes.empty()) {
+    cfg.sizes = {{512, 512}, {2048, 2048}};
+  }
+
+  level_list levels;
+  for (simd_level l :
+       {simd_level::SCALAR, simd_level::NEON, simd_level::SSE41, simd_level::AVX2, simd_level::AVX512}) {
+    if (find_kernels(l) != nullptr) {
+      levels.push_back(find_kernels(l));
+    }
+  }
+  if (!cfg.csv) {
+    printf("%zu samples per kernel call, %d warmup + %d timed runs, statistics of the timed runs\n",
+           cfg.len, cfg.warmup, cfg.reps);
+  }
+
+  // kernels and readers run on this thread, so its counters cover them
+  perf_counters counters;
+  if (perf && counters.any_available()) {
+    cfg.counters = &counters;
+  } else if (perf) {
+    printf("%shardware performance counters are unavailable (%s), reporting times only\n",
+           (cfg.csv) ? "# " : "", counters.unavailable_reason());
+  }
+
+  std::mt19937 rng(12345);
+  reporter rep(cfg.csv, cfg.counters);
+  if (cfg.enabled("unpack")) {
+    bench_unpack(rep, cfg, levels, rng);
+  }
+  if (cfg.enabled("pack")) {
+    bench_pack(rep, cfg, levels, rng);
+  }
+  if (cfg.enabled("rgb2xyb")) {
+    bench_rgb2xyb(rep, cfg, levels, rng);
+  }
+  if (cfg.enabled("cbrt")) {
+    bench_cbrt(rep, cfg, rng);
+  }
+  if (cfg.enabled("lut3d")) {
+    bench_lut3d(rep, cfg, levels, rng);
+  }
+  if (cfg.enabled("ascii")) {
+    bench_ascii(rep, cfg, levels, rng);
+  }
+  if (cfg.enabled("reader") && bench_reader(rep, cfg, levels, rng)) {
+    return EXIT_FAILURE;
+  }
+  if (cfg.enabled("reduce") && bench_reduce(rep, cfg, levels, rng)) {
+    return EXIT_FAILURE;
+  }
+  if (cfg.enabled("subsample")) {
+    bench_subsample(rep, cfg, levels, rng);
+  }
+  return rep.get_status();
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cassert>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
@@ -7,33 +8,70 @@
 #include <string>
 #include <vector>
 
-#if defined(__ARM_NEON__) || defined(__ARM_NEON)
-  #define USE_ARM_NEON
-  #include <arm_neon.h>
-#elif defined(__AVX2__) || defined(__MINGW64__)
-  #define USEAVX2
-  #if defined(_MSC_VER)
-    #include <intrin.h>
-  #else
-    #include <x86intrin.h>
-  #endif
-#endif
+#include "instrument.hpp"
+#include "plane_pool.hpp"
+#include "simd_dispatch.hpp"
 
-constexpr char SP = ' ';
-constexpr char LF = '\n';
-constexpr char CR = 0x0d;
+enum class imgformat { PGM, PPM, PGX, PAM, PFM };
+// MMAP: map the input file and unpack samples directly from the mapping
+// STDIO: read the whole input file into a temporary buffer with fread()
+enum class io_mode { STDIO, MMAP };
+// INT32: samples of every plane are widened to int32
+// NARROW: each plane keeps the narrowest sample_type that holds its samples
+enum class sample_storage { INT32, NARROW };
+// layout of a 3-component image: S444 keeps every plane at full size, S422 halves planes 0 and 2
+// horizontally and S420 in both directions (sizes rounded up); plane 1 (G of RGB, Y of XYB) stays full
+enum class chroma_subsampling { S444, S422, S420 };
+// type of the samples held in a plane; F32 (float) only comes from PFM files
+enum class sample_type { U8, U16, S16, S32, F32 };
 
-enum class status { READ_WIDTH, READ_HEIGHT, READ_MAXVAL, DONE };
-enum class imgformat { PGM, PPM, PGX };
-// eat white/LF/CR and comments
-static auto eat_white = [](int &d, FILE *fp, char *comment) {
-  while (d == SP || d == LF || d == CR) {
-    d = fgetc(fp);
-    if (d == '#') {
-      static_cast<void>(fgets(comment, 256, fp));
-      d = fgetc(fp);
-    }
+static inline sample_type narrowest_sample_type(uint8_t bpp, bool is_signed) {
+  if (bpp <= 8) {
+    return (is_signed) ? sample_type::S16 : sample_type::U8;
+  }
+  if (bpp <= 16) {
+    return (is_signed) ? sample_type::S16 : sample_type::U16;
+  }
+  return sample_type::S32;
+}
+
+static inline size_t sample_size(sample_type t) {
+  switch (t) {
+    case sample_type::U8:
+      return sizeof(uint8_t);
+    case sample_type::U16:
+      return sizeof(uint16_t);
+    case sample_type::S16:
+      return sizeof(int16_t);
+    case sample_type::F32:
+      return sizeof(float);
+    default:
+      return sizeof(int32_t);
   }
+}
+
+// sample_type of a C++ type, used to check typed access to a plane
+template <class T>
+struct sample_type_of;
+template <>
+struct sample_type_of<uint8_t> {
+  static constexpr sample_type value = sample_type::U8;
+};
+template <>
+struct sample_type_of<uint16_t> {
+  static constexpr sample_type value = sample_type::U16;
+};
+template <>
+struct sample_type_of<int16_t> {
+  static constexpr sample_type value = sample_type::S16;
+};
+template <>
+struct sample_type_of<int32_t> {
+  static constexpr sample_type value = sample_type::S32;
+};
+template <>
+struct sample_type_of<float> {
+  static constexpr sample_type value = sample_type::F32;
 };
 
 static inline void *aligned_mem_alloc(size_t size, size_t align) {
@@ -57,7 +95,13 @@ static inline void *aligned_mem_alloc(size_t size, size_t align) {
 // deleter
 template <class T>
 struct delete_aligned {
+  plane_pool *pool = nullptr;  // owner of the buffer, nullptr if it came from the system allocator
+  size_t bytes     = 0;        // size requested from pool
   void operator()(T *data) const {
+    if (pool != nullptr) {
+      pool->release(data, bytes);
+      return;
+    }
 #if defined(_MSC_VER)
     _aligned_free(data);
 #elif defined(__MINGW32__) || defined(__MINGW64__)
@@ -71,12 +115,172 @@ struct delete_aligned {
 // allocator
 template <class T>
 using unique_ptr_aligned = std::unique_ptr<T, delete_aligned<T>>;
+// buffers of up to plane_pool::alignment are recycled through pool if given
 template <class T>
-unique_ptr_aligned<T> aligned_uptr(size_t align, size_t size) {
+unique_ptr_aligned<T> aligned_uptr(size_t align, size_t size, plane_pool *pool = nullptr) {
+  if (pool != nullptr && align <= plane_pool::alignment) {
+    const size_t bytes = size * sizeof(T);
+    return unique_ptr_aligned<T>(static_cast<T *>(pool->acquire(bytes)), delete_aligned<T>{pool, bytes});
+  }
   // return unique_ptr_aligned<T>(static_cast<T *>(aligned_mem_alloc(size * sizeof(T), align)));
   return unique_ptr_aligned<T>(static_cast<T *>(aligned_alloc(align, size * sizeof(T))));
 }
 
+/********************************************************************************
+ * read-only view of a whole input file
+ *******************************************************************************/
+class file_view {
+ private:
+  const uint8_t *ptr;
+  size_t len;
+  bool mapped;
+  unique_ptr_aligned<uint8_t> heap;
+
+ public:
+  file_view() : ptr(nullptr), len(0), mapped(false), heap(nullptr) {}
+  file_view(file_view &&other) noexcept
+      : ptr(other.ptr), len(other.len), mapped(other.mapped), heap(std::move(other.heap)) {
+    other.ptr    = nullptr;
+    other.len    = 0;
+    other.mapped = false;
+  }
+  file_view(const file_view &)            = delete;
+  file_view &operator=(const file_view &) = delete;
+  ~file_view();
+  // falls back to STDIO if the file cannot be mapped (e.g. pipes or empty files); the STDIO buffer
+  // comes from pool if given
+  int open(const std::string &filename, io_mode mode, plane_pool *pool = nullptr);
+  // take over the first size bytes of data, a file read by other means (see async_loader.hpp)
+  void adopt(unique_ptr_aligned<uint8_t> data, size_t size) {
+    assert(!mapped);
+    heap = std::move(data);
+    ptr  = heap.get();
+    len  = size;
+  }
+  const uint8_t *data() const { return ptr; }
+  size_t size() const { return len; }
+};
+
+/********************************************************************************
+ * positioned reads of parts of a file, for reads of a crop window: pread() on
+ * POSIX, fseek() and fread() elsewhere; nothing is mapped or read ahead
+ *******************************************************************************/
+class positioned_file {
+ private:
+#if defined(_MSC_VER)
+  FILE *fp;
+#else
+  int fd;
+#endif
+  uint64_t len;
+
+ public:
+  positioned_file();
+  positioned_file(const positioned_file &)            = delete;
+  positioned_file &operator=(const positioned_file &) = delete;
+  ~positioned_file();
+  int open(const std::string &filename);
+  uint64_t size() const { return len; }
+  // read n bytes at offset into dst; false if the file ends before or the read fails
+  bool read(uint64_t offset, uint8_t *dst, size_t n);
+};
+
+// crop window of a read: columns [x0, x0 + width) of rows [y0, y0 + height)
+struct image_roi {
+  uint32_t x0;
+  uint32_t y0;
+  uint32_t width;
+  uint32_t height;
+};
+
+/********************************************************************************
+ * sequential reader and header tokenizer over an in-memory byte range
+ * (fgetc() replacement); comments run from '#' to the end of the line, of any
+ * length
+ *******************************************************************************/
+class byte_stream {
+ private:
+  const uint8_t *const begin;
+  const uint8_t *const end;
+  const uint8_t *cur;
+
+ public:
+  byte_stream(const uint8_t *p, size_t n) : begin(p), end(p + n), cur(p) {}
+  int get() { return (cur < end) ? *cur++ : EOF; }
+  int peek() const { return (cur < end) ? *cur : EOF; }
+  size_t tell() const { return static_cast<size_t>(cur - begin); }
+  size_t remaining() const { return static_cast<size_t>(end - cur); }
+  // current position, valid for remaining() bytes
+  const uint8_t *ptr() const { return cur; }
+  void skip(size_t n) { cur += (n < remaining()) ? n : remaining(); }
+  // white space of the Netpbm formats: SP, HT, LF, VT, FF and CR
+  static bool is_white(int d) { return d == ' ' || (d >= '\t' && d <= '\r'); }
+  // skip white space and comments
+  void skip_white() {
+    while (cur < end) {
+      if (is_white(*cur)) {
+        ++cur;
+      } else if (*cur == '#') {
+        while (cur < end && *cur != '\n' && *cur != '\r') {
+          ++cur;
+        }
+      } else {
+        break;
+      }
+    }
+  }
+  // read an unsigned decimal number; returns false, keeping the position, if there is no digit or the
+  // number exceeds 32 bits
+  bool read_uint(uint32_t &val) {
+    const uint8_t *p = cur;
+    uint64_t v       = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+      v = v * 10 + (*p++ - '0');
+      if (v > UINT32_MAX) {
+        return false;
+      }
+    }
+    if (p == cur) {
+      return false;
+    }
+    val = static_cast<uint32_t>(v);
+    cur = p;
+    return true;
+  }
+  // true at white space, a comment or the end of the input, i.e. after a complete token
+  bool at_separator() const { return cur == end || is_white(*cur) || *cur == '#'; }
+  // read the bytes up to the next separator (see at_separator()), e.g. a keyword; empty at a separator
+  std::string read_token() {
+    const uint8_t *p = cur;
+    while (!at_separator()) {
+      ++cur;
+    }
+    return std::string(p, cur);
+  }
+};
+
+// units (samples or pixels) packed per fwrite() by write_raster()
+constexpr size_t write_block_units = 1 << 15;
+
+/**
+ * @brief Write a raster of num_units units of unit_bytes bytes each to fp; pack(first, n, dst) stores
+ * the units [first, first + n) into dst, so only one block of the output is held in memory
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+template <class F>
+int write_raster(FILE *fp, size_t num_units, size_t unit_bytes, F &&pack, plane_pool *pool = nullptr) {
+  auto buf = aligned_uptr<uint8_t>(64, write_block_units * unit_bytes, pool);
+  for (size_t first = 0; first < num_units; first += write_block_units) {
+    const size_t n = (num_units - first < write_block_units) ? num_units - first : write_block_units;
+    pack(first, n, buf.get());
+    if (fwrite(buf.get(), unit_bytes, n, fp) != n) {
+      return EXIT_FAILURE;
+    }
+  }
+  return EXIT_SUCCESS;
+}
+
 class image_component {
  private:
   uint16_t index;
@@ -84,239 +288,72 @@ class image_component {
   uint32_t height;
   uint8_t bits_per_pixel;
   bool is_signed;
-  // std::unique_ptr<int32_t[]> buf;
-  unique_ptr_aligned<int32_t> buf;
+  io_mode mode;
+  sample_storage storage;
+  sample_type type;
+  uint8_t log2_reduction;  // the plane is box-filtered by 2^log2_reduction (see unpack_reduced())
+  // samples of the plane, of the given type
+  unique_ptr_aligned<uint8_t> buf;
+  plane_pool *pool;  // source of buf, nullptr for the system allocator
 
  public:
   image_component(uint16_t c)
-      : index(c), width(0), height(0), bits_per_pixel(0), is_signed(false), buf(nullptr) {}
-  virtual ~image_component()                    = default;
-  virtual int read(const std::string &filename) = 0;
+      : index(c),
+        width(0),
+        height(0),
+        bits_per_pixel(0),
+        is_signed(false),
+        mode(io_mode::MMAP),
+        storage(sample_storage::INT32),
+        type(sample_type::S32),
+        log2_reduction(0),
+        buf(nullptr),
+        pool(nullptr) {}
+  virtual ~image_component() = default;
+  // parse the whole file held by fv; filename is used in messages
+  virtual int decode(const file_view &fv, const std::string &filename) = 0;
+  int read(const std::string &filename) {
+    file_view fv;
+    if (fv.open(filename, mode, pool)) {
+      printf("ERROR: File %s is not found.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+    return decode(fv, filename);
+  }
   uint32_t get_width() { return width; }
   uint32_t get_height() { return height; }
   uint8_t get_bpp() { return bits_per_pixel; }
   bool get_is_signed() { return is_signed; }
-  int32_t *get_buf(size_t offset = 0) { return buf.get() + offset; }
+  io_mode get_io_mode() { return mode; }
+  sample_storage get_sample_storage() { return storage; }
+  sample_type get_sample_type() { return type; }
+  // T shall match the sample type of the plane
+  template <class T = int32_t>
+  T *get_buf(size_t offset = 0) {
+    assert(sample_type_of<T>::value == type);
+    return reinterpret_cast<T *>(buf.get()) + offset;
+  }
+  // the plane whichever its sample type
+  uint8_t *get_bytes() { return buf.get(); }
+  uint8_t get_log2_reduction() { return log2_reduction; }
   void set_index(uint16_t val) { index = val; }
   void set_width(uint32_t val) { width = val; }
   void set_height(uint32_t val) { height = val; }
   void set_bpp(uint8_t val) { bits_per_pixel = val; }
   void set_is_signed(bool val) { is_signed = val; }
-  void create_buf(uint32_t val) {
-    buf = aligned_uptr<int32_t>(32, val);
-    // buf = std::make_unique<int32_t[]>(val);
+  void set_io_mode(io_mode val) { mode = val; }
+  void set_sample_storage(sample_storage val) { storage = val; }
+  void set_log2_reduction(uint8_t val) { log2_reduction = val; }
+  void set_pool(plane_pool *val) { pool = val; }
+  plane_pool *get_pool() { return pool; }
+  // sample type the readers shall store, derived from bits_per_pixel and is_signed
+  sample_type storage_type() {
+    return (storage == sample_storage::NARROW) ? narrowest_sample_type(bits_per_pixel, is_signed)
+                                               : sample_type::S32;
+  }
+  void create_buf(size_t val, sample_type t = sample_type::S32) {
+    type = t;
+    buf  = aligned_uptr<uint8_t>(32, val * sample_size(t), pool);
   }
   auto move_buf() { return std::move(buf); }
 };
-
-#if defined(USE_ARM_NEON)
-// store uint8x16_t vector as int32
-static auto store_u8_to_s32(uint8x16_t &src, int32_t *dst) {
-  int16x8_t l = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(src)));
-  int16x8_t h = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(src)));
-  auto ll     = vmovl_s16(vget_low_s16(l));
-  auto lh     = vmovl_s16(vget_high_s16(l));
-  auto hl     = vmovl_s16(vget_low_s16(h));
-  auto hh     = vmovl_s16(vget_high_s16(h));
-  vst1q_s32(dst, ll);
-  vst1q_s32(dst + 4, lh);
-  vst1q_s32(dst + 8, hl);
-  vst1q_s32(dst + 12, hh);
-}
-
-// store uint8x16_t vector as uint32
-static auto store_u8_to_u32(uint8x16_t &src, int32_t *dst) {
-  int16x8_t l = vmovl_u8(vget_low_u8(src));
-  int16x8_t h = vmovl_u8(vget_high_u8(src));
-  auto ll     = vmovl_u16(vget_low_u16(l));
-  auto lh     = vmovl_u16(vget_high_u16(l));
-  auto hl     = vmovl_u16(vget_low_u16(h));
-  auto hh     = vmovl_u16(vget_high_u16(h));
-  vst1q_s32(dst, ll);
-  vst1q_s32(dst + 4, lh);
-  vst1q_s32(dst + 8, hl);
-  vst1q_s32(dst + 12, hh);
-}
-
-// store int8x16_t vector as int32
-static auto store_s8_to_s32(int8x16_t &src, int32_t *dst) {
-  int16x8_t l = vreinterpretq_s16_u16(vmovl_s8(vget_low_s8(src)));
-  int16x8_t h = vreinterpretq_s16_u16(vmovl_s8(vget_high_s8(src)));
-  auto ll     = vmovl_s16(vget_low_s16(l));
-  auto lh     = vmovl_s16(vget_high_s16(l));
-  auto hl     = vmovl_s16(vget_low_s16(h));
-  auto hh     = vmovl_s16(vget_high_s16(h));
-  vst1q_s32(dst, ll);
-  vst1q_s32(dst + 4, lh);
-  vst1q_s32(dst + 8, hl);
-  vst1q_s32(dst + 12, hh);
-}
-
-// store int8x16_t vector as uint32
-static auto store_s8_to_u32(int8x16_t &src, int32_t *dst) {
-  int16x8_t l = vmovl_u8(vget_low_u8(src));
-  int16x8_t h = vmovl_u8(vget_high_u8(src));
-  auto ll     = vmovl_u16(vget_low_u16(l));
-  auto lh     = vmovl_u16(vget_high_u16(l));
-  auto hl     = vmovl_u16(vget_low_u16(h));
-  auto hh     = vmovl_u16(vget_high_u16(h));
-  vst1q_s32(dst, ll);
-  vst1q_s32(dst + 4, lh);
-  vst1q_s32(dst + 8, hl);
-  vst1q_s32(dst + 12, hh);
-}
-
-// store big-endian uint16x8_t vector as int32
-static inline auto store_big_u16_to_s32(uint16x8_t &src, int32_t *dst) {
-  auto little_big = vrev16q_u8(src);  // convert endianness from big to little
-  auto x0         = vreinterpretq_s32_u16(little_big);
-  auto xl         = vmovl_s16(vreinterpret_s16_s32(vget_low_s32(x0)));
-  auto xh         = vmovl_s16(vreinterpret_s16_s32(vget_high_s32(x0)));
-  vst1q_s32(dst, xl);
-  vst1q_s32(dst + 4, xh);
-}
-
-// store big-endian uint16x8_t vector as uint32
-static inline auto store_big_u16_to_u32(uint16x8_t &src, int32_t *dst) {
-  auto little_big = vrev16q_u8(src);  // convert endianness from big to little
-  auto x0         = vreinterpretq_u32_u16(little_big);
-  auto xl         = vmovl_u16(vreinterpret_u16_u32(vget_low_u32(x0)));
-  auto xh         = vmovl_u16(vreinterpret_u16_u32(vget_high_u32(x0)));
-  vst1q_s32(dst, xl);
-  vst1q_s32(dst + 4, xh);
-}
-
-// store little-endian uint16x8_t vector as int32
-static inline auto store_little_u16_to_s32(uint16x8_t &src, int32_t *dst) {
-  auto x0 = vreinterpretq_s32_u16(vreinterpretq_u16_u8(src));
-  auto xl = vmovl_s16(vreinterpret_s16_s32(vget_low_s32(x0)));
-  auto xh = vmovl_s16(vreinterpret_s16_s32(vget_high_s32(x0)));
-  vst1q_s32(dst, xl);
-  vst1q_s32(dst + 4, xh);
-}
-
-// store big-endian int16x8_t vector as int32
-static inline auto store_big_s16_to_s32(uint16x8_t &src, int32_t *dst) {
-  auto x0 = vreinterpretq_s32_s16(vreinterpretq_s16_u8(vrev16q_u8(src)));
-  auto xl = vmovl_s16(vreinterpret_s16_s32(vget_low_s32(x0)));
-  auto xh = vmovl_s16(vreinterpret_s16_s32(vget_high_s32(x0)));
-  vst1q_s32(dst, xl);
-  vst1q_s32(dst + 4, xh);
-}
-
-// store little-endian int16x8_t vector as int32
-static inline auto store_little_s16_to_s32(uint16x8_t &src, int32_t *dst) {
-  auto x0 = vreinterpretq_s32_s16(vreinterpretq_s16_u8(src));
-  auto xl = vmovl_s16(vreinterpret_s16_s32(vget_low_s32(x0)));
-  auto xh = vmovl_s16(vreinterpret_s16_s32(vget_high_s32(x0)));
-  vst1q_s32(dst, xl);
-  vst1q_s32(dst + 4, xh);
-}
-#elif defined(__AVX2__)
-static auto load_u8_store_s32(uint8_t const *src, int32_t *const R, int32_t *const G, int32_t *const B) {
-  __m128i tmp0, tmp1, tmp2, tmp3;
-  alignas(16) static const int8_t mask8_R[16] = {0, 3, 6, 9, 12, 15, 1, 4, 7, 10, 13, 2, 5, 8, 11, 14};
-  alignas(16) static const int8_t mask8_G[16] = {2, 5, 8, 11, 14, 0, 3, 6, 9, 12, 15, 1, 4, 7, 10, 13};
-  alignas(16) static const int8_t mask8_B[16] = {1, 4, 7, 10, 13, 2, 5, 8, 11, 14, 0, 3, 6, 9, 12, 15};
-
-  __m128i v0 = _mm_loadu_si128((__m128i *)src);
-  __m128i v1 = _mm_loadu_si128((__m128i *)(src + 16));
-  __m128i v2 = _mm_loadu_si128((__m128i *)(src + 32));
-
-  tmp0 = _mm_shuffle_epi8(v0, *(__m128i *)mask8_R);  // a:0,3,6,9,12,15,1,4,7,10,13,2,5,8,11
-  tmp1 = _mm_shuffle_epi8(v1, *(__m128i *)mask8_G);  // b:2,5,8,11,14,0,3,6,9,12,15,1,4,7,10,13
-  tmp2 = _mm_shuffle_epi8(v2, *(__m128i *)mask8_B);  // c:1,4,7,10,13,2,5,8,11,14,3,6,9,12,15
-
-  tmp3 = _mm_slli_si128(tmp0, 10);         // 0,0,0,0,0,0,0,0,0,0,a0,a3,a6,a9,a12,a15
-  tmp3 = _mm_alignr_epi8(tmp1, tmp3, 10);  // a:0,3,6,9,12,15,b:2,5,8,11,14,x,x,x,x,x
-  tmp3 = _mm_slli_si128(tmp3, 5);          // 0,0,0,0,0,a:0,3,6,9,12,15,b:2,5,8,11,14,
-  tmp3 = _mm_srli_si128(tmp3, 5);          // a:0,3,6,9,12,15,b:2,5,8,11,14,:0,0,0,0,0
-  v0 = _mm_slli_si128(tmp2, 11);           // 0,0,0,0,0,0,0,0,0,0,0,0, 1,4,7,10,13,
-  v0 = _mm_or_si128(v0, tmp3);             // a:0,3,6,9,12,15,b:2,5,8,11,14,c:1,4,7,10,13,
-
-  tmp3 = _mm_slli_si128(tmp0, 5);   // 0,0,0,0,0,a:0,3,6,9,12,15,1,4,7,10,13,
-  tmp3 = _mm_srli_si128(tmp3, 11);  // a:1,4,7,10,13, 0,0,0,0,0,0,0,0,0,0,0
-  v1 = _mm_srli_si128(tmp1, 5);     // b:0,3,6,9,12,15,C:1,4,7,10,13, 0,0,0,0,0
-  v1 = _mm_slli_si128(v1, 5);       // 0,0,0,0,0,b:0,3,6,9,12,15,C:1,4,7,10,13,
-  v1 = _mm_or_si128(v1, tmp3);      // a:1,4,7,10,13,b:0,3,6,9,12,15,C:1,4,7,10,13,
-  v1 = _mm_slli_si128(v1, 5);       // 0,0,0,0,0,a:1,4,7,10,13,b:0,3,6,9,12,15,
-  v1 = _mm_srli_si128(v1, 5);       // a:1,4,7,10,13,b:0,3,6,9,12,15,0,0,0,0,0
-  tmp3 = _mm_srli_si128(tmp2, 5);   // c:2,5,8,11,14,0,3,6,9,12,15,0,0,0,0,0
-  tmp3 = _mm_slli_si128(tmp3, 11);  // 0,0,0,0,0,0,0,0,0,0,0,c:2,5,8,11,14,
-  v1 = _mm_or_si128(v1, tmp3);      // a:1,4,7,10,13,b:0,3,6,9,12,15,c:2,5,8,11,14,
-
-  tmp3 = _mm_srli_si128(tmp2, 10);  // c:0,3,6,9,12,15, 0,0,0,0,0,0,0,0,0,0,
-  tmp3 = _mm_slli_si128(tmp3, 10);  // 0,0,0,0,0,0,0,0,0,0, c:0,3,6,9,12,15,
-  v2 = _mm_srli_si128(tmp1, 11);    // b:1,4,7,10,13,0,0,0,0,0,0,0,0,0,0,0
-  v2 = _mm_slli_si128(v2, 5);       // 0,0,0,0,0,b:1,4,7,10,13, 0,0,0,0,0,0
-  v2 = _mm_or_si128(v2, tmp3);      // 0,0,0,0,0,b:1,4,7,10,13,c:0,3,6,9,12,15,
-  tmp0 = _mm_srli_si128(tmp0, 11);  // a:2,5,8,11,14, 0,0,0,0,0,0,0,0,0,0,0,
-  v2 = _mm_or_si128(v2, tmp0);      // a:2,5,8,11,14,b:1,4,7,10,13,c:0,3,6,9,12,15,
-  auto Rhigh = _mm_srli_si128(v0, 8);
-  auto Rlow = _mm_move_epi64(v0);
-  _mm256_storeu_si256((__m256i *)R, _mm256_cvtepi8_epi32(Rlow));
-  _mm256_storeu_si256((__m256i *)(R + 8), _mm256_cvtepi8_epi32(Rhigh));
-  auto Ghigh = _mm_srli_si128(v1, 8);
-  auto Glow = _mm_move_epi64(v1);
-  _mm256_storeu_si256((__m256i *)G, _mm256_cvtepi8_epi32(Glow));
-  _mm256_storeu_si256((__m256i *)(G + 8), _mm256_cvtepi8_epi32(Ghigh));
-  auto Bhigh = _mm_srli_si128(v2, 8);
-  auto Blow = _mm_move_epi64(v2);
-  _mm256_storeu_si256((__m256i *)B, _mm256_cvtepi8_epi32(Blow));
-  _mm256_storeu_si256((__m256i *)(B + 8), _mm256_cvtepi8_epi32(Bhigh));
-}
-
-static auto load_u16_store_s32(uint16_t const *src, int32_t *const R, int32_t *const G, int32_t *const B) {
-  __m128i tmp0, tmp1, tmp2, tmp3;
-  alignas(16) static const int8_t mask16_0[16] = {0, 1, 6, 7, 12, 13, 2, 3, 8, 9, 14, 15, 4, 5, 10, 11};
-  alignas(16) static const int8_t mask16_1[16] = {2, 3, 8, 9, 14, 15, 4, 5, 10, 11, 0, 1, 6, 7, 12, 13};
-  alignas(16) static const int8_t mask16_2[16] = {4, 5, 10, 11, 0, 1, 6, 7, 12, 13, 2, 3, 8, 9, 14, 15};
-
-  __m128i v0 = _mm_loadu_si128((__m128i *)(src));       // a0,a1,a2,a3,...a7,
-  __m128i v1 = _mm_loadu_si128((__m128i *)(src + 8));   // b0,b1,b2,b3...b7
-  __m128i v2 = _mm_loadu_si128((__m128i *)(src + 16));  // c0,c1,c2,c3,...c7
-
-  tmp0 = _mm_shuffle_epi8(v0, *(__m128i *)mask16_0);  // a0,a3,a6,a1,a4,a7,a2,a5,
-  tmp1 = _mm_shuffle_epi8(v1, *(__m128i *)mask16_1);  // b1,b4,b7,b2,b5,b0,b3,b6
-  tmp2 = _mm_shuffle_epi8(v2, *(__m128i *)mask16_2);  // c2,c5, c0,c3,c6, c1,c4,c7
-
-  tmp3 = _mm_slli_si128(tmp0, 10);         // 0,0,0,0,0,a0,a3,a6,
-  tmp3 = _mm_alignr_epi8(tmp1, tmp3, 10);  // a0,a3,a6,b1,b4,b7,x,x
-  tmp3 = _mm_slli_si128(tmp3, 4);          // 0,0, a0,a3,a6,b1,b4,b7
-  tmp3 = _mm_srli_si128(tmp3, 4);          // a0,a3,a6,b1,b4,b7,0,0
-  v0 = _mm_slli_si128(tmp2, 12);           // 0,0,0,0,0,0, c2,c5,
-  v0 = _mm_or_si128(v0, tmp3);             // a0,a3,a6,b1,b4,b7,c2,c5
-  __m128i va = _mm_slli_epi16(v0, 8);
-  __m128i vb = _mm_srli_epi16(v0, 8);
-  v0 = _mm_or_si128(va, vb);
-  _mm256_stream_si256((__m256i *)R, _mm256_cvtepu16_epi32(v0));
-
-  tmp3 = _mm_slli_si128(tmp0, 4);   // 0,0,a0,a3,a6,a1,a4,a7
-  tmp3 = _mm_srli_si128(tmp3, 10);  // a1,a4,a7, 0,0,0,0,0
-  v1 = _mm_srli_si128(tmp1, 6);     // b2,b5,b0,b3,b6,0,0
-  v1 = _mm_slli_si128(v1, 6);       // 0,0,0,b2,b5,b0,b3,b6,
-  v1 = _mm_or_si128(v1, tmp3);      // a1,a4,a7,b2,b5,b0,b3,b6,
-  v1 = _mm_slli_si128(v1, 6);       // 0,0,0,a1,a4,a7,b2,b5,
-  v1 = _mm_srli_si128(v1, 6);       // a1,a4,a7,b2,b5,0,0,0,
-  tmp3 = _mm_srli_si128(tmp2, 4);   // c0,c3,c6, c1,c4,c7,0,0
-  tmp3 = _mm_slli_si128(tmp3, 10);  // 0,0,0,0,0,c0,c3,c6,
-  v1 = _mm_or_si128(v1, tmp3);      // a1,a4,a7,b2,b5,c0,c3,c6,
-  va = _mm_slli_epi16(v1, 8);
-  vb = _mm_srli_epi16(v1, 8);
-  v1 = _mm_or_si128(va, vb);
-  _mm256_stream_si256((__m256i *)G, _mm256_cvtepu16_epi32(v1));
-
-  tmp3 = _mm_srli_si128(tmp2, 10);  // c1,c4,c7, 0,0,0,0,0
-  tmp3 = _mm_slli_si128(tmp3, 10);  // 0,0,0,0,0, c1,c4,c7,
-  v2 = _mm_srli_si128(tmp1, 10);    // b0,b3,b6,0,0, 0,0,0
-  v2 = _mm_slli_si128(v2, 4);       // 0,0, b0,b3,b6,0,0,0
-  v2 = _mm_or_si128(v2, tmp3);      // 0,0, b0,b3,b6,c1,c4,c7,
-  tmp0 = _mm_srli_si128(tmp0, 12);  // a2,a5,0,0,0,0,0,0
-  v2 = _mm_or_si128(v2, tmp0);      // a2,a5,b0,b3,b6,c1,c4,c7,
-  va = _mm_slli_epi16(v2, 8);
-  vb = _mm_srli_epi16(v2, 8);
-  v2 = _mm_or_si128(va, vb);
-  _mm256_stream_si256((__m256i *)B, _mm256_cvtepu16_epi32(v2));
-}
-
-#endif
\ No newline at end of file
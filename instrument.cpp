@@ -0,0 +1,157 @@
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "instrument.hpp"
+
+namespace instrument {
+
+static const char *const names[num_stages] = {"header", "read", "unpack", "xyb", "write"};
+
+#if defined(IMAGE_IO_INSTRUMENT)
+// stages are updated concurrently by the worker threads; totals only, so relaxed ordering suffices
+struct stage_counters {
+  std::atomic<uint64_t> ns{0};
+  std::atomic<uint64_t> bytes{0};
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> events[num_perf_events] = {};
+};
+static stage_counters counters[num_stages];
+
+static std::atomic<bool> perf_enabled{false};
+// opened lazily by each thread that times a stage
+static thread_local std::unique_ptr<perf_counters> thread_counters;
+
+static bool perf_on() { return perf_enabled.load(std::memory_order_relaxed); }
+
+static const perf_counters *get_thread_counters() {
+  if (!perf_on()) {
+    return nullptr;
+  }
+  if (!thread_counters) {
+    thread_counters = std::make_unique<perf_counters>();
+  }
+  return thread_counters.get();
+}
+
+bool enable_perf_counters() {
+  perf_enabled.store(true, std::memory_order_relaxed);
+  return get_thread_counters()->any_available();
+}
+
+bool perf_available(perf_event e) {
+  const perf_counters *pc = get_thread_counters();
+  return pc != nullptr && pc->available(e);
+}
+
+const char *perf_unavailable_reason() {
+  const perf_counters *pc = get_thread_counters();
+  return (pc != nullptr) ? pc->unavailable_reason() : "not enabled";
+}
+
+bool perf_snapshot(perf_sample &s) {
+  const perf_counters *pc = get_thread_counters();
+  if (pc == nullptr || !pc->any_available()) {
+    return false;
+  }
+  s = pc->read();
+  return true;
+}
+
+bool enabled() { return true; }
+
+stage_stats get(stage s) {
+  const stage_counters &c = counters[static_cast<size_t>(s)];
+  stage_stats st;
+  st.ns    = c.ns.load(std::memory_order_relaxed);
+  st.bytes = c.bytes.load(std::memory_order_relaxed);
+  st.calls = c.calls.load(std::memory_order_relaxed);
+  for (size_t e = 0; e < num_perf_events; ++e) {
+    st.events.val[e] = c.events[e].load(std::memory_order_relaxed);
+  }
+  return st;
+}
+
+void reset() {
+  for (auto &c : counters) {
+    c.ns.store(0, std::memory_order_relaxed);
+    c.bytes.store(0, std::memory_order_relaxed);
+    c.calls.store(0, std::memory_order_relaxed);
+    for (auto &e : c.events) {
+      e.store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+void add(stage s, uint64_t ns, uint64_t bytes, const perf_sample &events) {
+  stage_counters &c = counters[static_cast<size_t>(s)];
+  c.ns.fetch_add(ns, std::memory_order_relaxed);
+  c.bytes.fetch_add(bytes, std::memory_order_relaxed);
+  c.calls.fetch_add(1, std::memory_order_relaxed);
+  for (size_t e = 0; e < num_perf_events; ++e) {
+    c.events[e].fetch_add(events.val[e], std::memory_order_relaxed);
+  }
+}
+#else
+bool enabled() { return false; }
+stage_stats get(stage) { return stage_stats(); }
+void reset() {}
+void add(stage, uint64_t, uint64_t, const perf_sample &) {}
+bool enable_perf_counters() { return false; }
+bool perf_available(perf_event) { return false; }
+const char *perf_unavailable_reason() { return "built without IMAGE_IO_INSTRUMENT"; }
+bool perf_snapshot(perf_sample &) { return false; }
+static bool perf_on() { return false; }
+#endif
+
+const char *stage_name(stage s) {
+  return (s < stage::NUM_STAGES) ? names[static_cast<size_t>(s)] : "unknown";
+}
+
+std::string to_json() {
+  std::string json = std::string("{\"enabled\": ") + (enabled() ? "true" : "false") + ", \"stages\": {";
+  char entry[160];
+  const bool perf = perf_on();
+  for (size_t i = 0; i < num_stages; ++i) {
+    const stage_stats st = get(static_cast<stage>(i));
+    snprintf(entry, sizeof(entry),
+             "%s\"%s\": {\"ns\": %" PRIu64 ", \"bytes\": %" PRIu64 ", \"calls\": %" PRIu64, (i) ? ", " : "",
+             names[i], st.ns, st.bytes, st.calls);
+    json += entry;
+    if (perf) {
+      json += ", \"perf\": {";
+      for (size_t e = 0; e < num_perf_events; ++e) {
+        const auto ev = static_cast<perf_event>(e);
+        if (perf_available(ev)) {
+          snprintf(entry, sizeof(entry), "%s\"%s\": %" PRIu64, (e) ? ", " : "", perf_event_name(ev),
+                   st.events[ev]);
+        } else {
+          snprintf(entry, sizeof(entry), "%s\"%s\": null", (e) ? ", " : "", perf_event_name(ev));
+        }
+        json += entry;
+      }
+      json += "}";
+    }
+    json += "}";
+  }
+  return json + "}}";
+}
+
+int write_json(const std::string &filename) {
+  const std::string json = to_json();
+  if (filename == "-") {
+    printf("%s\n", json.c_str());
+    return EXIT_SUCCESS;
+  }
+  FILE *fp = fopen(filename.c_str(), "w");
+  if (fp == nullptr) {
+    printf("ERROR: cannot open %s for writing.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  const bool ok = fprintf(fp, "%s\n", json.c_str()) > 0;
+  return (fclose(fp) == 0 && ok) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+}  // namespace instrument
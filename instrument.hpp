@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#include "perf_counters.hpp"
+
+/********************************************************************************
+ * per-stage instrumentation of the decode/convert/encode pipeline
+ * each stage accumulates its duration, the bytes it processed and the number of
+ * calls; stages running on several threads accumulate the time of every thread
+ * optionally, the hardware counters of perf_counters.hpp are captured around
+ * each stage as well (per thread, see enable_perf_counters())
+ * built only with IMAGE_IO_INSTRUMENT defined (CMake option of the same name);
+ * otherwise stage_timer is empty and the queries return zeros
+ *******************************************************************************/
+namespace instrument {
+
+enum class stage : uint8_t { HEADER, READ, UNPACK, XYB, WRITE, NUM_STAGES };
+constexpr size_t num_stages = static_cast<size_t>(stage::NUM_STAGES);
+
+struct stage_stats {
+  uint64_t ns    = 0;
+  uint64_t bytes = 0;
+  uint64_t calls = 0;
+  perf_sample events;  // zero unless perf counters are enabled
+};
+
+// true if the library was built with IMAGE_IO_INSTRUMENT
+bool enabled();
+// name of s in the JSON output: header, read, unpack, xyb or write
+const char *stage_name(stage s);
+// accumulated statistics of s since the start or the last reset()
+stage_stats get(stage s);
+void reset();
+void add(stage s, uint64_t ns, uint64_t bytes, const perf_sample &events = perf_sample());
+
+/**
+ * @brief Capture the hardware counters around every stage from now on; each thread opens its own
+ * counters when it first times a stage
+ *
+ * @return true if at least one counter is available on the calling thread
+ */
+bool enable_perf_counters();
+// true if enable_perf_counters() was called and e is available on the calling thread
+bool perf_available(perf_event e);
+// why a counter of the calling thread is unavailable, nullptr if none is missing
+const char *perf_unavailable_reason();
+// counters of the calling thread; false if they are disabled or unavailable
+bool perf_snapshot(perf_sample &s);
+
+/**
+ * @brief Statistics of every stage as a JSON object
+ *
+ * {"enabled": true, "stages": {"header": {"ns": 1200, "bytes": 15, "calls": 1}, ...}}
+ * with perf counters enabled, each stage also has "perf": {"cycles": 5400, ...}, where unavailable
+ * counters are null
+ */
+std::string to_json();
+
+/**
+ * @brief Write to_json() to filename, "-" writes to stdout
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int write_json(const std::string &filename);
+
+#if defined(IMAGE_IO_INSTRUMENT)
+/**
+ * @brief Adds the time from construction to stop() (or destruction) and the given bytes to a stage
+ */
+class stage_timer {
+ private:
+  std::chrono::steady_clock::time_point start;
+  perf_sample start_events;
+  uint64_t bytes;
+  stage s;
+  bool running;
+  bool counting;
+
+ public:
+  explicit stage_timer(stage s, uint64_t bytes = 0) : bytes(bytes), s(s), running(true) {
+    counting = perf_snapshot(start_events);
+    start    = std::chrono::steady_clock::now();
+  }
+  stage_timer(const stage_timer &)            = delete;
+  stage_timer &operator=(const stage_timer &) = delete;
+  ~stage_timer() { stop(); }
+  void set_bytes(uint64_t val) { bytes = val; }
+  void stop() {
+    if (running) {
+      const auto duration = std::chrono::steady_clock::now() - start;
+      perf_sample events;
+      if (counting && perf_snapshot(events)) {
+        events = events - start_events;
+      }
+      add(s, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()),
+          bytes, events);
+      running = false;
+    }
+  }
+};
+#else
+class stage_timer {
+ public:
+  explicit stage_timer(stage, uint64_t = 0) {}
+  void set_bytes(uint64_t) {}
+  void stop() {}
+};
+#endif
+
+}  // namespace instrument
@@ -0,0 +1,57 @@
+// AVX-512 (F, BW, VL, VBMI) kernels: built with -mavx512f -mavx512bw -mavx512vl -mavx512vbmi, selected at
+// run time by simd_dispatch.cpp
+#include "RGB2XYB_avx512.hpp"
+#include "ascii_kernels.hpp"
+#include "pack_kernels.hpp"
+#include "resample_kernels.hpp"
+#include "simd_dispatch.hpp"
+#include "unpack_kernels.hpp"
+
+extern const kernel_table kernels_avx512;
+const kernel_table kernels_avx512 = {
+    simd_level::AVX512,
+    unpack_u8_to_s32,
+    unpack_s8_to_s32,
+    unpack_big_u16_to_s32,
+    unpack_little_u16_to_s32,
+    unpack_big_s16_to_s32,
+    unpack_little_s16_to_s32,
+    unpack_big_32_to_s32,
+    unpack_little_32_to_s32,
+    unpack_rgb_u8_to_s32,
+    unpack_rgb_big_u16_to_s32,
+    rgb2xyb_avx512<i32>,
+    unpack_rgb_u8_to_u8,
+    unpack_rgb_big_u16_to_u16,
+    unpack_big_16_to_16,
+    unpack_s8_to_s16,
+    unpack_rgba_u8_to_s32,
+    unpack_rgba_big_u16_to_s32,
+    unpack_rgba_u8_to_u8,
+    unpack_rgba_big_u16_to_u16,
+    box_accumulate,
+    box_pair_sum,
+    upsample_h2<uint8_t>,
+    upsample_h2<uint16_t>,
+    upsample_h2<int32_t>,
+    rgb2xyb_avx512<ui8>,
+    rgb2xyb_avx512<ui16>,
+    rgb2xyb_avx512<i32, cbrt_poly_avx512>,
+    rgb2xyb_avx512<ui8, cbrt_poly_avx512>,
+    rgb2xyb_avx512<ui16, cbrt_poly_avx512>,
+    rgb2xyb_lut3d_avx512<i32>,
+    rgb2xyb_lut3d_avx512<ui8>,
+    rgb2xyb_lut3d_avx512<ui16>,
+    pack_s32_to_u8,
+    pack_s32_to_s8,
+    pack_s32_to_big_u16,
+    pack_s32_to_big_s16,
+    pack_s32_to_big_s32,
+    pack_s16_to_s8,
+    pack_rgb_s32_to_u8,
+    pack_rgb_s32_to_big_u16,
+    pack_rgb_u8_to_u8,
+    pack_rgb_u16_to_big_u16,
+    parse_ascii_to_u8,
+    parse_ascii_to_big_u16,
+};
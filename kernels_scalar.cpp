@@ -0,0 +1,68 @@
+// baseline kernels: built without extra target flags (NEON is part of the baseline on ARM)
+#include "RGB2XYB.hpp"
+#include "ascii_kernels.hpp"
+#include "pack_kernels.hpp"
+#include "resample_kernels.hpp"
+#include "simd_dispatch.hpp"
+#include "unpack_kernels.hpp"
+#include "xyb_lut3d.hpp"
+
+// exhaustive proof of the accuracy of the polynomial cube root; the loop over all 65536 inputs exceeds
+// the default constexpr step limits of Clang and MSVC, the bench checks it at run time there
+#if defined(__GNUC__) && !defined(__clang__)
+static_assert(cbrt_poly_within(1), "cbrt_poly() differs from the rounded cubic root by more than 1");
+static_assert(cbrt_poly_matches_tbl(1), "cbrt_poly() differs from tbl_cbrt by more than 1");
+#endif
+
+extern const kernel_table kernels_scalar;
+const kernel_table kernels_scalar = {
+#if defined(USE_ARM_NEON)
+    simd_level::NEON,
+#else
+    simd_level::SCALAR,
+#endif
+    unpack_u8_to_s32,
+    unpack_s8_to_s32,
+    unpack_big_u16_to_s32,
+    unpack_little_u16_to_s32,
+    unpack_big_s16_to_s32,
+    unpack_little_s16_to_s32,
+    unpack_big_32_to_s32,
+    unpack_little_32_to_s32,
+    unpack_rgb_u8_to_s32,
+    unpack_rgb_big_u16_to_s32,
+    rgb2xyb_scalar<cbrt_lut256, i32>,
+    unpack_rgb_u8_to_u8,
+    unpack_rgb_big_u16_to_u16,
+    unpack_big_16_to_16,
+    unpack_s8_to_s16,
+    unpack_rgba_u8_to_s32,
+    unpack_rgba_big_u16_to_s32,
+    unpack_rgba_u8_to_u8,
+    unpack_rgba_big_u16_to_u16,
+    box_accumulate,
+    box_pair_sum,
+    upsample_h2<uint8_t>,
+    upsample_h2<uint16_t>,
+    upsample_h2<int32_t>,
+    rgb2xyb_scalar<cbrt_lut256, ui8>,
+    rgb2xyb_scalar<cbrt_lut256, ui16>,
+    rgb2xyb_scalar<cbrt_polynomial, i32>,
+    rgb2xyb_scalar<cbrt_polynomial, ui8>,
+    rgb2xyb_scalar<cbrt_polynomial, ui16>,
+    rgb2xyb_lut3d_scalar<i32>,
+    rgb2xyb_lut3d_scalar<ui8>,
+    rgb2xyb_lut3d_scalar<ui16>,
+    pack_s32_to_u8,
+    pack_s32_to_s8,
+    pack_s32_to_big_u16,
+    pack_s32_to_big_s16,
+    pack_s32_to_big_s32,
+    pack_s16_to_s8,
+    pack_rgb_s32_to_u8,
+    pack_rgb_s32_to_big_u16,
+    pack_rgb_u8_to_u8,
+    pack_rgb_u16_to_big_u16,
+    parse_ascii_to_u8,
+    parse_ascii_to_big_u16,
+};
@@ -0,0 +1,58 @@
+// SSE4.1 kernels: built with -msse4.1, selected at run time by simd_dispatch.cpp
+#include "RGB2XYB_sse41.hpp"
+#include "ascii_kernels.hpp"
+#include "pack_kernels.hpp"
+#include "resample_kernels.hpp"
+#include "simd_dispatch.hpp"
+#include "unpack_kernels.hpp"
+#include "xyb_lut3d.hpp"
+
+extern const kernel_table kernels_sse41;
+const kernel_table kernels_sse41 = {
+    simd_level::SSE41,
+    unpack_u8_to_s32,
+    unpack_s8_to_s32,
+    unpack_big_u16_to_s32,
+    unpack_little_u16_to_s32,
+    unpack_big_s16_to_s32,
+    unpack_little_s16_to_s32,
+    unpack_big_32_to_s32,
+    unpack_little_32_to_s32,
+    unpack_rgb_u8_to_s32,
+    unpack_rgb_big_u16_to_s32,
+    rgb2xyb_sse41<i32>,
+    unpack_rgb_u8_to_u8,
+    unpack_rgb_big_u16_to_u16,
+    unpack_big_16_to_16,
+    unpack_s8_to_s16,
+    unpack_rgba_u8_to_s32,
+    unpack_rgba_big_u16_to_s32,
+    unpack_rgba_u8_to_u8,
+    unpack_rgba_big_u16_to_u16,
+    box_accumulate,
+    box_pair_sum,
+    upsample_h2<uint8_t>,
+    upsample_h2<uint16_t>,
+    upsample_h2<int32_t>,
+    rgb2xyb_sse41<ui8>,
+    rgb2xyb_sse41<ui16>,
+    rgb2xyb_sse41<i32, cbrt_poly_sse41>,
+    rgb2xyb_sse41<ui8, cbrt_poly_sse41>,
+    rgb2xyb_sse41<ui16, cbrt_poly_sse41>,
+    // no gather in SSE4.1: the lattice lookups stay scalar
+    rgb2xyb_lut3d_scalar<i32>,
+    rgb2xyb_lut3d_scalar<ui8>,
+    rgb2xyb_lut3d_scalar<ui16>,
+    pack_s32_to_u8,
+    pack_s32_to_s8,
+    pack_s32_to_big_u16,
+    pack_s32_to_big_s16,
+    pack_s32_to_big_s32,
+    pack_s16_to_s8,
+    pack_rgb_s32_to_u8,
+    pack_rgb_s32_to_big_u16,
+    pack_rgb_u8_to_u8,
+    pack_rgb_u16_to_big_u16,
+    parse_ascii_to_u8,
+    parse_ascii_to_big_u16,
+};
@@ -1,49 +1,268 @@
-#include <chrono>
+#include <cinttypes>
 #include <cstdio>
 #include <string>
 #if defined(USE_OPENCV)
   #include <opencv2/highgui.hpp>
 #endif
+#include "batch_convert.hpp"
 #include "image_io.hpp"
-#include "RGB2XYB.hpp"
-int main(int argc, char *argv[]) {
-  if (argc < 2) {
-    printf("ERROR: At least one input image is required.\n");
-    exit(EXIT_FAILURE);
+#include "xyb_convert.hpp"
+
+// hardware counters of every stage per pixel of the image; "-" marks an unavailable counter
+static void print_perf_counters(double pixels) {
+  bool any = false;
+  for (size_t e = 0; e < num_perf_events; ++e) {
+    any = any || instrument::perf_available(static_cast<perf_event>(e));
+  }
+  if (!any) {
+    return;
+  }
+  printf("%-7s", "per px");
+  for (size_t e = 0; e < num_perf_events; ++e) {
+    printf(" %13s", perf_event_name(static_cast<perf_event>(e)));
+  }
+  printf("\n");
+  for (size_t i = 0; i < instrument::num_stages; ++i) {
+    const auto s                     = static_cast<instrument::stage>(i);
+    const instrument::stage_stats st = instrument::get(s);
+    printf("%-7s", instrument::stage_name(s));
+    for (size_t e = 0; e < num_perf_events; ++e) {
+      if (instrument::perf_available(static_cast<perf_event>(e))) {
+        printf(" %13.4f", st.events.val[e] / pixels);
+      } else {
+        printf(" %13s", "-");
+      }
+    }
+    printf("\n");
   }
-  auto start = std::chrono::high_resolution_clock::now();
+}
+
+// per-stage statistics of instrument.hpp; range is omitted if null
+static void print_stats(const thread_pool &pool, double pixels, const xyb_stats *range) {
+  // times of stages running on the pool are summed over its threads
+  printf("%zu threads, SIMD = %s\n", pool.get_num_threads(), simd_level_name(get_simd_level()));
+  if (!instrument::enabled()) {
+    printf("per-stage statistics are not available (built without IMAGE_IO_INSTRUMENT)\n");
+  }
+  for (size_t i = 0; i < instrument::num_stages && instrument::enabled(); ++i) {
+    const auto s                     = static_cast<instrument::stage>(i);
+    const instrument::stage_stats st = instrument::get(s);
+    printf("%-7s %12.3f[ms] %10.1f[MB/s] %6" PRIu64 " calls\n", instrument::stage_name(s), st.ns / 1.0e6,
+           (st.ns) ? st.bytes * 1.0e3 / st.ns : 0.0, st.calls);
+  }
+  if (pixels > 0.0) {
+    print_perf_counters(pixels);
+  }
+  if (range != nullptr) {
+    range->print();
+  }
+}
+
+int main(int argc, char *argv[]) {
+  // -t <num>: number of threads for RGB2XYB (0 = number of hardware threads)
+  // -s: decode a single PPM into RGB planes first instead of the fused PPM to XYB path
+  // -n: keep decoded planes in 8/16-bit samples instead of int32 (separate path)
+  // -v: print the per-stage statistics and the range of the XYB mixing values
+  // -j <file>: write the per-stage statistics as JSON ("-" = stdout)
+  // -p: capture hardware performance counters per stage (Linux perf_event_open)
+  // -b <dir or list>: batch mode, convert every PPM in dir or every image of the list file
+  //                   (one per line, files of one image separated by whitespace)
+  // -o <dir>: output directory of the batch mode (default: directory of each input)
+  // -q <num>: images buffered between the read, convert and write stages of the batch mode
+  // -a: batch mode reads through io_uring (or pread threads where unavailable) instead of mmap
+  // -c <method>: cube root of the XYB transfer function: lut256 (default), lut1024, newton16,
+  //              newton32, exact or poly (see cbrt_policy.hpp)
+  // -l <grid>: 8 - 10 bpp inputs go through the 3D LUT of xyb_lut3d.hpp with 17 or 33 nodes per axis
+  // -r <x>,<y>,<w>,<h>: convert only the window of w x h pixels at (x, y), read with positioned reads
+  // -d <factor>: convert a thumbnail, each block of factor x factor pixels (2, 4 or 8) averaged while
+  //              reading
+  // -x <422|420>: write X and B halved horizontally (4:2:2) or in both directions (4:2:0)
+  size_t num_threads        = 0;
+  bool separate             = false;
+  bool narrow               = false;
+  bool verbose              = false;
+  bool perf                 = false;
+  cbrt_method cbrt          = cbrt_method::LUT256;
+  i32 lut3d_grid            = 0;
+  bool cropped              = false;
+  image_roi roi             = {0, 0, 0, 0};
+  uint32_t reduction        = 1;
+  chroma_subsampling chroma = chroma_subsampling::S444;
+  std::string json_name;
+  std::string batch_path;
+  batch_options batch_opt;
   std::vector<std::string> fnames;
   for (int i = 1; i < argc; ++i) {
+    if (std::string(argv[i]) == "-t" && i + 1 < argc) {
+      num_threads = std::stoul(argv[++i]);
+      continue;
+    }
+    if (std::string(argv[i]) == "-s") {
+      separate = true;
+      continue;
+    }
+    if (std::string(argv[i]) == "-n") {
+      narrow = true;
+      continue;
+    }
+    if (std::string(argv[i]) == "-v") {
+      verbose = true;
+      continue;
+    }
+    if (std::string(argv[i]) == "-p") {
+      perf = true;
+      continue;
+    }
+    if (std::string(argv[i]) == "-j" && i + 1 < argc) {
+      json_name = argv[++i];
+      continue;
+    }
+    if (std::string(argv[i]) == "-b" && i + 1 < argc) {
+      batch_path = argv[++i];
+      continue;
+    }
+    if (std::string(argv[i]) == "-o" && i + 1 < argc) {
+      batch_opt.out_dir = argv[++i];
+      continue;
+    }
+    if (std::string(argv[i]) == "-a") {
+      batch_opt.async_io = true;
+      continue;
+    }
+    if (std::string(argv[i]) == "-c" && i + 1 < argc) {
+      if (!parse_cbrt_method(argv[++i], cbrt)) {
+        printf("ERROR: unknown cube root method %s.\n", argv[i]);
+        exit(EXIT_FAILURE);
+      }
+      continue;
+    }
+    if (std::string(argv[i]) == "-l" && i + 1 < argc) {
+      lut3d_grid = std::stoi(argv[++i]);
+      if (lut3d_grid != 17 && lut3d_grid != 33) {
+        printf("ERROR: 3D LUT grid shall be 17 or 33.\n");
+        exit(EXIT_FAILURE);
+      }
+      continue;
+    }
+    if (std::string(argv[i]) == "-r" && i + 1 < argc) {
+      if (sscanf(argv[++i], "%u,%u,%u,%u", &roi.x0, &roi.y0, &roi.width, &roi.height) != 4) {
+        printf("ERROR: window shall be given as x,y,w,h.\n");
+        exit(EXIT_FAILURE);
+      }
+      cropped = true;
+      continue;
+    }
+    if (std::string(argv[i]) == "-d" && i + 1 < argc) {
+      reduction = static_cast<uint32_t>(std::stoul(argv[++i]));
+      if (reduction != 2 && reduction != 4 && reduction != 8) {
+        printf("ERROR: reduction factor shall be 2, 4 or 8.\n");
+        exit(EXIT_FAILURE);
+      }
+      continue;
+    }
+    if (std::string(argv[i]) == "-x" && i + 1 < argc) {
+      const std::string layout = argv[++i];
+      if (layout == "422") {
+        chroma = chroma_subsampling::S422;
+      } else if (layout == "420") {
+        chroma = chroma_subsampling::S420;
+      } else {
+        printf("ERROR: chroma subsampling shall be 422 or 420.\n");
+        exit(EXIT_FAILURE);
+      }
+      continue;
+    }
+    if (std::string(argv[i]) == "-q" && i + 1 < argc) {
+      batch_opt.queue_depth = std::stoul(argv[++i]);
+      continue;
+    }
     fnames.push_back(argv[i]);
   }
-  image img(fnames);
-  auto duration = std::chrono::high_resolution_clock::now() - start;
-  auto count    = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
-  double time   = count / 1000.0;
-  printf("elapsed time %-15.3lf[ms]\n", time);
-  printf("number of components: %d\n", img.get_num_components());
-  for (int i = 0; i < img.get_num_components(); ++i) {
-    uint8_t bpp = (img.get_Ssiz_value(i) & 0x7F) + 1;
-    uint8_t s   = (img.get_Ssiz_value(i) & 0x80) >> 7;
-    printf("component[%d]: width = %4d, height = %4d, %2d bpp, signed = %d\n", i,
-           img.get_component_width(i), img.get_component_height(i), bpp, s);
-  }
-  image out(img.get_width(), img.get_height(), img.get_num_components(), img.get_max_bpp(), false);
-  start = std::chrono::high_resolution_clock::now();
-  rgb2xyb(img, out);
-  duration = std::chrono::high_resolution_clock::now() - start;
-  count    = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
-  time     = count / 1000.0;
-  printf("RGB2XYB elapsed time %-15.3lf[ms]\n", time);
+  if (fnames.empty() && batch_path.empty()) {
+    printf("ERROR: At least one input image is required.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (cropped && reduction > 1) {
+    printf("ERROR: -r and -d cannot be combined.\n");
+    exit(EXIT_FAILURE);
+  }
+  if (perf && !instrument::enable_perf_counters()) {
+    printf("hardware performance counters are unavailable: %s\n", instrument::perf_unavailable_reason());
+  }
+  thread_pool pool(num_threads);
+  if (!batch_path.empty()) {
+    std::vector<batch_input> inputs;
+    if (collect_batch_inputs(batch_path, inputs)) {
+      exit(EXIT_FAILURE);
+    }
+    batch_opt.storage    = (narrow) ? sample_storage::NARROW : sample_storage::INT32;
+    batch_opt.cbrt       = cbrt;
+    batch_opt.lut3d_grid = lut3d_grid;
+    batch_opt.chroma     = chroma;
+    batch_result result;
+    const int status = batch_convert(inputs, batch_opt, pool, &result);
+    printf("%zu of %zu images converted\n", result.converted, inputs.size());
+    if (verbose) {
+      print_stats(pool, static_cast<double>(result.pixels), nullptr);
+      printf("reader: %s\n", result.reader);
+      const plane_pool_stats &ps = result.pool_stats;
+      printf("plane pool: %" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " dropped, peak %.1f MiB used\n",
+             ps.hits, ps.misses, ps.dropped, ps.peak_use_bytes / 1048576.0);
+    }
+    if (!json_name.empty() && instrument::write_json(json_name)) {
+      exit(EXIT_FAILURE);
+    }
+    return status;
+  }
+  std::unique_ptr<image> out;
+  xyb_stats range;
+  const bool fused = fnames.size() == 1 && fnames[0].size() > 4
+                     && fnames[0].compare(fnames[0].size() - 4, 4, ".ppm") == 0 && !separate && !cropped
+                     && reduction == 1 && chroma == chroma_subsampling::S444;
+  if (fused) {
+    // a single PPM input is converted without intermediate RGB planes
+    if (ppm2xyb(fnames[0], out, pool, io_mode::MMAP, &range, xyb_method(cbrt, lut3d_grid))) {
+      exit(EXIT_FAILURE);
+    }
+  } else {
+    std::unique_ptr<image> in;
+    try {
+      const sample_storage storage = (narrow) ? sample_storage::NARROW : sample_storage::INT32;
+      in = (cropped) ? std::make_unique<image>(fnames, roi, storage)
+                     : std::make_unique<image>(fnames, io_mode::MMAP, storage, nullptr, &pool, reduction);
+    } catch (const image_read_error &) {
+      exit(EXIT_FAILURE);
+    }
+    const image &img = *in;
+    printf("number of components: %d\n", img.get_num_components());
+    for (int i = 0; i < img.get_num_components(); ++i) {
+      uint8_t bpp = (img.get_Ssiz_value(i) & 0x7F) + 1;
+      uint8_t s   = (img.get_Ssiz_value(i) & 0x80) >> 7;
+      printf("component[%d]: width = %4d, height = %4d, %2d bpp, signed = %d\n", i,
+             img.get_component_width(i), img.get_component_height(i), bpp, s);
+    }
+    if (chroma == chroma_subsampling::S444) {
+      out = std::make_unique<image>(img.get_width(), img.get_height(), img.get_num_components(), xyb_bpp,
+                                    true);
+    } else {
+      out = std::make_unique<image>(img.get_width(), img.get_height(), chroma, xyb_bpp, true);
+    }
+    rgb2xyb_parallel(*in, *out, pool, &range, xyb_method(cbrt, lut3d_grid));
+  }
 
   char outname[256];
-  for (int c = 0; c < out.get_num_components(); ++c) {
-    auto p = out.get_buf(c);
+  for (int c = 0; c < out->get_num_components(); ++c) {
     snprintf(outname, 256, "xyb_out_%02d.pgx", c);
-    FILE *fp = fopen(outname, "wb");
-    fprintf(fp, "PG LM -32 %d %d\n", out.get_width(), out.get_height());
-    fwrite(p, sizeof(int32_t), out.get_width() * out.get_height(), fp);
-    fclose(fp);
+    if (out->write_pgx(c, outname)) {
+      exit(EXIT_FAILURE);
+    }
+  }
+
+  if (verbose) {
+    print_stats(pool, static_cast<double>(out->get_width()) * out->get_height(), &range);
+  }
+  if (!json_name.empty() && instrument::write_json(json_name)) {
+    exit(EXIT_FAILURE);
   }
 #if defined(USE_OPENCV)
   // cv::Mat test(img.get_component_height(0), img.get_component_width(0), CV_8UC1);
@@ -0,0 +1,468 @@
+#pragma once
+/********************************************************************************
+ * SIMD pack kernels (PGM/PGX narrowing, PPM re-interleave)
+ * counterpart of unpack_kernels.hpp, included by the kernels_*.cpp translation
+ * units after it; samples are saturated to the range of the output container
+ * (8, 16 or 32 bits), 16- and 32-bit samples are written in big-endian order
+ *******************************************************************************/
+#include <cstddef>
+#include <cstdint>
+
+#include "unpack_kernels.hpp"
+
+static inline uint8_t sat_u8(int32_t v) {
+  return static_cast<uint8_t>((v < 0) ? 0 : (v > 255) ? 255 : v);
+}
+static inline int8_t sat_s8(int32_t v) {
+  return static_cast<int8_t>((v < -128) ? -128 : (v > 127) ? 127 : v);
+}
+static inline uint16_t sat_u16(int32_t v) {
+  return static_cast<uint16_t>((v < 0) ? 0 : (v > 65535) ? 65535 : v);
+}
+static inline int16_t sat_s16(int32_t v) {
+  return static_cast<int16_t>((v < -32768) ? -32768 : (v > 32767) ? 32767 : v);
+}
+static inline void put_big16(uint8_t *dst, uint16_t v) {
+  dst[0] = static_cast<uint8_t>(v >> 8);
+  dst[1] = static_cast<uint8_t>(v);
+}
+
+#if defined(USE_ARM_NEON)
+// 16 x int32 into 16 x uint8 with unsigned saturation
+static inline uint8x16_t narrow_s32_to_u8(const int32_t *src) {
+  uint16x8_t l = vcombine_u16(vqmovun_s32(vld1q_s32(src)), vqmovun_s32(vld1q_s32(src + 4)));
+  uint16x8_t h = vcombine_u16(vqmovun_s32(vld1q_s32(src + 8)), vqmovun_s32(vld1q_s32(src + 12)));
+  return vcombine_u8(vqmovn_u16(l), vqmovn_u16(h));
+}
+
+// 8 x int32 into 8 x uint16 (big-endian) with unsigned saturation
+static inline uint16x8_t narrow_s32_to_big_u16(const int32_t *src) {
+  uint16x8_t v = vcombine_u16(vqmovun_s32(vld1q_s32(src)), vqmovun_s32(vld1q_s32(src + 4)));
+  return vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(v)));
+}
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+// 16 x int32 into 16 x uint8 with unsigned saturation
+static inline __m128i narrow_s32_to_u8(const int32_t *src) {
+  const __m128i *p = (const __m128i *)src;
+  __m128i l        = _mm_packs_epi32(_mm_loadu_si128(p), _mm_loadu_si128(p + 1));
+  __m128i h        = _mm_packs_epi32(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3));
+  return _mm_packus_epi16(l, h);
+}
+
+// 8 x int32 into 8 x uint16 with unsigned saturation (native byte order)
+static inline __m128i narrow_s32_to_u16(const int32_t *src) {
+  const __m128i *p = (const __m128i *)src;
+  return _mm_packus_epi32(_mm_loadu_si128(p), _mm_loadu_si128(p + 1));
+}
+
+/**
+ * @brief pshufb masks that merge three vectors of channel samples into three vectors of interleaved RGB
+ * samples: out[j] = OR over ch of shuffle(channel[ch], m[j][ch]); with swap set, the two bytes of each
+ * 16-bit sample are exchanged (big-endian output)
+ */
+struct rgb_merge_idx {
+  alignas(16) int8_t m[3][3][16];
+};
+static constexpr rgb_merge_idx make_rgb_merge_idx(int bytes, bool swap) {
+  rgb_merge_idx t{};
+  for (int j = 0; j < 3; ++j) {
+    for (int k = 0; k < 16; ++k) {
+      const int pos    = 16 * j + k;  // output byte
+      const int sample = pos / bytes;
+      const int b      = (swap) ? bytes - 1 - pos % bytes : pos % bytes;
+      for (int ch = 0; ch < 3; ++ch) {
+        t.m[j][ch][k] = (sample % 3 == ch) ? static_cast<int8_t>(bytes * (sample / 3) + b) : int8_t(-128);
+      }
+    }
+  }
+  return t;
+}
+static constexpr rgb_merge_idx rgb_merge_u8      = make_rgb_merge_idx(1, false);
+static constexpr rgb_merge_idx rgb_merge_big_u16 = make_rgb_merge_idx(2, true);
+
+// interleave three vectors of channel samples (16 x 8-bit or 8 x 16-bit) into 48 bytes
+static inline void interleave_rgb(const rgb_merge_idx &idx, __m128i r, __m128i g, __m128i b, uint8_t *dst) {
+  for (int j = 0; j < 3; ++j) {
+    __m128i v = _mm_shuffle_epi8(r, *(const __m128i *)idx.m[j][0]);
+    v         = _mm_or_si128(v, _mm_shuffle_epi8(g, *(const __m128i *)idx.m[j][1]));
+    v         = _mm_or_si128(v, _mm_shuffle_epi8(b, *(const __m128i *)idx.m[j][2]));
+    _mm_storeu_si128((__m128i *)(dst + 16 * j), v);
+  }
+}
+
+  #if defined(__AVX512BW__)
+// 16 x int32 into 16 x uint8 / uint16 with unsigned saturation
+static inline __m128i narrow_s32_to_u8_avx512(const int32_t *src) {
+  const __m512i v = _mm512_max_epi32(_mm512_loadu_si512((const void *)src), _mm512_setzero_si512());
+  return _mm512_cvtusepi32_epi8(v);
+}
+static inline __m256i narrow_s32_to_u16_avx512(const int32_t *src) {
+  const __m512i v = _mm512_max_epi32(_mm512_loadu_si512((const void *)src), _mm512_setzero_si512());
+  return _mm512_cvtusepi32_epi16(v);
+}
+// 64 x int32 into 64 x uint8
+static inline __m512i narrow64_s32_to_u8_avx512(const int32_t *src) {
+  __m512i v = _mm512_castsi128_si512(narrow_s32_to_u8_avx512(src));
+  v         = _mm512_inserti32x4(v, narrow_s32_to_u8_avx512(src + 16), 1);
+  v         = _mm512_inserti32x4(v, narrow_s32_to_u8_avx512(src + 32), 2);
+  return _mm512_inserti32x4(v, narrow_s32_to_u8_avx512(src + 48), 3);
+}
+// 32 x int32 into 32 x uint16
+static inline __m512i narrow32_s32_to_u16_avx512(const int32_t *src) {
+  return _mm512_inserti64x4(_mm512_castsi256_si512(narrow_s32_to_u16_avx512(src)),
+                            narrow_s32_to_u16_avx512(src + 16), 1);
+}
+
+/**
+ * @brief permutation indices that merge three channel vectors (r, g, b) into interleaved RGB: lanes of
+ * r or g are gathered with a two-source permute by rg[j], the remaining lanes (set in mask_b[j]) are
+ * taken from b by b[j]; inverse of rgb_split_u16_idx
+ */
+struct rgb_merge_u16_idx {
+  alignas(64) uint16_t rg[3][32];
+  alignas(64) uint16_t b[3][32];
+  uint32_t mask_b[3];
+};
+static constexpr rgb_merge_u16_idx make_rgb_merge_u16_idx() {
+  rgb_merge_u16_idx t{};
+  for (int j = 0; j < 3; ++j) {
+    for (int i = 0; i < 32; ++i) {
+      const int pos = 32 * j + i;
+      const int px  = pos / 3;
+      t.rg[j][i]    = static_cast<uint16_t>(px + ((pos % 3 == 1) ? 32 : 0));
+      t.b[j][i]     = static_cast<uint16_t>(px);
+      if (pos % 3 == 2) {
+        t.mask_b[j] |= uint32_t(1) << i;
+      }
+    }
+  }
+  return t;
+}
+static constexpr rgb_merge_u16_idx rgb_merge_u16 = make_rgb_merge_u16_idx();
+
+// merge 32 pixels of native-endian channels (vpermt2w + vpermw) into big-endian RGB
+static inline void interleave_rgb_u16_avx512(const __m512i v[3], uint8_t *dst) {
+  for (int j = 0; j < 3; ++j) {
+    __m512i o = _mm512_permutex2var_epi16(v[0], _mm512_load_si512((const void *)rgb_merge_u16.rg[j]), v[1]);
+    o         = _mm512_mask_permutexvar_epi16(o, rgb_merge_u16.mask_b[j],
+                                              _mm512_load_si512((const void *)rgb_merge_u16.b[j]), v[2]);
+    _mm512_storeu_si512((void *)(dst + 64 * j), swap16_avx512(o));
+  }
+}
+  #endif
+
+  #if defined(__AVX512VBMI__)
+// byte-granular counterpart of rgb_merge_u16_idx
+struct rgb_merge_u8_idx {
+  alignas(64) uint8_t rg[3][64];
+  alignas(64) uint8_t b[3][64];
+  uint64_t mask_b[3];
+};
+static constexpr rgb_merge_u8_idx make_rgb_merge_u8_idx() {
+  rgb_merge_u8_idx t{};
+  for (int j = 0; j < 3; ++j) {
+    for (int i = 0; i < 64; ++i) {
+      const int pos = 64 * j + i;
+      const int px  = pos / 3;
+      t.rg[j][i]    = static_cast<uint8_t>(px + ((pos % 3 == 1) ? 64 : 0));
+      t.b[j][i]     = static_cast<uint8_t>(px);
+      if (pos % 3 == 2) {
+        t.mask_b[j] |= uint64_t(1) << i;
+      }
+    }
+  }
+  return t;
+}
+static constexpr rgb_merge_u8_idx rgb_merge_u8_avx512 = make_rgb_merge_u8_idx();
+
+// merge 64 pixels (vpermt2b + vpermb) into interleaved RGB
+static inline void interleave_rgb_u8_avx512(const __m512i v[3], uint8_t *dst) {
+  for (int j = 0; j < 3; ++j) {
+    const rgb_merge_u8_idx &idx = rgb_merge_u8_avx512;
+    __m512i o = _mm512_permutex2var_epi8(v[0], _mm512_load_si512((const void *)idx.rg[j]), v[1]);
+    o = _mm512_mask_permutexvar_epi8(o, idx.mask_b[j], _mm512_load_si512((const void *)idx.b[j]), v[2]);
+    _mm512_storeu_si512((void *)(dst + 64 * j), o);
+  }
+}
+  #endif
+#endif
+
+// int32 samples into 8-bit unsigned samples (PGM/PGX)
+static void pack_s32_to_u8(const int32_t *src, uint8_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    vst1q_u8(dst + i, narrow_s32_to_u8(src + i));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 64; i += 64) {
+    _mm512_storeu_si512((void *)(dst + i), narrow64_s32_to_u8_avx512(src + i));
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    _mm_storeu_si128((__m128i *)(dst + i), narrow_s32_to_u8(src + i));
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = sat_u8(src[i]);
+  }
+}
+
+// int32 samples into 8-bit signed samples (PGX)
+static void pack_s32_to_s8(const int32_t *src, uint8_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    int16x8_t l = vcombine_s16(vqmovn_s32(vld1q_s32(src + i)), vqmovn_s32(vld1q_s32(src + i + 4)));
+    int16x8_t h = vcombine_s16(vqmovn_s32(vld1q_s32(src + i + 8)), vqmovn_s32(vld1q_s32(src + i + 12)));
+    vst1q_s8((int8_t *)(dst + i), vcombine_s8(vqmovn_s16(l), vqmovn_s16(h)));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 16; i += 16) {
+    const __m512i v = _mm512_loadu_si512((const void *)(src + i));
+    _mm_storeu_si128((__m128i *)(dst + i), _mm512_cvtsepi32_epi8(v));
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    const __m128i *p = (const __m128i *)(src + i);
+    __m128i l        = _mm_packs_epi32(_mm_loadu_si128(p), _mm_loadu_si128(p + 1));
+    __m128i h        = _mm_packs_epi32(_mm_loadu_si128(p + 2), _mm_loadu_si128(p + 3));
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi16(l, h));
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = static_cast<uint8_t>(sat_s8(src[i]));
+  }
+}
+
+// int32 samples into 16-bit big-endian unsigned samples (PGM/PGX)
+static void pack_s32_to_big_u16(const int32_t *src, uint8_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    vst1q_u16((uint16_t *)(dst + 2 * i), narrow_s32_to_big_u16(src + i));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    _mm512_storeu_si512((void *)(dst + 2 * i), swap16_avx512(narrow32_s32_to_u16_avx512(src + i)));
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    _mm_storeu_si128((__m128i *)(dst + 2 * i),
+                     _mm_shuffle_epi8(narrow_s32_to_u16(src + i), *(const __m128i *)mask16_swap));
+  }
+#endif
+  for (; i < len; ++i) {
+    put_big16(dst + 2 * i, sat_u16(src[i]));
+  }
+}
+
+// int32 samples into 16-bit big-endian signed samples (PGX)
+static void pack_s32_to_big_s16(const int32_t *src, uint8_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    int16x8_t v = vcombine_s16(vqmovn_s32(vld1q_s32(src + i)), vqmovn_s32(vld1q_s32(src + i + 4)));
+    vst1q_u8(dst + 2 * i, vrev16q_u8(vreinterpretq_u8_s16(v)));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    __m512i v = _mm512_castsi256_si512(_mm512_cvtsepi32_epi16(_mm512_loadu_si512((const void *)(src + i))));
+    v = _mm512_inserti64x4(v, _mm512_cvtsepi32_epi16(_mm512_loadu_si512((const void *)(src + i + 16))), 1);
+    _mm512_storeu_si512((void *)(dst + 2 * i), swap16_avx512(v));
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    const __m128i *p = (const __m128i *)(src + i);
+    __m128i v        = _mm_packs_epi32(_mm_loadu_si128(p), _mm_loadu_si128(p + 1));
+    _mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_shuffle_epi8(v, *(const __m128i *)mask16_swap));
+  }
+#endif
+  for (; i < len; ++i) {
+    put_big16(dst + 2 * i, static_cast<uint16_t>(sat_s16(src[i])));
+  }
+}
+
+// int32 samples into 32-bit big-endian samples (PGX deeper than 16 bits)
+static void pack_s32_to_big_s32(const int32_t *src, uint8_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 4; i += 4) {
+    vst1q_u8(dst + 4 * i, vrev32q_u8(vreinterpretq_u8_s32(vld1q_s32(src + i))));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  alignas(16) static const int8_t mask32_swap[16] = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+  #if defined(__AVX512BW__)
+  const __m512i swap512 = _mm512_broadcast_i32x4(*(const __m128i *)mask32_swap);
+  for (; i < len - len % 16; i += 16) {
+    _mm512_storeu_si512((void *)(dst + 4 * i),
+                        _mm512_shuffle_epi8(_mm512_loadu_si512((const void *)(src + i)), swap512));
+  }
+  #endif
+  for (; i < len - len % 4; i += 4) {
+    _mm_storeu_si128((__m128i *)(dst + 4 * i), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i)),
+                                                                *(const __m128i *)mask32_swap));
+  }
+#endif
+  for (; i < len; ++i) {
+    const uint32_t v = static_cast<uint32_t>(src[i]);
+    dst[4 * i]       = static_cast<uint8_t>(v >> 24);
+    dst[4 * i + 1]   = static_cast<uint8_t>(v >> 16);
+    dst[4 * i + 2]   = static_cast<uint8_t>(v >> 8);
+    dst[4 * i + 3]   = static_cast<uint8_t>(v);
+  }
+}
+
+// 16-bit signed samples into 8-bit signed samples (PGX held in narrow planes)
+static void pack_s16_to_s8(const int16_t *src, uint8_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    vst1_s8((int8_t *)(dst + i), vqmovn_s16(vld1q_s16(src + i)));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  for (; i < len - len % 16; i += 16) {
+    const __m128i *p = (const __m128i *)(src + i);
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_packs_epi16(_mm_loadu_si128(p), _mm_loadu_si128(p + 1)));
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = static_cast<uint8_t>(sat_s8(src[i]));
+  }
+}
+
+// three int32 planes into interleaved 8-bit RGB samples (PPM)
+static void pack_rgb_s32_to_u8(const int32_t *R, const int32_t *G, const int32_t *B, uint8_t *dst,
+                               size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    uint8x16x3_t v;
+    v.val[0] = narrow_s32_to_u8(R + i);
+    v.val[1] = narrow_s32_to_u8(G + i);
+    v.val[2] = narrow_s32_to_u8(B + i);
+    vst3q_u8(dst + 3 * i, v);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512VBMI__)
+  for (; i < len - len % 64; i += 64) {
+    const __m512i v[3] = {narrow64_s32_to_u8_avx512(R + i), narrow64_s32_to_u8_avx512(G + i),
+                          narrow64_s32_to_u8_avx512(B + i)};
+    interleave_rgb_u8_avx512(v, dst + 3 * i);
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    interleave_rgb(rgb_merge_u8, narrow_s32_to_u8(R + i), narrow_s32_to_u8(G + i), narrow_s32_to_u8(B + i),
+                   dst + 3 * i);
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[3 * i]     = sat_u8(R[i]);
+    dst[3 * i + 1] = sat_u8(G[i]);
+    dst[3 * i + 2] = sat_u8(B[i]);
+  }
+}
+
+// three int32 planes into interleaved 16-bit big-endian RGB samples (PPM)
+static void pack_rgb_s32_to_big_u16(const int32_t *R, const int32_t *G, const int32_t *B, uint8_t *dst,
+                                    size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    uint16x8x3_t v;
+    v.val[0] = narrow_s32_to_big_u16(R + i);
+    v.val[1] = narrow_s32_to_big_u16(G + i);
+    v.val[2] = narrow_s32_to_big_u16(B + i);
+    vst3q_u16((uint16_t *)(dst + 6 * i), v);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    const __m512i v[3] = {narrow32_s32_to_u16_avx512(R + i), narrow32_s32_to_u16_avx512(G + i),
+                          narrow32_s32_to_u16_avx512(B + i)};
+    interleave_rgb_u16_avx512(v, dst + 6 * i);
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    interleave_rgb(rgb_merge_big_u16, narrow_s32_to_u16(R + i), narrow_s32_to_u16(G + i),
+                   narrow_s32_to_u16(B + i), dst + 6 * i);
+  }
+#endif
+  for (; i < len; ++i) {
+    put_big16(dst + 6 * i, sat_u16(R[i]));
+    put_big16(dst + 6 * i + 2, sat_u16(G[i]));
+    put_big16(dst + 6 * i + 4, sat_u16(B[i]));
+  }
+}
+
+// three 8-bit planes into interleaved 8-bit RGB samples (PPM)
+static void pack_rgb_u8_to_u8(const uint8_t *R, const uint8_t *G, const uint8_t *B, uint8_t *dst,
+                              size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    uint8x16x3_t v;
+    v.val[0] = vld1q_u8(R + i);
+    v.val[1] = vld1q_u8(G + i);
+    v.val[2] = vld1q_u8(B + i);
+    vst3q_u8(dst + 3 * i, v);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512VBMI__)
+  for (; i < len - len % 64; i += 64) {
+    const __m512i v[3] = {_mm512_loadu_si512((const void *)(R + i)),
+                          _mm512_loadu_si512((const void *)(G + i)),
+                          _mm512_loadu_si512((const void *)(B + i))};
+    interleave_rgb_u8_avx512(v, dst + 3 * i);
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    interleave_rgb(rgb_merge_u8, _mm_loadu_si128((const __m128i *)(R + i)),
+                   _mm_loadu_si128((const __m128i *)(G + i)), _mm_loadu_si128((const __m128i *)(B + i)),
+                   dst + 3 * i);
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[3 * i]     = R[i];
+    dst[3 * i + 1] = G[i];
+    dst[3 * i + 2] = B[i];
+  }
+}
+
+// three native-endian 16-bit planes into interleaved 16-bit big-endian RGB samples (PPM)
+static void pack_rgb_u16_to_big_u16(const uint16_t *R, const uint16_t *G, const uint16_t *B, uint8_t *dst,
+                                    size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    uint16x8x3_t v;
+    v.val[0] = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vld1q_u16(R + i))));
+    v.val[1] = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vld1q_u16(G + i))));
+    v.val[2] = vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vld1q_u16(B + i))));
+    vst3q_u16((uint16_t *)(dst + 6 * i), v);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    const __m512i v[3] = {_mm512_loadu_si512((const void *)(R + i)),
+                          _mm512_loadu_si512((const void *)(G + i)),
+                          _mm512_loadu_si512((const void *)(B + i))};
+    interleave_rgb_u16_avx512(v, dst + 6 * i);
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    interleave_rgb(rgb_merge_big_u16, _mm_loadu_si128((const __m128i *)(R + i)),
+                   _mm_loadu_si128((const __m128i *)(G + i)), _mm_loadu_si128((const __m128i *)(B + i)),
+                   dst + 6 * i);
+  }
+#endif
+  for (; i < len; ++i) {
+    put_big16(dst + 6 * i, R[i]);
+    put_big16(dst + 6 * i + 2, G[i]);
+    put_big16(dst + 6 * i + 4, B[i]);
+  }
+}
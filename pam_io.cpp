@@ -0,0 +1,62 @@
+#include "pam_io.hpp"
+
+int parse_pam_header(byte_stream &bs, const std::string &filename, pam_header &hdr) {
+  instrument::stage_timer timer(instrument::stage::HEADER);
+  if (bs.get() != 'P' || bs.get() != '7' || !bs.at_separator()) {
+    printf("ERROR: %s is not a PAM file.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  static const char *const keys[4] = {"WIDTH", "HEIGHT", "DEPTH", "MAXVAL"};
+  uint32_t *const fields[4]        = {&hdr.width, &hdr.height, &hdr.depth, &hdr.maxval};
+  bool given[4]                    = {false, false, false, false};
+  hdr.tupltype.clear();
+  for (;;) {
+    bs.skip_white();
+    const std::string key = bs.read_token();
+    if (key == "ENDHDR") {
+      break;
+    }
+    if (key == "TUPLTYPE") {  // the value is the rest of the line
+      while (bs.peek() == ' ' || bs.peek() == '\t') {
+        bs.get();
+      }
+      if (!hdr.tupltype.empty()) {
+        hdr.tupltype += ' ';
+      }
+      while (bs.peek() != EOF && bs.peek() != '\n' && bs.peek() != '\r') {
+        hdr.tupltype += static_cast<char>(bs.get());
+      }
+      continue;
+    }
+    int k = 0;
+    while (k < 4 && key != keys[k]) {
+      ++k;
+    }
+    if (k == 4 || given[k]) {
+      printf("ERROR: header of %s is broken.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+    bs.skip_white();
+    if (!bs.read_uint(*fields[k]) || !bs.at_separator()) {
+      printf("ERROR: header of %s is broken.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+    given[k] = true;
+  }
+  // the raster starts right after the line feed of ENDHDR
+  if (!(given[0] && given[1] && given[2] && given[3]) || bs.get() != '\n') {
+    printf("ERROR: header of %s is broken.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  if (hdr.maxval == 0 || hdr.maxval > 65535) {
+    printf("ERROR: maxval of %s shall be 1 - 65535.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  if (hdr.depth == 0 || hdr.depth > 4) {
+    printf("ERROR: %s has depth %u, PAM of depth 1 - 4 is supported.\n", filename.c_str(), hdr.depth);
+    return EXIT_FAILURE;
+  }
+  hdr.bpp = static_cast<uint8_t>(log2(static_cast<float>(hdr.maxval)) + 1.0f);
+  timer.set_bytes(bs.tell());
+  return EXIT_SUCCESS;
+}
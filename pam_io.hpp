@@ -0,0 +1,27 @@
+#pragma once
+#include "image_io_local.hpp"
+
+/********************************************************************************
+ * PAM (P7) header
+ * WIDTH, HEIGHT, DEPTH and MAXVAL lines, each given once, and any TUPLTYPE lines,
+ * in any order up to the line ENDHDR; the raster is that of PGM/PPM with DEPTH
+ * interleaved samples per pixel (1 byte each, or 2 big-endian bytes for maxval >
+ * 255); depths 1 - 4 (e.g. GRAYSCALE, GRAYSCALE_ALPHA, RGB, RGB_ALPHA) are read
+ *******************************************************************************/
+struct pam_header {
+  uint32_t width;
+  uint32_t height;
+  uint32_t depth;
+  uint32_t maxval;
+  uint8_t bpp;
+  std::string tupltype;  // TUPLTYPE lines joined by a space, informative only
+
+  uint32_t byte_per_sample() const { return (bpp + 8 - 1) / 8; }
+};
+
+/**
+ * @brief Parse the header of a PAM file; bs is left at the first byte of the raster
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int parse_pam_header(byte_stream &bs, const std::string &filename, pam_header &hdr);
@@ -0,0 +1,89 @@
+#include <cerrno>
+#include <cstring>
+
+#include "perf_counters.hpp"
+
+#if defined(__linux__)
+  #include <linux/perf_event.h>
+  #include <sys/syscall.h>
+  #include <unistd.h>
+#endif
+
+static const char *const event_names[num_perf_events] = {"cycles", "instructions", "llc_misses",
+                                                         "dtlb_misses", "branch_misses"};
+
+const char *perf_event_name(perf_event e) {
+  return (e < perf_event::NUM_EVENTS) ? event_names[static_cast<size_t>(e)] : "unknown";
+}
+
+#if defined(__linux__)
+// type and config of perf_event_attr in the order of perf_event
+static const struct {
+  uint32_t type;
+  uint64_t config;
+} event_attr[num_perf_events] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                             | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+perf_counters::perf_counters() : error(0) {
+  for (size_t i = 0; i < num_perf_events; ++i) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = event_attr[i].type;
+    attr.config         = event_attr[i].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    // pid = 0, cpu = -1: the calling thread on any CPU
+    fd[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    if (fd[i] < 0 && error == 0) {
+      error = errno;
+    }
+  }
+}
+
+perf_counters::~perf_counters() {
+  for (int f : fd) {
+    if (f >= 0) {
+      close(f);
+    }
+  }
+}
+
+perf_sample perf_counters::read() const {
+  perf_sample s;
+  for (size_t i = 0; i < num_perf_events; ++i) {
+    uint64_t v = 0;
+    if (fd[i] >= 0 && ::read(fd[i], &v, sizeof(v)) == sizeof(v)) {
+      s.val[i] = v;
+    }
+  }
+  return s;
+}
+#else
+perf_counters::perf_counters() : error(ENOSYS) {
+  for (int &f : fd) {
+    f = -1;
+  }
+}
+
+perf_counters::~perf_counters() {}
+
+perf_sample perf_counters::read() const { return perf_sample(); }
+#endif
+
+bool perf_counters::any_available() const {
+  for (int f : fd) {
+    if (f >= 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const char *perf_counters::unavailable_reason() const { return (error) ? strerror(error) : nullptr; }
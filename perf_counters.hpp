@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/********************************************************************************
+ * hardware performance counters of the calling thread (Linux perf_event_open)
+ * counters are user space only, so that perf_event_paranoid <= 2 suffices;
+ * counters the kernel, the CPU or the container does not provide are marked as
+ * unavailable and read as zero, on other platforms every counter is unavailable
+ *******************************************************************************/
+enum class perf_event { CYCLES, INSTRUCTIONS, LLC_MISSES, DTLB_MISSES, BRANCH_MISSES, NUM_EVENTS };
+constexpr size_t num_perf_events = static_cast<size_t>(perf_event::NUM_EVENTS);
+
+// name of e: cycles, instructions, llc_misses, dtlb_misses or branch_misses
+const char *perf_event_name(perf_event e);
+
+struct perf_sample {
+  uint64_t val[num_perf_events] = {};
+
+  uint64_t operator[](perf_event e) const { return val[static_cast<size_t>(e)]; }
+  perf_sample operator-(const perf_sample &s) const {
+    perf_sample d;
+    for (size_t i = 0; i < num_perf_events; ++i) {
+      d.val[i] = val[i] - s.val[i];
+    }
+    return d;
+  }
+  perf_sample &operator+=(const perf_sample &s) {
+    for (size_t i = 0; i < num_perf_events; ++i) {
+      val[i] += s.val[i];
+    }
+    return *this;
+  }
+};
+
+/**
+ * @brief Free-running counters of the thread that opened them; a measurement is the difference
+ * of two read() calls
+ */
+class perf_counters {
+ private:
+  int fd[num_perf_events];
+  int error;  // errno of the first counter that failed to open
+
+ public:
+  perf_counters();
+  ~perf_counters();
+  perf_counters(const perf_counters &)            = delete;
+  perf_counters &operator=(const perf_counters &) = delete;
+
+  bool available(perf_event e) const { return fd[static_cast<size_t>(e)] >= 0; }
+  // true if at least one counter is available
+  bool any_available() const;
+  // reason why a counter is unavailable, nullptr if all of them are
+  const char *unavailable_reason() const;
+  // current values; unavailable counters read as zero
+  perf_sample read() const;
+};
@@ -0,0 +1,36 @@
+#include "pfm_io.hpp"
+
+int parse_pfm_header(byte_stream &bs, const std::string &filename, pfm_header &hdr) {
+  instrument::stage_timer timer(instrument::stage::HEADER);
+  const int p     = bs.get();
+  const int magic = bs.get();
+  if (p != 'P' || (magic != 'F' && magic != 'f')) {
+    printf("ERROR: %s is not a PFM file.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  hdr.num_components        = (magic == 'F') ? 3 : 1;
+  uint32_t *const fields[2] = {&hdr.width, &hdr.height};
+  for (uint32_t *val : fields) {
+    if (!bs.at_separator()) {
+      printf("ERROR: header of %s is broken.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+    bs.skip_white();
+    if (!bs.read_uint(*val) || !bs.at_separator()) {
+      printf("ERROR: header of %s is broken.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  bs.skip_white();
+  const std::string scale = bs.read_token();
+  char *end               = nullptr;
+  const float s           = strtof(scale.c_str(), &end);
+  // a single whitespace terminates the header, the raster starts right after it
+  if (scale.empty() || *end != '\0' || s == 0.0f || !std::isfinite(s) || !byte_stream::is_white(bs.get())) {
+    printf("ERROR: header of %s is broken.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  hdr.little_endian = s < 0.0f;
+  timer.set_bytes(bs.tell());
+  return EXIT_SUCCESS;
+}
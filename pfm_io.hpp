@@ -0,0 +1,22 @@
+#pragma once
+#include "image_io_local.hpp"
+
+/********************************************************************************
+ * PFM header
+ * "PF" (RGB) or "Pf" (grayscale), width, height and a scale factor, whose sign
+ * gives the byte order of the 32-bit float samples (negative: little-endian);
+ * pixels are interleaved and rows are stored from the bottom of the image up
+ *******************************************************************************/
+struct pfm_header {
+  uint32_t width;
+  uint32_t height;
+  uint16_t num_components;  // 3 (PF) or 1 (Pf)
+  bool little_endian;
+};
+
+/**
+ * @brief Parse the header of a PFM file; bs is left at the first byte of the raster
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int parse_pfm_header(byte_stream &bs, const std::string &filename, pfm_header &hdr);
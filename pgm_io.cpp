@@ -1,140 +1,52 @@
-#include "pgm_io.hpp"
+#include <cstring>
 
-int pgm_component::read(const std::string &filename) {
-  bool isASCII     = false;
-  bool isBigendian = false;
-  bool isSigned    = false;
+#include "pgm_io.hpp"
+#include "pnm_io.hpp"
 
-  FILE *fp = fopen(filename.c_str(), "rb");
-  if (fp == nullptr) {
-    printf("ERROR: File %s is not found.\n", filename.c_str());
+int pgm_component::decode(const file_view &fv, const std::string &filename) {
+  byte_stream bs(fv.data(), fv.size());
+  pnm_header hdr;
+  if (parse_pnm_header(bs, filename, 1, hdr)) {
     return EXIT_FAILURE;
   }
-  status st = status::READ_WIDTH;
-  int d;
-  uint32_t val = 0;
-  char comment[256];
-  d = fgetc(fp);
-  if (d != 'P') {
-    printf("ERROR: %s is not a PGM file.\n", filename.c_str());
-    fclose(fp);
+  set_width(hdr.width);
+  set_height(hdr.height);
+  set_bpp(hdr.bpp);
+
+  // P5 (binary) read, P2 (ASCII) samples are parsed into the same layout first
+  const uint32_t byte_per_sample = hdr.byte_per_sample();
+  const size_t length            = static_cast<size_t>(hdr.width) * hdr.height;
+  unique_ptr_aligned<uint8_t> parsed;
+  const uint8_t *src = pnm_raster(bs, hdr, filename, length, parsed, get_pool());
+  if (src == nullptr) {
     return EXIT_FAILURE;
   }
-
-  d = fgetc(fp);
-  switch (d) {
-    // PGM
-    case '2':
-      isASCII = true;
-    case '5':
-      isBigendian = true;
+  if (get_log2_reduction() > 0) {  // a thumbnail, see unpack_reduced()
+    set_width(reduced_size(hdr.width, get_log2_reduction()));
+    set_height(reduced_size(hdr.height, get_log2_reduction()));
+    create_buf(static_cast<size_t>(get_width()) * get_height(), storage_type());
+    uint8_t *const plane = get_bytes();
+    instrument::stage_timer timer(instrument::stage::UNPACK, length * byte_per_sample);
+    unpack_reduced(src, hdr.width, hdr.height, 1, byte_per_sample, get_log2_reduction(), get_sample_type(),
+                   &plane, get_pool());
+    return EXIT_SUCCESS;
+  }
+  create_buf(length, storage_type());
+  instrument::stage_timer timer(instrument::stage::UNPACK, length * byte_per_sample);
+  switch (get_sample_type()) {
+    case sample_type::U8:
+      memcpy(get_buf<uint8_t>(), src, length);
+      break;
+    case sample_type::U16:
+      get_kernels().unpack_big_16_to_16(src, get_buf<uint16_t>(), length);
       break;
-    // error
     default:
-      printf("ERROR: %s is not a PGM file.\n", filename.c_str());
-      fclose(fp);
-      return EXIT_FAILURE;
+      if (byte_per_sample > 1) {  // > 8 bpp
+        get_kernels().unpack_big_u16_to_s32(src, get_buf(), length);
+      } else {  // <= 8bpp
+        get_kernels().unpack_u8_to_s32(src, get_buf(), length);
+      }
       break;
   }
-  while (st != status::DONE) {
-    d = fgetc(fp);
-    eat_white(d, fp, comment);
-    // read numerical value
-    while (d != SP && d != LF && d != CR) {
-      val *= 10;
-      val += d - '0';
-      d = fgetc(fp);
-    }
-    // update status
-    switch (st) {
-      case status::READ_WIDTH:
-        set_width(val);
-        val = 0;
-        st  = status::READ_HEIGHT;
-        break;
-      case status::READ_HEIGHT:
-        set_height(val);
-        val = 0;
-        st  = status::READ_MAXVAL;
-        break;
-      case status::READ_MAXVAL:
-        set_bpp(static_cast<uint8_t>(log2(static_cast<float>(val)) + 1.0f));
-        val = 0;
-        st  = status::DONE;
-        break;
-      default:
-        break;
-    }
-  }
-  eat_white(d, fp, comment);
-  fseek(fp, -1, SEEK_CUR);
-
-  // P5 (binary) read
-  const uint32_t byte_per_sample = (get_bpp() + 8 - 1) / 8;
-  uint32_t compw                 = get_width();
-  uint32_t comph                 = get_height();
-  create_buf(compw * comph);
-  int32_t *dst          = get_buf();
-  const uint32_t length = compw * comph;
-#if defined(USE_ARM_NEON)
-  const size_t simdgap = (byte_per_sample == 1) ? 16 : 8;
-  const size_t simdlen = length - (length) % simdgap;
-  if (byte_per_sample > 1) {  // > 8 bpp
-    auto tmp = aligned_uptr<uint16_t>(32, length);
-    if (fread(tmp.get(), sizeof(uint16_t), length, fp) < length) {
-      printf("ERROR: not enough samples in the given pnm file.\n");
-      fclose(fp);
-      return EXIT_FAILURE;
-    }
-    auto line_buf = tmp.get();
-    for (size_t i = 0; i < simdlen; i += simdgap) {
-      auto src = vld1q_u16(line_buf + i);
-      store_big_u16_to_s32(src, dst + i);
-    }
-    for (size_t i = simdlen; i < length; ++i) {
-      dst[i] = (line_buf[i] >> 8) | ((line_buf[i] & 0xFF) << 8);
-    }
-  } else {  // <= 8bpp
-    auto tmp = aligned_uptr<uint8_t>(32, length);
-    if (fread(tmp.get(), sizeof(uint8_t), length, fp) < length) {
-      printf("ERROR: not enough samples in the given pnm file.\n");
-      fclose(fp);
-      return EXIT_FAILURE;
-    }
-    auto line_buf = tmp.get();
-    for (size_t i = 0; i < simdlen; i += simdgap) {
-      auto src = vld1q_u8(line_buf + i);
-      store_u8_to_s32(src, dst + i);
-    }
-    for (size_t i = simdlen; i < length; ++i) {
-      dst[i] = line_buf[i];
-    }
-  }
-#else
-  if (byte_per_sample > 1) {  // > 8 bpp
-    auto tmp = aligned_uptr<uint16_t>(32, length);
-    if (fread(tmp.get(), sizeof(uint16_t), length, fp) < length) {
-      printf("ERROR: not enough samples in the given pnm file.\n");
-      fclose(fp);
-      return EXIT_FAILURE;
-    }
-    auto line_buf = tmp.get();
-    for (size_t i = 0; i < length; ++i) {
-      dst[i] = (line_buf[i] >> 8) | ((line_buf[i] & 0xFF) << 8);
-    }
-  } else {  // <= 8bpp
-    auto tmp = aligned_uptr<uint8_t>(32, length);
-    if (fread(tmp.get(), sizeof(uint8_t), length, fp) < length) {
-      printf("ERROR: not enough samples in the given pnm file.\n");
-      fclose(fp);
-      return EXIT_FAILURE;
-    }
-    auto line_buf = tmp.get();
-    for (size_t i = 0; i < length; ++i) {
-      dst[i] = line_buf[i];
-    }
-  }
-#endif
-  fclose(fp);
   return EXIT_SUCCESS;
 }
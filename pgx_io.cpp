@@ -1,229 +1,129 @@
+#include <cstring>
+
 #include "pgx_io.hpp"
 
-int pgx_component::read(const std::string &filename) {
+int pgx_component::decode(const file_view &fv, const std::string &filename) {
   bool isBigendian = false;
 
-  FILE *fp = fopen(filename.c_str(), "rb");
-  if (fp == nullptr) {
-    printf("ERROR: File %s is not found.\n", filename.c_str());
-    return EXIT_FAILURE;
-  }
-  status st = status::READ_WIDTH;
-  int d;
-  uint32_t val = 0;
-  char comment[256];
-  d = fgetc(fp);
-  if (d != 'P') {
+  byte_stream bs(fv.data(), fv.size());
+  instrument::stage_timer header(instrument::stage::HEADER);
+  if (bs.get() != 'P') {
     printf("ERROR: %s is not a PGX file.\n", filename.c_str());
-    fclose(fp);
     return EXIT_FAILURE;
   }
-  d = fgetc(fp);
-  if (d != 'G') {
+  if (bs.get() != 'G') {
     printf("ERROR: input PGX file %s is broken.\n", filename.c_str());
-    fclose(fp);
     return EXIT_FAILURE;
   }
 
   // read endian
-  do {
-    d = fgetc(fp);
-  } while (d != 'M' && d != 'L');
-  switch (d) {
+  bs.skip_white();
+  switch (bs.get()) {
     case 'M':
       isBigendian = true;
-      d           = fgetc(fp);
-      if (d != 'L') {
+      if (bs.get() != 'L') {
         printf("ERROR: input PGX file %s is broken.\n", filename.c_str());
+        return EXIT_FAILURE;
       }
       break;
     case 'L':
-      d = fgetc(fp);
-      if (d != 'M') {
+      if (bs.get() != 'M') {
         printf("ERROR: input PGX file %s is broken.\n", filename.c_str());
+        return EXIT_FAILURE;
       }
       break;
     default:
       printf("ERROR: input file does not conform to PGX format.\n");
       return EXIT_FAILURE;
   }
-  // check signed or not
-  do {
-    d = fgetc(fp);
-  } while (d != '+' && d != '-' && isdigit(d) == false);
-  if (d == '+' || d == '-') {
-    if (d == '-') {
-      set_is_signed(true);
-    }
-    do {
-      d = fgetc(fp);
-    } while (isdigit(d) == false);
+  // check signed or not; the sign may be separated from the bit depth
+  bs.skip_white();
+  if (bs.peek() == '+' || bs.peek() == '-') {
+    set_is_signed(bs.get() == '-');
   }
-  do {
-    val *= 10;
-    val += d - '0';
-    d = fgetc(fp);
-  } while (d != SP && d != LF && d != CR);
-  set_bpp(val);
-  val = 0;
-
-  while (st != status::DONE) {
-    d = fgetc(fp);
-    eat_white(d, fp, comment);
-    // read numerical value
-    while (d != SP && d != LF && d != CR) {
-      val *= 10;
-      val += d - '0';
-      d = fgetc(fp);
-    }
-    // update status
-    switch (st) {
-      case status::READ_WIDTH:
-        set_width(val);
-        val = 0;
-        st  = status::READ_HEIGHT;
-        break;
-      case status::READ_HEIGHT:
-        set_height(val);
-        st = status::DONE;
-        break;
-      default:
-        break;
+  uint32_t val[3];  // bit depth, width, height
+  for (uint32_t &v : val) {
+    bs.skip_white();
+    if (!bs.read_uint(v) || !bs.at_separator()) {
+      printf("ERROR: input PGX file %s is broken.\n", filename.c_str());
+      return EXIT_FAILURE;
     }
   }
-  eat_white(d, fp, comment);
-  fseek(fp, -1, SEEK_CUR);
+  if (val[0] == 0 || val[0] > 32) {
+    printf("ERROR: bit depth of %s shall be 1 - 32.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  set_bpp(static_cast<uint8_t>(val[0]));
+  set_width(val[1]);
+  set_height(val[2]);
+  // a single whitespace terminates the header, the raster starts right after it
+  bs.get();
+  header.set_bytes(bs.tell());
+  header.stop();
 
-  const uint32_t byte_per_sample = (get_bpp() + 8 - 1) / 8;
+  // 1, 2 or 4 bytes per sample, as image::write_pgx() stores them
+  const uint32_t byte_per_sample = (get_bpp() > 16) ? 4 : (get_bpp() > 8) ? 2 : 1;
   const uint32_t compw           = get_width();
   const uint32_t comph           = get_height();
-  create_buf(compw * comph);
-  int32_t *dst          = get_buf();
-  const uint32_t length = compw * comph;
-#if defined(USE_ARM_NEON)
-  const size_t simdgap = (byte_per_sample == 1) ? 16 : 8;
-  const size_t simdlen = length - (length) % simdgap;
-  if (byte_per_sample > 1) {  // > 8 bpp
-    auto tmp = aligned_uptr<uint16_t>(32, length);
-    if (fread(tmp.get(), sizeof(uint16_t), length, fp) < length) {
-      printf("ERROR: not enough samples in the given pnm file.\n");
-      fclose(fp);
-      return EXIT_FAILURE;
-    }
-    auto line_buf = tmp.get();
-    if (get_is_signed()) {
-      if (isBigendian) {
-        for (size_t i = 0; i < simdlen; i += simdgap) {
-          auto src = vld1q_u16(line_buf + i);
-          store_big_s16_to_s32(src, dst + i);
-        }
-        for (size_t i = simdlen; i < length; ++i) {
-          dst[i] = static_cast<int16_t>((line_buf[i] >> 8) | ((line_buf[i] & 0xFF) << 8));
-        }
-      } else {
-        for (size_t i = 0; i < simdlen; i += simdgap) {
-          auto src = vld1q_u16(line_buf + i);
-          store_little_s16_to_s32(src, dst + i);
-        }
-        for (size_t i = simdlen; i < length; ++i) {
-          dst[i] = static_cast<int16_t>(line_buf[i]);
-        }
+  const size_t length            = static_cast<size_t>(compw) * comph;
+  const size_t offset            = bs.tell();
+  if (fv.size() - offset < length * byte_per_sample) {
+    printf("ERROR: not enough samples in the given pgx file.\n");
+    return EXIT_FAILURE;
+  }
+  const uint8_t *src = fv.data() + offset;
+  create_buf(length, storage_type());
+  instrument::stage_timer timer(instrument::stage::UNPACK, length * byte_per_sample);
+  switch (get_sample_type()) {
+    case sample_type::U8:
+      memcpy(get_buf<uint8_t>(), src, length);
+      return EXIT_SUCCESS;
+    case sample_type::U16:
+    case sample_type::S16: {
+      if (byte_per_sample == 1) {  // signed <= 8bpp
+        get_kernels().unpack_s8_to_s16(src, get_buf<int16_t>(), length);
+        return EXIT_SUCCESS;
       }
-    } else {
+      // 16-bit samples keep their bit pattern, only the byte order is converted
+      uint16_t *dst16 = (get_is_signed()) ? reinterpret_cast<uint16_t *>(get_buf<int16_t>())
+                                          : get_buf<uint16_t>();
       if (isBigendian) {
-        for (size_t i = 0; i < simdlen; i += simdgap) {
-          auto src = vld1q_u16(line_buf + i);
-          store_big_u16_to_s32(src, dst + i);
-        }
-        for (size_t i = simdlen; i < length; ++i) {
-          dst[i] = (line_buf[i] >> 8) | ((line_buf[i] & 0xFF) << 8);
-        }
+        get_kernels().unpack_big_16_to_16(src, dst16, length);
       } else {
-        for (size_t i = 0; i < simdlen; i += simdgap) {
-          auto src = vld1q_u16(line_buf + i);
-          store_little_u16_to_s32(src, dst + i);
-        }
-        for (size_t i = simdlen; i < length; ++i) {
-          dst[i] = line_buf[i];
-        }
-      }
-    }
-  } else {  // <= 8bpp
-    auto tmp = aligned_uptr<uint8_t>(32, length);
-    if (fread(tmp.get(), sizeof(uint8_t), length, fp) < length) {
-      printf("ERROR: not enough samples in the given pnm file.\n");
-      fclose(fp);
-      return EXIT_FAILURE;
-    }
-    auto line_buf = tmp.get();
-    if (get_is_signed()) {
-      for (size_t i = 0; i < simdlen; i += simdgap) {
-        auto src = vld1q_s8((int8_t *)line_buf + i);
-        store_s8_to_s32(src, dst + i);
-      }
-      for (size_t i = simdlen; i < length; ++i) {
-        dst[i] = static_cast<int8_t>(line_buf[i]);
-      }
-    } else {
-      for (size_t i = 0; i < simdlen; i += simdgap) {
-        auto src = vld1q_u8(line_buf + i);
-        store_u8_to_s32(src, dst + i);
-      }
-      for (size_t i = simdlen; i < length; ++i) {
-        dst[i] = line_buf[i];
+        memcpy(dst16, src, length * sizeof(uint16_t));
       }
+      return EXIT_SUCCESS;
     }
+    default:
+      break;
   }
-#else
-  if (byte_per_sample > 1) {  // > 8 bpp
-    auto tmp = aligned_uptr<uint16_t>(32, length);
-    if (fread(tmp.get(), sizeof(uint16_t), length, fp) < length) {
-      printf("ERROR: not enough samples in the given pnm file.\n");
-      fclose(fp);
-      return EXIT_FAILURE;
+  int32_t *dst = get_buf();
+  if (byte_per_sample == 4) {  // > 16 bpp, the bit pattern of int32 for signed and unsigned samples alike
+    if (isBigendian) {
+      get_kernels().unpack_big_32_to_s32(src, dst, length);
+    } else {
+      get_kernels().unpack_little_32_to_s32(src, dst, length);
     }
-    auto line_buf = tmp.get();
+  } else if (byte_per_sample == 2) {  // > 8 bpp
     if (get_is_signed()) {
       if (isBigendian) {
-        for (size_t i = 0; i < length; ++i) {
-          dst[i] = static_cast<int16_t>((line_buf[i] >> 8) | ((line_buf[i] & 0xFF) << 8));
-        }
+        get_kernels().unpack_big_s16_to_s32(src, dst, length);
       } else {
-        for (size_t i = 0; i < length; ++i) {
-          dst[i] = static_cast<int16_t>(line_buf[i]);
-        }
+        get_kernels().unpack_little_s16_to_s32(src, dst, length);
       }
     } else {
       if (isBigendian) {
-        for (size_t i = 0; i < length; ++i) {
-          dst[i] = (line_buf[i] >> 8) | ((line_buf[i] & 0xFF) << 8);
-        }
+        get_kernels().unpack_big_u16_to_s32(src, dst, length);
       } else {
-        for (size_t i = 0; i < length; ++i) {
-          dst[i] = line_buf[i];
-        }
+        get_kernels().unpack_little_u16_to_s32(src, dst, length);
       }
     }
   } else {  // <= 8bpp
-    auto tmp = aligned_uptr<uint8_t>(32, length);
-    if (fread(tmp.get(), sizeof(uint8_t), length, fp) < length) {
-      printf("ERROR: not enough samples in the given pnm file.\n");
-      fclose(fp);
-      return EXIT_FAILURE;
-    }
-    auto line_buf = tmp.get();
     if (get_is_signed()) {
-      for (size_t i = 0; i < length; ++i) {
-        dst[i] = static_cast<int8_t>(line_buf[i]);
-      }
+      get_kernels().unpack_s8_to_s32(src, dst, length);
     } else {
-      for (size_t i = 0; i < length; ++i) {
-        dst[i] = line_buf[i];
-      }
+      get_kernels().unpack_u8_to_s32(src, dst, length);
     }
   }
-
-#endif
-  fclose(fp);
   return EXIT_SUCCESS;
 }
@@ -4,5 +4,5 @@
 class pgx_component : public image_component {
  public:
   pgx_component(uint16_t idx) : image_component(idx) {}
-  int read(const std::string &filename) override;
+  int decode(const file_view &fv, const std::string &filename) override;
 };
\ No newline at end of file
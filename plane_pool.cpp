@@ -0,0 +1,101 @@
+#include <algorithm>
+#include <cstdlib>
+
+#include "plane_pool.hpp"
+
+static void *pool_alloc(size_t bytes) {
+#if defined(_MSC_VER)
+  return _aligned_malloc(bytes, plane_pool::alignment);
+#else
+  // the size of aligned_alloc() shall be a multiple of the alignment
+  return aligned_alloc(plane_pool::alignment,
+                       (bytes + plane_pool::alignment - 1) / plane_pool::alignment * plane_pool::alignment);
+#endif
+}
+
+static void pool_free(void *p) {
+#if defined(_MSC_VER)
+  _aligned_free(p);
+#else
+  std::free(p);
+#endif
+}
+
+size_t plane_pool::class_size(size_t bytes) {
+  if (bytes <= min_pooled_bytes) {
+    return (bytes < min_pooled_bytes) ? bytes : min_pooled_bytes;
+  }
+  // step = a quarter of the largest power of two below bytes
+  size_t pow2 = min_pooled_bytes;
+  while (pow2 * 2 < bytes) {
+    pow2 *= 2;
+  }
+  const size_t step = pow2 / 4;
+  return (bytes + step - 1) / step * step;
+}
+
+void *plane_pool::acquire(size_t bytes) {
+  if (bytes < min_pooled_bytes) {
+    return pool_alloc(bytes);
+  }
+  const size_t cls = class_size(bytes);
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stats.in_use_bytes += cls;
+    stats.peak_use_bytes = std::max(stats.peak_use_bytes, stats.in_use_bytes);
+    auto it = free_lists.find(cls);
+    if (it != free_lists.end() && !it->second.empty()) {
+      void *p = it->second.back();
+      it->second.pop_back();
+      stats.cached_bytes -= cls;
+      stats.hits++;
+      return p;
+    }
+    stats.misses++;
+  }
+  // allocate outside of the lock; page faults of a fresh buffer are paid by its first writer
+  void *p = pool_alloc(cls);
+  if (p == nullptr) {
+    std::lock_guard<std::mutex> lock(mtx);
+    stats.in_use_bytes -= cls;
+  }
+  return p;
+}
+
+void plane_pool::release(void *p, size_t bytes) {
+  if (p == nullptr) {
+    return;
+  }
+  if (bytes < min_pooled_bytes) {
+    pool_free(p);
+    return;
+  }
+  const size_t cls = class_size(bytes);
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    stats.in_use_bytes -= cls;
+    if (stats.cached_bytes + cls <= max_cached_bytes) {
+      free_lists[cls].push_back(p);
+      stats.cached_bytes += cls;
+      return;
+    }
+    stats.dropped++;
+  }
+  pool_free(p);
+}
+
+void plane_pool::trim() {
+  std::lock_guard<std::mutex> lock(mtx);
+  for (auto &fl : free_lists) {
+    for (void *p : fl.second) {
+      pool_free(p);
+    }
+  }
+  free_lists.clear();
+  stats.cached_bytes = 0;
+}
+
+plane_pool_stats plane_pool::get_stats() const {
+  std::lock_guard<std::mutex> lock(mtx);
+  return stats;
+}
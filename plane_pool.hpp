@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <vector>
+
+/********************************************************************************
+ * pool of 64-byte aligned buffers recycled across images
+ * requests are rounded up to size classes spaced by a quarter of a power of two
+ * (64 KiB, 80 KiB, 96 KiB, 112 KiB, 128 KiB, 160 KiB, ...), so a buffer serves
+ * later requests that are up to 25 % smaller; released buffers are kept on a free
+ * list per class until max_cached_bytes is reached; smaller requests than
+ * min_pooled_bytes are passed to the system allocator
+ * thread-safe; the pool shall outlive every buffer acquired from it
+ *******************************************************************************/
+struct plane_pool_stats {
+  uint64_t hits         = 0;  // acquisitions served from a free list
+  uint64_t misses       = 0;  // acquisitions that allocated a new buffer
+  uint64_t dropped      = 0;  // releases freed because the cache was full
+  size_t cached_bytes   = 0;  // bytes held on the free lists
+  size_t in_use_bytes   = 0;  // bytes of pooled buffers handed out
+  size_t peak_use_bytes = 0;
+};
+
+class plane_pool {
+ private:
+  mutable std::mutex mtx;
+  std::map<size_t, std::vector<void *>> free_lists;  // size class -> cached buffers
+  const size_t max_cached_bytes;
+  plane_pool_stats stats;
+
+ public:
+  static constexpr size_t alignment        = 64;
+  static constexpr size_t min_pooled_bytes = 64 << 10;
+
+  explicit plane_pool(size_t max_cached_bytes = size_t(1) << 30) : max_cached_bytes(max_cached_bytes) {}
+  plane_pool(const plane_pool &)            = delete;
+  plane_pool &operator=(const plane_pool &) = delete;
+  ~plane_pool() { trim(); }
+
+  // bytes actually allocated for a request of the given size
+  static size_t class_size(size_t bytes);
+  // nullptr if the allocation fails
+  void *acquire(size_t bytes);
+  // bytes shall be the size given to acquire()
+  void release(void *p, size_t bytes);
+  // free every cached buffer
+  void trim();
+  plane_pool_stats get_stats() const;
+};
@@ -0,0 +1,192 @@
+#include "pnm_io.hpp"
+
+int parse_pnm_header(byte_stream &bs, const std::string &filename, uint16_t num_components,
+                     pnm_header &hdr) {
+  instrument::stage_timer timer(instrument::stage::HEADER);
+  const char *format = (num_components == 3) ? "PPM" : "PGM";
+  if (bs.get() != 'P') {
+    printf("ERROR: %s is not a %s file.\n", filename.c_str(), format);
+    return EXIT_FAILURE;
+  }
+  hdr.magic = static_cast<char>(bs.get());
+  if ((hdr.magic != '2' && hdr.magic != '3' && hdr.magic != '5' && hdr.magic != '6')
+      || hdr.num_components() != num_components) {
+    printf("ERROR: %s is not a %s file.\n", filename.c_str(), format);
+    return EXIT_FAILURE;
+  }
+  uint32_t *const fields[3] = {&hdr.width, &hdr.height, &hdr.maxval};
+  for (uint32_t *val : fields) {
+    if (!bs.at_separator()) {
+      printf("ERROR: header of %s is broken.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+    bs.skip_white();
+    if (!bs.read_uint(*val) || !bs.at_separator()) {
+      printf("ERROR: header of %s is broken.\n", filename.c_str());
+      return EXIT_FAILURE;
+    }
+  }
+  if (hdr.maxval == 0 || hdr.maxval > 65535) {
+    printf("ERROR: maxval of %s shall be 1 - 65535.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  hdr.bpp = static_cast<uint8_t>(log2(static_cast<float>(hdr.maxval)) + 1.0f);
+  // a single whitespace terminates the header, the raster starts right after it
+  if (!byte_stream::is_white(bs.get())) {
+    printf("ERROR: header of %s is broken.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  timer.set_bytes(bs.tell());
+  return EXIT_SUCCESS;
+}
+
+const uint8_t *pnm_raster(byte_stream &bs, const pnm_header &hdr, const std::string &filename,
+                          size_t num_samples, unique_ptr_aligned<uint8_t> &buf, plane_pool *pool) {
+  const size_t byte_per_sample = hdr.byte_per_sample();
+  if (!hdr.is_ascii()) {
+    if (bs.remaining() / byte_per_sample < num_samples) {
+      printf("ERROR: not enough samples in the given pnm file.\n");
+      return nullptr;
+    }
+    return bs.ptr();
+  }
+
+  // the kernels take runs of well-formed samples; comments and the samples they leave (e.g. with more
+  // than 5 digits) are read one by one here
+  instrument::stage_timer timer(instrument::stage::UNPACK);
+  const size_t first         = bs.tell();
+  const parse_ascii_fn parse = (byte_per_sample == 1) ? get_kernels().parse_ascii_u8
+                                                      : get_kernels().parse_ascii_big_u16;
+  buf                        = aligned_uptr<uint8_t>(64, num_samples * byte_per_sample, pool);
+  uint8_t *dst               = buf.get();
+  size_t n                   = 0;
+  while (n < num_samples) {
+    size_t used;
+    n += parse(bs.ptr(), bs.remaining(), dst + n * byte_per_sample, num_samples - n, hdr.maxval, used);
+    bs.skip(used);
+    if (n == num_samples) {
+      break;
+    }
+    uint32_t val;
+    bs.skip_white();
+    if (bs.peek() == EOF) {
+      printf("ERROR: not enough samples in the given pnm file.\n");
+      return nullptr;
+    }
+    if (!bs.read_uint(val) || val > hdr.maxval || !bs.at_separator()) {
+      printf("ERROR: sample %zu of %s is broken.\n", n, filename.c_str());
+      return nullptr;
+    }
+    if (byte_per_sample == 1) {
+      dst[n] = static_cast<uint8_t>(val);
+    } else {
+      dst[2 * n]     = static_cast<uint8_t>(val >> 8);
+      dst[2 * n + 1] = static_cast<uint8_t>(val);
+    }
+    ++n;
+  }
+  timer.set_bytes(bs.tell() - first);
+  return buf.get();
+}
+
+void unpack_interleaved_s32(const uint8_t *src, int32_t *const *dst, uint16_t depth,
+                            uint32_t byte_per_sample, size_t len) {
+  const kernel_table &k = get_kernels();
+  const bool wide       = byte_per_sample > 1;  // > 8bpp
+  if (depth == 1) {
+    const unpack_fn unpack = (wide) ? k.unpack_big_u16_to_s32 : k.unpack_u8_to_s32;
+    unpack(src, dst[0], len);
+  } else if (depth == 3) {
+    const unpack_rgb_fn unpack = (wide) ? k.unpack_rgb_big_u16_to_s32 : k.unpack_rgb_u8_to_s32;
+    unpack(src, dst[0], dst[1], dst[2], len);
+  } else if (depth == 4) {
+    const unpack_rgba_fn unpack = (wide) ? k.unpack_rgba_big_u16_to_s32 : k.unpack_rgba_u8_to_s32;
+    unpack(src, dst[0], dst[1], dst[2], dst[3], len);
+  } else {
+    unpack_interleaved_scalar(src, dst, depth, byte_per_sample, len);
+  }
+}
+
+// dst[x] = sum[x] / n rounded to nearest, for the len blocks of a row of means; the last block holds
+// n_last pixels
+template <class T>
+static void store_box_means(const int32_t *sum, T *dst, uint32_t len, uint32_t n, uint32_t n_last) {
+  const int32_t half = static_cast<int32_t>(n / 2);
+  if ((n & (n - 1)) == 0) {  // whole blocks, or rows cut by a power of two
+    int32_t shift = 0;
+    while ((1U << shift) < n) {
+      ++shift;
+    }
+    for (uint32_t x = 0; x + 1 < len; ++x) {
+      dst[x] = static_cast<T>((sum[x] + half) >> shift);
+    }
+  } else {
+    for (uint32_t x = 0; x + 1 < len; ++x) {
+      dst[x] = static_cast<T>((sum[x] + half) / static_cast<int32_t>(n));
+    }
+  }
+  const int32_t last = static_cast<int32_t>(n_last);
+  dst[len - 1]       = static_cast<T>((sum[len - 1] + last / 2) / last);
+}
+
+void unpack_reduced(const uint8_t *src, uint32_t width, uint32_t height, uint16_t depth,
+                    uint32_t byte_per_sample, uint32_t log2f, sample_type type, uint8_t *const *planes,
+                    plane_pool *pool) {
+  if (width == 0 || height == 0) {
+    return;
+  }
+  const kernel_table &k      = get_kernels();
+  const uint32_t f           = 1U << log2f;
+  const uint32_t out_w       = reduced_size(width, log2f);
+  const uint32_t out_h       = reduced_size(height, log2f);
+  const size_t row_bytes     = static_cast<size_t>(width) * depth * byte_per_sample;
+  const size_t pixel_bytes   = static_cast<size_t>(depth) * byte_per_sample;
+  constexpr uint32_t columns = 512;  // per pass, a multiple of every block width: keeps the scratch in L1
+  // per channel, the sums of the rows of a block and the row being unpacked
+  auto scratch = aligned_uptr<int32_t>(64, 2 * depth * columns, pool);
+  int32_t *acc[4], *row[4];
+  for (uint16_t ch = 0; ch < depth; ++ch) {
+    acc[ch] = scratch.get() + 2 * ch * columns;
+    row[ch] = acc[ch] + columns;
+  }
+  for (uint32_t y = 0; y < out_h; ++y) {
+    const uint32_t rows = std::min(f, height - (y << log2f));
+    const uint8_t *band = src + (static_cast<size_t>(y) << log2f) * row_bytes;
+    for (uint32_t x0 = 0; x0 < width; x0 += columns) {
+      const uint32_t n      = std::min(columns, width - x0);
+      const uint32_t blocks = reduced_size(n, log2f);
+      const uint32_t padded = blocks << log2f;
+      // pixels of a block, and of the last one which the right edge may cut
+      const uint32_t n_full = rows << log2f;
+      const uint32_t n_last = rows * (n - ((blocks - 1) << log2f));
+      const uint8_t *p      = band + x0 * pixel_bytes;
+      unpack_interleaved_s32(p, acc, depth, byte_per_sample, n);
+      for (uint32_t r = 1; r < rows; ++r) {
+        unpack_interleaved_s32(p + r * row_bytes, row, depth, byte_per_sample, n);
+        for (uint16_t ch = 0; ch < depth; ++ch) {
+          k.box_accumulate(row[ch], acc[ch], n);
+        }
+      }
+      const size_t offset = static_cast<size_t>(y) * out_w + (x0 >> log2f);
+      for (uint16_t ch = 0; ch < depth; ++ch) {
+        // the columns past the edge add nothing to the last block
+        std::fill(acc[ch] + n, acc[ch] + padded, 0);
+        for (uint32_t s = 0; s < log2f; ++s) {
+          k.box_pair_sum(acc[ch], padded >> s);
+        }
+        uint8_t *const dst = planes[ch] + offset * sample_size(type);
+        switch (type) {
+          case sample_type::U8:
+            store_box_means(acc[ch], dst, blocks, n_full, n_last);
+            break;
+          case sample_type::U16:
+            store_box_means(acc[ch], reinterpret_cast<uint16_t *>(dst), blocks, n_full, n_last);
+            break;
+          default:
+            store_box_means(acc[ch], reinterpret_cast<int32_t *>(dst), blocks, n_full, n_last);
+            break;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "image_io_local.hpp"
+
+/********************************************************************************
+ * PGM/PPM (P2, P3, P5, P6) header and raster
+ * the plain (ASCII) formats P2 and P3 are parsed into the raster of their binary
+ * counterparts P5 and P6, so that the readers share the unpack path
+ *******************************************************************************/
+struct pnm_header {
+  char magic;  // '2', '3', '5' or '6'
+  uint32_t width;
+  uint32_t height;
+  uint32_t maxval;
+  uint8_t bpp;
+
+  bool is_ascii() const { return magic == '2' || magic == '3'; }
+  uint16_t num_components() const { return (magic == '3' || magic == '6') ? 3 : 1; }
+  // of the binary raster: 1, or 2 (big-endian) for maxval > 255
+  uint32_t byte_per_sample() const { return (bpp + 8 - 1) / 8; }
+};
+
+/**
+ * @brief Parse the header of a PGM (P2, P5: num_components = 1) or PPM (P3, P6: num_components = 3) file;
+ * bs is left at the first byte of the raster
+ *
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int parse_pnm_header(byte_stream &bs, const std::string &filename, uint16_t num_components,
+                     pnm_header &hdr);
+
+/**
+ * @brief Binary raster of num_samples samples (1 or 2 bytes each, see pnm_header::byte_per_sample()),
+ * bs being at its first byte
+ *
+ * A binary raster is returned in place; a plain one is parsed into buf, allocated from pool if given.
+ *
+ * @return nullptr if the raster is short or broken
+ */
+const uint8_t *pnm_raster(byte_stream &bs, const pnm_header &hdr, const std::string &filename,
+                          size_t num_samples, unique_ptr_aligned<uint8_t> &buf, plane_pool *pool = nullptr);
+
+/********************************************************************************
+ * unpack of binary rasters of interleaved pixels (PPM, PAM), shared by the
+ * full, window and reduced reads
+ *******************************************************************************/
+// deinterleave len pixels of depth samples of byte_per_sample bytes (big-endian) into planes of T, for
+// the depths that have no kernel
+template <class T>
+void unpack_interleaved_scalar(const uint8_t *src, T *const *dst, uint16_t depth,
+                               uint32_t byte_per_sample, size_t len) {
+  for (size_t i = 0; i < len; ++i) {
+    for (uint16_t ch = 0; ch < depth; ++ch, src += byte_per_sample) {
+      dst[ch][i] = static_cast<T>((byte_per_sample == 1) ? src[0] : (src[0] << 8) | src[1]);
+    }
+  }
+}
+
+/**
+ * @brief Deinterleave len pixels of depth (1 - 4) samples of byte_per_sample bytes (1, or 2 big-endian)
+ * into planes of int32
+ */
+void unpack_interleaved_s32(const uint8_t *src, int32_t *const *dst, uint16_t depth,
+                            uint32_t byte_per_sample, size_t len);
+
+// number of samples left of size samples by a reduction of 2^log2f, the last block being cut by the edge
+inline uint32_t reduced_size(uint32_t size, uint32_t log2f) {
+  return static_cast<uint32_t>((static_cast<uint64_t>(size) + (1U << log2f) - 1) >> log2f);
+}
+
+/**
+ * @brief Box-filter a binary raster of width x height pixels of depth (1 - 4) samples of byte_per_sample
+ * bytes by 2^log2f (log2f = 1 - 3) in both directions, into planes[ch] of type holding
+ * reduced_size(width, log2f) x reduced_size(height, log2f) samples
+ *
+ * The means are rounded to nearest; blocks cut by the right or bottom edge average the pixels they hold.
+ * The raster is unpacked 2^log2f rows at a time into int32 rows that are summed up (see box_accumulate()
+ * and box_pair_sum() in unpack_kernels.hpp), so no plane of the full size is made. Scratch rows are
+ * allocated from pool if given.
+ */
+void unpack_reduced(const uint8_t *src, uint32_t width, uint32_t height, uint16_t depth,
+                    uint32_t byte_per_sample, uint32_t log2f, sample_type type, uint8_t *const *planes,
+                    plane_pool *pool = nullptr);
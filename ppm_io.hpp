@@ -1,2 +0,0 @@
-#pragma once
-#include "image_io_local.hpp"
@@ -0,0 +1,136 @@
+#pragma once
+/********************************************************************************
+ * SIMD upsampling kernels of subsampled planes (4:2:2 and 4:2:0 layouts)
+ * a row halved horizontally is widened back by repeating each sample, the
+ * inverse of the 2 x 1 box filter of box_pair_sum() in unpack_kernels.hpp;
+ * rows halved vertically are repeated by the caller (see xyb_convert.cpp)
+ *******************************************************************************/
+#include <cstddef>
+#include <cstdint>
+
+#include "unpack_kernels.hpp"
+
+#if defined(USE_ARM_NEON)
+// the 128 bits at src into the 256 bits at dst, each sample repeated
+template <class T>
+static inline void store_twice(T *dst, const T *src) {
+  if constexpr (sizeof(T) == 1) {
+    const uint8x16_t v = vld1q_u8(src);
+    vst2q_u8(dst, (uint8x16x2_t{{v, v}}));
+  } else if constexpr (sizeof(T) == 2) {
+    const uint16x8_t v = vld1q_u16(src);
+    vst2q_u16(dst, (uint16x8x2_t{{v, v}}));
+  } else {
+    const int32x4_t v = vld1q_s32(src);
+    vst2q_s32(dst, (int32x4x2_t{{v, v}}));
+  }
+}
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+// the samples of the lower (upper) half of each 128-bit lane of v, each repeated
+template <class T>
+static inline __m128i repeat_lo(__m128i v) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm_unpacklo_epi8(v, v);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm_unpacklo_epi16(v, v);
+  } else {
+    return _mm_unpacklo_epi32(v, v);
+  }
+}
+template <class T>
+static inline __m128i repeat_hi(__m128i v) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm_unpackhi_epi8(v, v);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm_unpackhi_epi16(v, v);
+  } else {
+    return _mm_unpackhi_epi32(v, v);
+  }
+}
+#if defined(__AVX2__)
+template <class T>
+static inline __m256i repeat_lo(__m256i v) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm256_unpacklo_epi8(v, v);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm256_unpacklo_epi16(v, v);
+  } else {
+    return _mm256_unpacklo_epi32(v, v);
+  }
+}
+template <class T>
+static inline __m256i repeat_hi(__m256i v) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm256_unpackhi_epi8(v, v);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm256_unpackhi_epi16(v, v);
+  } else {
+    return _mm256_unpackhi_epi32(v, v);
+  }
+}
+#endif
+#if defined(__AVX512BW__)
+template <class T>
+static inline __m512i repeat_lo(__m512i v) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm512_unpacklo_epi8(v, v);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm512_unpacklo_epi16(v, v);
+  } else {
+    return _mm512_unpacklo_epi32(v, v);
+  }
+}
+template <class T>
+static inline __m512i repeat_hi(__m512i v) {
+  if constexpr (sizeof(T) == 1) {
+    return _mm512_unpackhi_epi8(v, v);
+  } else if constexpr (sizeof(T) == 2) {
+    return _mm512_unpackhi_epi16(v, v);
+  } else {
+    return _mm512_unpackhi_epi32(v, v);
+  }
+}
+#endif
+#endif
+
+// dst[i] = src[i / 2] for i < len (len samples out of (len + 1) / 2)
+template <class T>
+static void upsample_h2(const T *src, T *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  constexpr size_t lanes = 16 / sizeof(T);  // per 128-bit vector
+  for (; i + 2 * lanes <= len; i += 2 * lanes) {
+    store_twice(dst + i, src + i / 2);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  constexpr size_t lanes = 16 / sizeof(T);  // per 128-bit vector
+  #if defined(__AVX512BW__)
+  // the unpacks work within 128-bit lanes: the 128-bit halves of the results are put back in order
+  const __m512i first  = _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11);
+  const __m512i second = _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15);
+  for (; i + 8 * lanes <= len; i += 8 * lanes) {
+    const __m512i v  = _mm512_loadu_si512((const void *)(src + i / 2));
+    const __m512i lo = repeat_lo<T>(v);
+    const __m512i hi = repeat_hi<T>(v);
+    _mm512_storeu_si512((void *)(dst + i), _mm512_permutex2var_epi64(lo, first, hi));
+    _mm512_storeu_si512((void *)(dst + i + 4 * lanes), _mm512_permutex2var_epi64(lo, second, hi));
+  }
+  #elif defined(__AVX2__)
+  for (; i + 4 * lanes <= len; i += 4 * lanes) {
+    const __m256i v  = _mm256_loadu_si256((const __m256i *)(src + i / 2));
+    const __m256i lo = repeat_lo<T>(v);
+    const __m256i hi = repeat_hi<T>(v);
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_permute2x128_si256(lo, hi, 0x20));
+    _mm256_storeu_si256((__m256i *)(dst + i + 2 * lanes), _mm256_permute2x128_si256(lo, hi, 0x31));
+  }
+  #endif
+  for (; i + 2 * lanes <= len; i += 2 * lanes) {
+    const __m128i v = _mm_loadu_si128((const __m128i *)(src + i / 2));
+    _mm_storeu_si128((__m128i *)(dst + i), repeat_lo<T>(v));
+    _mm_storeu_si128((__m128i *)(dst + i + lanes), repeat_hi<T>(v));
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = src[i / 2];
+  }
+}
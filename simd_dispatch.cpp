@@ -0,0 +1,176 @@
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#include "simd_dispatch.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+  #define IMAGE_IO_X86
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <cpuid.h>
+  #endif
+#endif
+
+extern const kernel_table kernels_scalar;
+#if defined(IMAGE_IO_X86)
+extern const kernel_table kernels_sse41;
+extern const kernel_table kernels_avx2;
+extern const kernel_table kernels_avx512;
+#endif
+
+#if defined(IMAGE_IO_X86)
+static void cpuid(uint32_t leaf, uint32_t subleaf, uint32_t reg[4]) {
+  #if defined(_MSC_VER)
+  int r[4];
+  __cpuidex(r, static_cast<int>(leaf), static_cast<int>(subleaf));
+  for (int i = 0; i < 4; ++i) {
+    reg[i] = static_cast<uint32_t>(r[i]);
+  }
+  #else
+  __cpuid_count(leaf, subleaf, reg[0], reg[1], reg[2], reg[3]);
+  #endif
+}
+
+// XCR0: register states enabled by the OS
+static uint64_t xgetbv0() {
+  #if defined(_MSC_VER)
+  return _xgetbv(0);
+  #else
+  uint32_t lo, hi;
+  __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+  return (static_cast<uint64_t>(hi) << 32) | lo;
+  #endif
+}
+#endif
+
+simd_level detect_simd_level() {
+#if defined(IMAGE_IO_X86)
+  uint32_t r[4];  // eax, ebx, ecx, edx
+  cpuid(0, 0, r);
+  const uint32_t max_leaf = r[0];
+  if (max_leaf < 1) {
+    return simd_level::SCALAR;
+  }
+  cpuid(1, 0, r);
+  const bool sse41   = (r[2] >> 19) & 1;
+  const bool osxsave = (r[2] >> 27) & 1;
+  const bool avx     = (r[2] >> 28) & 1;
+  if (!sse41) {
+    return simd_level::SCALAR;
+  }
+  if (!osxsave || !avx || max_leaf < 7) {
+    return simd_level::SSE41;
+  }
+  const uint64_t xcr0 = xgetbv0();
+  if ((xcr0 & 0x6) != 0x6) {  // XMM and YMM state
+    return simd_level::SSE41;
+  }
+  cpuid(7, 0, r);
+  const bool avx2     = (r[1] >> 5) & 1;
+  const bool avx512f  = (r[1] >> 16) & 1;
+  const bool avx512bw = (r[1] >> 30) & 1;
+  const bool avx512vl = (r[1] >> 31) & 1;
+  const bool vbmi     = (r[2] >> 1) & 1;
+  if (!avx2) {
+    return simd_level::SSE41;
+  }
+  // opmask, ZMM0-15 and ZMM16-31 state
+  if (avx512f && avx512bw && avx512vl && vbmi && (xcr0 & 0xE0) == 0xE0) {
+    return simd_level::AVX512;
+  }
+  return simd_level::AVX2;
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+  return simd_level::NEON;
+#else
+  return simd_level::SCALAR;
+#endif
+}
+
+const kernel_table *find_kernels(simd_level level) {
+  if (level > detect_simd_level()) {
+    return nullptr;
+  }
+  switch (level) {
+    case simd_level::SCALAR:
+    case simd_level::NEON:
+      // the baseline unit holds NEON kernels on ARM and scalar kernels elsewhere
+      return (kernels_scalar.level == level) ? &kernels_scalar : nullptr;
+#if defined(IMAGE_IO_X86)
+    case simd_level::SSE41:
+      return &kernels_sse41;
+    case simd_level::AVX2:
+      return &kernels_avx2;
+    case simd_level::AVX512:
+      return &kernels_avx512;
+#endif
+    default:
+      return nullptr;
+  }
+}
+
+const char *simd_level_name(simd_level level) {
+  switch (level) {
+    case simd_level::SCALAR:
+      return "scalar";
+    case simd_level::NEON:
+      return "neon";
+    case simd_level::SSE41:
+      return "sse41";
+    case simd_level::AVX2:
+      return "avx2";
+    case simd_level::AVX512:
+      return "avx512";
+  }
+  return "unknown";
+}
+
+// detected level, lowered to IMAGE_IO_SIMD if that is set to a supported level
+static const kernel_table *select_kernels() {
+  const kernel_table *k = find_kernels(detect_simd_level());
+  if (k == nullptr) {
+    k = &kernels_scalar;
+  }
+  const char *env = getenv("IMAGE_IO_SIMD");
+  if (env == nullptr || env[0] == '\0') {
+    return k;
+  }
+  for (simd_level l : {simd_level::SCALAR, simd_level::NEON, simd_level::SSE41, simd_level::AVX2,
+                       simd_level::AVX512}) {
+    if (strcmp(env, simd_level_name(l)) == 0) {
+      const kernel_table *forced = find_kernels(l);
+      if (forced != nullptr) {
+        return forced;
+      }
+      printf("WARNING: IMAGE_IO_SIMD=%s is not supported on this CPU, %s is used.\n", env,
+             simd_level_name(k->level));
+      return k;
+    }
+  }
+  printf("WARNING: unknown IMAGE_IO_SIMD=%s, %s is used.\n", env, simd_level_name(k->level));
+  return k;
+}
+
+static std::atomic<const kernel_table *> active_kernels{nullptr};
+
+const kernel_table &get_kernels() {
+  const kernel_table *k = active_kernels.load(std::memory_order_acquire);
+  if (k == nullptr) {
+    // concurrent first calls select the same table
+    k = select_kernels();
+    active_kernels.store(k, std::memory_order_release);
+  }
+  return *k;
+}
+
+simd_level get_simd_level() { return get_kernels().level; }
+
+bool set_simd_level(simd_level level) {
+  const kernel_table *k = find_kernels(level);
+  if (k == nullptr) {
+    return false;
+  }
+  active_kernels.store(k, std::memory_order_release);
+  return true;
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "typedef.hpp"
+
+/********************************************************************************
+ * runtime selection of the SIMD kernels
+ * the instruction set is detected once with cpuid; the environment variable
+ * IMAGE_IO_SIMD (scalar, neon, sse41, avx2, avx512) or set_simd_level() forces a
+ * lower level, e.g. for benchmarking; AVX512 requires F, BW, VL and VBMI (Ice Lake and later)
+ *******************************************************************************/
+enum class simd_level { SCALAR, NEON, SSE41, AVX2, AVX512 };
+
+/**
+ * @brief Range of the L, M and S mixing values (before clamping) observed during conversion
+ */
+struct xyb_stats {
+  i32 Lmax = INT32_MIN, Lmin = INT32_MAX;
+  i32 Mmax = INT32_MIN, Mmin = INT32_MAX;
+  i32 Smax = INT32_MIN, Smin = INT32_MAX;
+
+  void merge(const xyb_stats &s) {
+    Lmax = std::max(Lmax, s.Lmax);
+    Lmin = std::min(Lmin, s.Lmin);
+    Mmax = std::max(Mmax, s.Mmax);
+    Mmin = std::min(Mmin, s.Mmin);
+    Smax = std::max(Smax, s.Smax);
+    Smin = std::min(Smin, s.Smin);
+  }
+  void print() const {
+    printf("Lmax = %d, Lmin = %d\n", Lmax, Lmin);
+    printf("Mmax = %d, Mmin = %d\n", Mmax, Mmin);
+    printf("Smax = %d, Smin = %d\n", Smax, Smin);
+  }
+};
+// the empty range; constant-initialized, so that assigning it in a kernel unit (built with its own -m
+// flags) does not emit the inline constructor of xyb_stats there
+constexpr xyb_stats xyb_stats_empty{};
+
+// widen len samples of a raster held in memory into int32
+using unpack_fn = void (*)(const uint8_t *src, int32_t *dst, size_t len);
+// deinterleave len RGB pixels into three planes of int32
+using unpack_rgb_fn = void (*)(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B, size_t len);
+// convert len pixels of bpp-bit RGB into XYB, stats receives the range of the mixing values
+using rgb2xyb_fn = void (*)(const i32 *R, const i32 *G, const i32 *B, i32 *X, i32 *Y, i32 *Bo, size_t len,
+                            i32 bpp, xyb_stats &stats);
+// variants for planes held in narrow samples (see sample_type in image_io_local.hpp)
+using unpack_rgb_u8_fn  = void (*)(const uint8_t *src, uint8_t *R, uint8_t *G, uint8_t *B, size_t len);
+using unpack_rgb_u16_fn = void (*)(const uint8_t *src, uint16_t *R, uint16_t *G, uint16_t *B, size_t len);
+using unpack_u16_fn     = void (*)(const uint8_t *src, uint16_t *dst, size_t len);
+using unpack_s16_fn     = void (*)(const uint8_t *src, int16_t *dst, size_t len);
+// deinterleave len RGBA pixels (PAM of depth 4) into four planes, of int32 or of narrow samples
+using unpack_rgba_fn     = void (*)(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B, int32_t *A,
+                                    size_t len);
+using unpack_rgba_u8_fn  = void (*)(const uint8_t *src, uint8_t *R, uint8_t *G, uint8_t *B, uint8_t *A,
+                                    size_t len);
+using unpack_rgba_u16_fn = void (*)(const uint8_t *src, uint16_t *R, uint16_t *G, uint16_t *B, uint16_t *A,
+                                    size_t len);
+using rgb2xyb_u8_fn  = void (*)(const ui8 *R, const ui8 *G, const ui8 *B, i32 *X, i32 *Y, i32 *Bo,
+                               size_t len, i32 bpp, xyb_stats &stats);
+using rgb2xyb_u16_fn = void (*)(const ui16 *R, const ui16 *G, const ui16 *B, i32 *X, i32 *Y, i32 *Bo,
+                                size_t len, i32 bpp, xyb_stats &stats);
+// convert len pixels with the XYB lattice of xyb_lut3d.hpp; stats, if not null, receives the range of the
+// mixing values (null skips the matrix stage that computes them)
+struct xyb_lut3d;
+using rgb2xyb_lut3d_fn     = void (*)(const xyb_lut3d &lut, const i32 *R, const i32 *G, const i32 *B,
+                                      i32 *X, i32 *Y, i32 *Bo, size_t len, xyb_stats *stats);
+using rgb2xyb_u8_lut3d_fn  = void (*)(const xyb_lut3d &lut, const ui8 *R, const ui8 *G, const ui8 *B,
+                                      i32 *X, i32 *Y, i32 *Bo, size_t len, xyb_stats *stats);
+using rgb2xyb_u16_lut3d_fn = void (*)(const xyb_lut3d &lut, const ui16 *R, const ui16 *G, const ui16 *B,
+                                      i32 *X, i32 *Y, i32 *Bo, size_t len, xyb_stats *stats);
+// box filter of reduced reads: add a row of samples into an accumulator row, and sum adjacent columns
+// pairwise in place (see unpack_kernels.hpp)
+using box_accumulate_fn = void (*)(const int32_t *src, int32_t *acc, size_t len);
+using box_pair_sum_fn   = void (*)(int32_t *acc, size_t len);
+// widen a row halved horizontally back to len samples, each sample repeated (see resample_kernels.hpp)
+using upsample_u8_fn  = void (*)(const uint8_t *src, uint8_t *dst, size_t len);
+using upsample_u16_fn = void (*)(const uint16_t *src, uint16_t *dst, size_t len);
+using upsample_s32_fn = void (*)(const int32_t *src, int32_t *dst, size_t len);
+// narrow len int32 samples into the big-endian raster of a PGM/PGX file
+using pack_fn = void (*)(const int32_t *src, uint8_t *dst, size_t len);
+// interleave len pixels of three planes into the big-endian raster of a PPM file
+using pack_rgb_fn = void (*)(const int32_t *R, const int32_t *G, const int32_t *B, uint8_t *dst,
+                             size_t len);
+// variants for planes held in narrow samples
+using pack_rgb_u8_fn  = void (*)(const uint8_t *R, const uint8_t *G, const uint8_t *B, uint8_t *dst,
+                                size_t len);
+using pack_rgb_u16_fn = void (*)(const uint16_t *R, const uint16_t *G, const uint16_t *B, uint8_t *dst,
+                                 size_t len);
+using pack_s16_fn     = void (*)(const int16_t *src, uint8_t *dst, size_t len);
+// parse up to num plain (ASCII) PGM/PPM samples of src[0, len) into the raster of the binary format, used
+// receives the number of bytes consumed (see ascii_kernels.hpp); returns the number of samples stored
+using parse_ascii_fn = size_t (*)(const uint8_t *src, size_t len, uint8_t *dst, size_t num, uint32_t maxval,
+                                  size_t &used);
+
+struct kernel_table {
+  simd_level level;
+  unpack_fn unpack_u8_to_s32;
+  unpack_fn unpack_s8_to_s32;
+  unpack_fn unpack_big_u16_to_s32;
+  unpack_fn unpack_little_u16_to_s32;
+  unpack_fn unpack_big_s16_to_s32;
+  unpack_fn unpack_little_s16_to_s32;
+  unpack_fn unpack_big_32_to_s32;
+  unpack_fn unpack_little_32_to_s32;
+  unpack_rgb_fn unpack_rgb_u8_to_s32;
+  unpack_rgb_fn unpack_rgb_big_u16_to_s32;
+  rgb2xyb_fn rgb2xyb;
+  unpack_rgb_u8_fn unpack_rgb_u8_to_u8;
+  unpack_rgb_u16_fn unpack_rgb_big_u16_to_u16;
+  unpack_u16_fn unpack_big_16_to_16;
+  unpack_s16_fn unpack_s8_to_s16;
+  unpack_rgba_fn unpack_rgba_u8_to_s32;
+  unpack_rgba_fn unpack_rgba_big_u16_to_s32;
+  unpack_rgba_u8_fn unpack_rgba_u8_to_u8;
+  unpack_rgba_u16_fn unpack_rgba_big_u16_to_u16;
+  box_accumulate_fn box_accumulate;
+  box_pair_sum_fn box_pair_sum;
+  upsample_u8_fn upsample_h2_u8;
+  upsample_u16_fn upsample_h2_u16;
+  upsample_s32_fn upsample_h2_s32;
+  rgb2xyb_u8_fn rgb2xyb_u8;
+  rgb2xyb_u16_fn rgb2xyb_u16;
+  // the same conversions with the cube root of cbrt_poly_fix.hpp instead of table lookups
+  rgb2xyb_fn rgb2xyb_poly;
+  rgb2xyb_u8_fn rgb2xyb_u8_poly;
+  rgb2xyb_u16_fn rgb2xyb_u16_poly;
+  // tetrahedral interpolation in the lattice of xyb_lut3d.hpp
+  rgb2xyb_lut3d_fn rgb2xyb_lut3d;
+  rgb2xyb_u8_lut3d_fn rgb2xyb_u8_lut3d;
+  rgb2xyb_u16_lut3d_fn rgb2xyb_u16_lut3d;
+  pack_fn pack_s32_to_u8;
+  pack_fn pack_s32_to_s8;
+  pack_fn pack_s32_to_big_u16;
+  pack_fn pack_s32_to_big_s16;
+  pack_fn pack_s32_to_big_s32;
+  pack_s16_fn pack_s16_to_s8;
+  pack_rgb_fn pack_rgb_s32_to_u8;
+  pack_rgb_fn pack_rgb_s32_to_big_u16;
+  pack_rgb_u8_fn pack_rgb_u8_to_u8;
+  pack_rgb_u16_fn pack_rgb_u16_to_big_u16;
+  parse_ascii_fn parse_ascii_u8;
+  parse_ascii_fn parse_ascii_big_u16;
+};
+
+// highest level supported by the CPU and the OS
+simd_level detect_simd_level();
+// kernels of the active level
+const kernel_table &get_kernels();
+// kernels of a given level, nullptr if the level is not built in or not supported by the CPU
+const kernel_table *find_kernels(simd_level level);
+simd_level get_simd_level();
+// returns false (and keeps the active level) if level is not available
+bool set_simd_level(simd_level level);
+const char *simd_level_name(simd_level level);
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/********************************************************************************
+ * bounded lock-free queue for exactly one producer and one consumer thread
+ * the blocking push()/pop() spin with yield for a few rounds, then sleep on a
+ * condition variable until the other side makes progress, so that a stage
+ * waiting for a long one (e.g. a reader ahead of the converter) does not take
+ * a core from the thread pool
+ *******************************************************************************/
+template <class T>
+class spsc_queue {
+ private:
+  std::vector<T> slots;
+  const size_t mask;
+  // head is written by the consumer only, tail by the producer only; separate cache lines
+  alignas(64) std::atomic<size_t> head;
+  alignas(64) std::atomic<size_t> tail;
+  // the slow path of push()/pop(); waiters lets the fast path skip the mutex while nobody sleeps
+  alignas(64) std::atomic<int> waiters;
+  std::mutex mtx;
+  std::condition_variable progress;
+  static constexpr int spins = 16;  // yields before sleeping
+
+  // after head or tail moved: wake the other side if it sleeps
+  void wake() {
+    // orders the store to head/tail before the load of waiters (see wait_until())
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(mtx);
+      progress.notify_all();
+    }
+  }
+  // block until done() holds; done() is evaluated under the mutex, which wake() takes to notify, so a
+  // change made after the last evaluation cannot be missed
+  template <class Done>
+  void wait_until(Done &&done) {
+    for (int i = 0; i < spins; ++i) {
+      if (done()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mtx);
+    waiters.fetch_add(1, std::memory_order_seq_cst);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    progress.wait(lock, done);
+    waiters.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  static size_t round_up_pow2(size_t n) {
+    size_t p = 1;
+    while (p < n) {
+      p <<= 1;
+    }
+    return p;
+  }
+
+ public:
+  // capacity is rounded up to a power of two
+  explicit spsc_queue(size_t capacity)
+      : slots(round_up_pow2(capacity ? capacity : 1)),
+        mask(slots.size() - 1),
+        head(0),
+        tail(0),
+        waiters(0) {}
+  spsc_queue(const spsc_queue &)            = delete;
+  spsc_queue &operator=(const spsc_queue &) = delete;
+
+  size_t capacity() const { return slots.size(); }
+
+  // v is left untouched if the queue is full; the try_ calls never block nor wake a blocked peer, so a
+  // queue used with push()/pop() on one side shall use them on the other side too
+  bool try_push(T &&v) {
+    const size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == slots.size()) {
+      return false;
+    }
+    slots[t & mask] = std::move(v);
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+  bool try_pop(T &v) {
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) {
+      return false;
+    }
+    v = std::move(slots[h & mask]);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+  void push(T &&v) {
+    wait_until([&] { return try_push(std::move(v)); });
+    wake();
+  }
+  T pop() {
+    T v;
+    wait_until([&] { return try_pop(v); });
+    wake();
+    return v;
+  }
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+/********************************************************************************
+ * persistent pool of worker threads, reusable across images
+ *******************************************************************************/
+class thread_pool {
+ private:
+  std::vector<std::thread> workers;
+  std::queue<std::function<void()>> tasks;
+  std::mutex mtx;
+  std::condition_variable cv;
+  bool stop;
+
+ public:
+  // num_threads = 0 selects the number of hardware threads
+  explicit thread_pool(size_t num_threads = 0) : stop(false) {
+    if (num_threads == 0) {
+      num_threads = std::thread::hardware_concurrency();
+    }
+    num_threads = (num_threads == 0) ? 1 : num_threads;
+    workers.reserve(num_threads);
+    for (size_t i = 0; i < num_threads; ++i) {
+      workers.emplace_back([this] {
+        for (;;) {
+          std::function<void()> task;
+          {
+            std::unique_lock<std::mutex> lock(mtx);
+            cv.wait(lock, [this] { return stop || !tasks.empty(); });
+            if (stop && tasks.empty()) {
+              return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+          }
+          task();
+        }
+      });
+    }
+  }
+  thread_pool(const thread_pool &)            = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      stop = true;
+    }
+    cv.notify_all();
+    for (auto &w : workers) {
+      w.join();
+    }
+  }
+  size_t get_num_threads() const { return workers.size(); }
+  // exceptions thrown by f are rethrown from future::get()
+  template <class F>
+  std::future<void> enqueue(F &&f) {
+    auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+    auto ret  = task->get_future();
+    {
+      std::lock_guard<std::mutex> lock(mtx);
+      tasks.emplace([task] { (*task)(); });
+    }
+    cv.notify_one();
+    return ret;
+  }
+};
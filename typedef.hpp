@@ -5,7 +5,10 @@
 #ifndef IMAGE_IO_TEST_TYPEDEF_HPP
 #define IMAGE_IO_TEST_TYPEDEF_HPP
 
-#include <arm_neon.h>
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #include <arm_neon.h>
+#endif
+#include <cassert>
 #include <cstdint>
 using ui64 = uint64_t;
 using ui32 = uint32_t;
@@ -35,6 +38,9 @@ static T saturate(T val, T limit) {
   return ret;
 }
 
+// the kernel units are compiled with different -m flags: an inline member function of external linkage
+// could be taken from any of them, so the coefficient classes are internal to each unit
+namespace {
 class mat_coeff {
  public:
   const ui32 val;
@@ -44,6 +50,7 @@ class mat_coeff {
   inline i32 mul(ui32 v) const { return (val * v) >> rshift; }
 };
 
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
 class mat_coeff_neon {
  public:
   const uint32x4_t val;
@@ -52,5 +59,7 @@ class mat_coeff_neon {
   explicit mat_coeff_neon(ui32 v, ui32 rs) : val(vdupq_n_u32(v)), rshift(vdupq_n_s32(rs)) {}
   inline int32x4_t mul(uint32x4_t v) const { return vshlq_u32(vmulq_u32(val, v), -rshift); }
 };
+#endif
+}  // namespace
 
 #endif  // IMAGE_IO_TEST_TYPEDEF_HPP
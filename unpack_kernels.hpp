@@ -0,0 +1,1125 @@
+#pragma once
+/********************************************************************************
+ * SIMD unpack kernels (PGM/PGX widening, PPM and PAM deinterleave)
+ * included by the kernels_*.cpp translation units only; each of them is compiled
+ * with its own target flags, so the #if blocks below select the code path of the
+ * instruction set of the including unit
+ *******************************************************************************/
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+  #define USE_ARM_NEON
+  #include <arm_neon.h>
+#elif defined(__AVX2__) || defined(__SSE4_1__) || defined(__MINGW64__)
+  #if defined(__AVX2__) || defined(__MINGW64__)
+    #define USEAVX2
+  #endif
+  #if defined(_MSC_VER)
+    #include <intrin.h>
+  #else
+    #include <x86intrin.h>
+  #endif
+#endif
+
+#if defined(USE_ARM_NEON)
+// store uint8x16_t vector as int32
+static auto store_u8_to_s32(uint8x16_t &src, int32_t *dst) {
+  int16x8_t l = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(src)));
+  int16x8_t h = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(src)));
+  auto ll     = vmovl_s16(vget_low_s16(l));
+  auto lh     = vmovl_s16(vget_high_s16(l));
+  auto hl     = vmovl_s16(vget_low_s16(h));
+  auto hh     = vmovl_s16(vget_high_s16(h));
+  vst1q_s32(dst, ll);
+  vst1q_s32(dst + 4, lh);
+  vst1q_s32(dst + 8, hl);
+  vst1q_s32(dst + 12, hh);
+}
+
+// store uint8x16_t vector as uint32
+static auto store_u8_to_u32(uint8x16_t &src, int32_t *dst) {
+  int16x8_t l = vmovl_u8(vget_low_u8(src));
+  int16x8_t h = vmovl_u8(vget_high_u8(src));
+  auto ll     = vmovl_u16(vget_low_u16(l));
+  auto lh     = vmovl_u16(vget_high_u16(l));
+  auto hl     = vmovl_u16(vget_low_u16(h));
+  auto hh     = vmovl_u16(vget_high_u16(h));
+  vst1q_s32(dst, ll);
+  vst1q_s32(dst + 4, lh);
+  vst1q_s32(dst + 8, hl);
+  vst1q_s32(dst + 12, hh);
+}
+
+// store int8x16_t vector as int32
+static auto store_s8_to_s32(int8x16_t &src, int32_t *dst) {
+  int16x8_t l = vreinterpretq_s16_u16(vmovl_s8(vget_low_s8(src)));
+  int16x8_t h = vreinterpretq_s16_u16(vmovl_s8(vget_high_s8(src)));
+  auto ll     = vmovl_s16(vget_low_s16(l));
+  auto lh     = vmovl_s16(vget_high_s16(l));
+  auto hl     = vmovl_s16(vget_low_s16(h));
+  auto hh     = vmovl_s16(vget_high_s16(h));
+  vst1q_s32(dst, ll);
+  vst1q_s32(dst + 4, lh);
+  vst1q_s32(dst + 8, hl);
+  vst1q_s32(dst + 12, hh);
+}
+
+// store int8x16_t vector as uint32
+static auto store_s8_to_u32(int8x16_t &src, int32_t *dst) {
+  int16x8_t l = vmovl_u8(vget_low_u8(src));
+  int16x8_t h = vmovl_u8(vget_high_u8(src));
+  auto ll     = vmovl_u16(vget_low_u16(l));
+  auto lh     = vmovl_u16(vget_high_u16(l));
+  auto hl     = vmovl_u16(vget_low_u16(h));
+  auto hh     = vmovl_u16(vget_high_u16(h));
+  vst1q_s32(dst, ll);
+  vst1q_s32(dst + 4, lh);
+  vst1q_s32(dst + 8, hl);
+  vst1q_s32(dst + 12, hh);
+}
+
+// store big-endian uint16x8_t vector as int32
+static inline auto store_big_u16_to_s32(uint16x8_t &src, int32_t *dst) {
+  auto little_big = vrev16q_u8(src);  // convert endianness from big to little
+  auto x0         = vreinterpretq_s32_u16(little_big);
+  auto xl         = vmovl_s16(vreinterpret_s16_s32(vget_low_s32(x0)));
+  auto xh         = vmovl_s16(vreinterpret_s16_s32(vget_high_s32(x0)));
+  vst1q_s32(dst, xl);
+  vst1q_s32(dst + 4, xh);
+}
+
+// store big-endian uint16x8_t vector as uint32
+static inline auto store_big_u16_to_u32(uint16x8_t &src, int32_t *dst) {
+  auto little_big = vrev16q_u8(src);  // convert endianness from big to little
+  auto x0         = vreinterpretq_u32_u16(little_big);
+  auto xl         = vmovl_u16(vreinterpret_u16_u32(vget_low_u32(x0)));
+  auto xh         = vmovl_u16(vreinterpret_u16_u32(vget_high_u32(x0)));
+  vst1q_s32(dst, xl);
+  vst1q_s32(dst + 4, xh);
+}
+
+// store little-endian uint16x8_t vector as int32
+static inline auto store_little_u16_to_s32(uint16x8_t &src, int32_t *dst) {
+  auto x0 = vreinterpretq_s32_u16(vreinterpretq_u16_u8(src));
+  auto xl = vmovl_s16(vreinterpret_s16_s32(vget_low_s32(x0)));
+  auto xh = vmovl_s16(vreinterpret_s16_s32(vget_high_s32(x0)));
+  vst1q_s32(dst, xl);
+  vst1q_s32(dst + 4, xh);
+}
+
+// store big-endian int16x8_t vector as int32
+static inline auto store_big_s16_to_s32(uint16x8_t &src, int32_t *dst) {
+  auto x0 = vreinterpretq_s32_s16(vreinterpretq_s16_u8(vrev16q_u8(src)));
+  auto xl = vmovl_s16(vreinterpret_s16_s32(vget_low_s32(x0)));
+  auto xh = vmovl_s16(vreinterpret_s16_s32(vget_high_s32(x0)));
+  vst1q_s32(dst, xl);
+  vst1q_s32(dst + 4, xh);
+}
+
+// store little-endian int16x8_t vector as int32
+static inline auto store_little_s16_to_s32(uint16x8_t &src, int32_t *dst) {
+  auto x0 = vreinterpretq_s32_s16(vreinterpretq_s16_u8(src));
+  auto xl = vmovl_s16(vreinterpret_s16_s32(vget_low_s32(x0)));
+  auto xh = vmovl_s16(vreinterpret_s16_s32(vget_high_s32(x0)));
+  vst1q_s32(dst, xl);
+  vst1q_s32(dst + 4, xh);
+}
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+// byte order reversal of 16-bit lanes
+alignas(16) static const int8_t mask16_swap[16] = {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14};
+
+// store 16 x uint8 as int32
+static inline void store_u8_to_s32(__m128i src, int32_t *dst) {
+  #if defined(__AVX2__)
+  _mm256_storeu_si256((__m256i *)dst, _mm256_cvtepu8_epi32(src));
+  _mm256_storeu_si256((__m256i *)(dst + 8), _mm256_cvtepu8_epi32(_mm_srli_si128(src, 8)));
+  #else
+  _mm_storeu_si128((__m128i *)dst, _mm_cvtepu8_epi32(src));
+  _mm_storeu_si128((__m128i *)(dst + 4), _mm_cvtepu8_epi32(_mm_srli_si128(src, 4)));
+  _mm_storeu_si128((__m128i *)(dst + 8), _mm_cvtepu8_epi32(_mm_srli_si128(src, 8)));
+  _mm_storeu_si128((__m128i *)(dst + 12), _mm_cvtepu8_epi32(_mm_srli_si128(src, 12)));
+  #endif
+}
+
+// store 16 x int8 as int32
+static inline void store_s8_to_s32(__m128i src, int32_t *dst) {
+  #if defined(__AVX2__)
+  _mm256_storeu_si256((__m256i *)dst, _mm256_cvtepi8_epi32(src));
+  _mm256_storeu_si256((__m256i *)(dst + 8), _mm256_cvtepi8_epi32(_mm_srli_si128(src, 8)));
+  #else
+  _mm_storeu_si128((__m128i *)dst, _mm_cvtepi8_epi32(src));
+  _mm_storeu_si128((__m128i *)(dst + 4), _mm_cvtepi8_epi32(_mm_srli_si128(src, 4)));
+  _mm_storeu_si128((__m128i *)(dst + 8), _mm_cvtepi8_epi32(_mm_srli_si128(src, 8)));
+  _mm_storeu_si128((__m128i *)(dst + 12), _mm_cvtepi8_epi32(_mm_srli_si128(src, 12)));
+  #endif
+}
+
+// store little-endian 8 x uint16 as int32
+static inline void store_little_u16_to_s32(__m128i src, int32_t *dst) {
+  #if defined(__AVX2__)
+  _mm256_storeu_si256((__m256i *)dst, _mm256_cvtepu16_epi32(src));
+  #else
+  _mm_storeu_si128((__m128i *)dst, _mm_cvtepu16_epi32(src));
+  _mm_storeu_si128((__m128i *)(dst + 4), _mm_cvtepu16_epi32(_mm_srli_si128(src, 8)));
+  #endif
+}
+
+// store little-endian 8 x int16 as int32
+static inline void store_little_s16_to_s32(__m128i src, int32_t *dst) {
+  #if defined(__AVX2__)
+  _mm256_storeu_si256((__m256i *)dst, _mm256_cvtepi16_epi32(src));
+  #else
+  _mm_storeu_si128((__m128i *)dst, _mm_cvtepi16_epi32(src));
+  _mm_storeu_si128((__m128i *)(dst + 4), _mm_cvtepi16_epi32(_mm_srli_si128(src, 8)));
+  #endif
+}
+
+// store big-endian 8 x uint16 as int32
+static inline void store_big_u16_to_s32(__m128i src, int32_t *dst) {
+  store_little_u16_to_s32(_mm_shuffle_epi8(src, *(const __m128i *)mask16_swap), dst);
+}
+
+// store big-endian 8 x int16 as int32
+static inline void store_big_s16_to_s32(__m128i src, int32_t *dst) {
+  store_little_s16_to_s32(_mm_shuffle_epi8(src, *(const __m128i *)mask16_swap), dst);
+}
+
+#if defined(__AVX512BW__)
+// byte order reversal of 16-bit lanes in a 512-bit vector
+static inline __m512i swap16_avx512(__m512i v) {
+  return _mm512_shuffle_epi8(v, _mm512_broadcast_i32x4(*(const __m128i *)mask16_swap));
+}
+
+/**
+ * @brief permutation indices that split three vectors (a, b, c) of interleaved RGB samples into one
+ * channel: lanes found in a or b are gathered with a two-source permute by ab[ch], the remaining lanes
+ * (set in mask_c[ch]) are taken from c by c[ch]
+ */
+struct rgb_split_u16_idx {
+  alignas(64) uint16_t ab[3][32];
+  alignas(64) uint16_t c[3][32];
+  uint32_t mask_c[3];
+};
+static constexpr rgb_split_u16_idx make_rgb_split_u16_idx() {
+  rgb_split_u16_idx t{};
+  for (int ch = 0; ch < 3; ++ch) {
+    for (int i = 0; i < 32; ++i) {
+      const int pos = 3 * i + ch;
+      t.ab[ch][i]   = static_cast<uint16_t>(pos & 63);
+      t.c[ch][i]    = static_cast<uint16_t>(pos & 31);
+      if (pos >= 64) {
+        t.mask_c[ch] |= uint32_t(1) << i;
+      }
+    }
+  }
+  return t;
+}
+static constexpr rgb_split_u16_idx rgb_split_u16 = make_rgb_split_u16_idx();
+
+// split 32 big-endian RGB pixels (vpermt2w + vpermw) into native-endian channels
+static inline void deinterleave_rgb_u16_avx512(const uint8_t *src, __m512i v[3]) {
+  const __m512i a = _mm512_loadu_si512((const void *)src);
+  const __m512i b = _mm512_loadu_si512((const void *)(src + 64));
+  const __m512i c = _mm512_loadu_si512((const void *)(src + 128));
+  for (int ch = 0; ch < 3; ++ch) {
+    v[ch] = _mm512_permutex2var_epi16(a, _mm512_load_si512((const void *)rgb_split_u16.ab[ch]), b);
+    v[ch] = _mm512_mask_permutexvar_epi16(v[ch], rgb_split_u16.mask_c[ch],
+                                          _mm512_load_si512((const void *)rgb_split_u16.c[ch]), c);
+    v[ch] = swap16_avx512(v[ch]);
+  }
+}
+
+static inline void load_u16_store_s32_avx512(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B) {
+  __m512i v[3];
+  deinterleave_rgb_u16_avx512(src, v);
+  int32_t *const d[3] = {R, G, B};
+  for (int ch = 0; ch < 3; ++ch) {
+    _mm512_storeu_si512((void *)d[ch], _mm512_cvtepu16_epi32(_mm512_castsi512_si256(v[ch])));
+    _mm512_storeu_si512((void *)(d[ch] + 16), _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(v[ch], 1)));
+  }
+}
+
+static inline void load_u16_store_u16_avx512(const uint8_t *src, uint16_t *R, uint16_t *G, uint16_t *B) {
+  __m512i v[3];
+  deinterleave_rgb_u16_avx512(src, v);
+  _mm512_storeu_si512((void *)R, v[0]);
+  _mm512_storeu_si512((void *)G, v[1]);
+  _mm512_storeu_si512((void *)B, v[2]);
+}
+#endif
+
+#if defined(__AVX512VBMI__)
+// byte-granular counterpart of rgb_split_u16_idx
+struct rgb_split_u8_idx {
+  alignas(64) uint8_t ab[3][64];
+  alignas(64) uint8_t c[3][64];
+  uint64_t mask_c[3];
+};
+static constexpr rgb_split_u8_idx make_rgb_split_u8_idx() {
+  rgb_split_u8_idx t{};
+  for (int ch = 0; ch < 3; ++ch) {
+    for (int i = 0; i < 64; ++i) {
+      const int pos = 3 * i + ch;
+      t.ab[ch][i]   = static_cast<uint8_t>(pos & 127);
+      t.c[ch][i]    = static_cast<uint8_t>(pos & 63);
+      if (pos >= 128) {
+        t.mask_c[ch] |= uint64_t(1) << i;
+      }
+    }
+  }
+  return t;
+}
+static constexpr rgb_split_u8_idx rgb_split_u8 = make_rgb_split_u8_idx();
+
+// split 64 RGB pixels (vpermt2b + vpermb) into one vector per channel
+static inline void deinterleave_rgb_u8_avx512(const uint8_t *src, __m512i v[3]) {
+  const __m512i a = _mm512_loadu_si512((const void *)src);
+  const __m512i b = _mm512_loadu_si512((const void *)(src + 64));
+  const __m512i c = _mm512_loadu_si512((const void *)(src + 128));
+  for (int ch = 0; ch < 3; ++ch) {
+    v[ch] = _mm512_permutex2var_epi8(a, _mm512_load_si512((const void *)rgb_split_u8.ab[ch]), b);
+    v[ch] = _mm512_mask_permutexvar_epi8(v[ch], rgb_split_u8.mask_c[ch],
+                                         _mm512_load_si512((const void *)rgb_split_u8.c[ch]), c);
+  }
+}
+
+static inline void load_u8_store_s32_avx512(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B) {
+  __m512i v[3];
+  deinterleave_rgb_u8_avx512(src, v);
+  int32_t *const d[3] = {R, G, B};
+  for (int ch = 0; ch < 3; ++ch) {
+    _mm512_storeu_si512((void *)d[ch], _mm512_cvtepu8_epi32(_mm512_castsi512_si128(v[ch])));
+    _mm512_storeu_si512((void *)(d[ch] + 16), _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(v[ch], 1)));
+    _mm512_storeu_si512((void *)(d[ch] + 32), _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(v[ch], 2)));
+    _mm512_storeu_si512((void *)(d[ch] + 48), _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(v[ch], 3)));
+  }
+}
+
+static inline void load_u8_store_u8_avx512(const uint8_t *src, uint8_t *R, uint8_t *G, uint8_t *B) {
+  __m512i v[3];
+  deinterleave_rgb_u8_avx512(src, v);
+  _mm512_storeu_si512((void *)R, v[0]);
+  _mm512_storeu_si512((void *)G, v[1]);
+  _mm512_storeu_si512((void *)B, v[2]);
+}
+#endif
+
+// split 16 interleaved RGB pixels into one vector per channel
+static inline void deinterleave_rgb_u8(uint8_t const *src, __m128i &v0, __m128i &v1, __m128i &v2) {
+  __m128i tmp0, tmp1, tmp2, tmp3;
+  alignas(16) static const int8_t mask8_R[16] = {0, 3, 6, 9, 12, 15, 1, 4, 7, 10, 13, 2, 5, 8, 11, 14};
+  alignas(16) static const int8_t mask8_G[16] = {2, 5, 8, 11, 14, 0, 3, 6, 9, 12, 15, 1, 4, 7, 10, 13};
+  alignas(16) static const int8_t mask8_B[16] = {1, 4, 7, 10, 13, 2, 5, 8, 11, 14, 0, 3, 6, 9, 12, 15};
+
+  v0 = _mm_loadu_si128((__m128i *)src);
+  v1 = _mm_loadu_si128((__m128i *)(src + 16));
+  v2 = _mm_loadu_si128((__m128i *)(src + 32));
+
+  tmp0 = _mm_shuffle_epi8(v0, *(__m128i *)mask8_R);  // a:0,3,6,9,12,15,1,4,7,10,13,2,5,8,11
+  tmp1 = _mm_shuffle_epi8(v1, *(__m128i *)mask8_G);  // b:2,5,8,11,14,0,3,6,9,12,15,1,4,7,10,13
+  tmp2 = _mm_shuffle_epi8(v2, *(__m128i *)mask8_B);  // c:1,4,7,10,13,2,5,8,11,14,3,6,9,12,15
+
+  tmp3 = _mm_slli_si128(tmp0, 10);         // 0,0,0,0,0,0,0,0,0,0,a0,a3,a6,a9,a12,a15
+  tmp3 = _mm_alignr_epi8(tmp1, tmp3, 10);  // a:0,3,6,9,12,15,b:2,5,8,11,14,x,x,x,x,x
+  tmp3 = _mm_slli_si128(tmp3, 5);          // 0,0,0,0,0,a:0,3,6,9,12,15,b:2,5,8,11,14,
+  tmp3 = _mm_srli_si128(tmp3, 5);          // a:0,3,6,9,12,15,b:2,5,8,11,14,:0,0,0,0,0
+  v0 = _mm_slli_si128(tmp2, 11);           // 0,0,0,0,0,0,0,0,0,0,0,0, 1,4,7,10,13,
+  v0 = _mm_or_si128(v0, tmp3);             // a:0,3,6,9,12,15,b:2,5,8,11,14,c:1,4,7,10,13,
+
+  tmp3 = _mm_slli_si128(tmp0, 5);   // 0,0,0,0,0,a:0,3,6,9,12,15,1,4,7,10,13,
+  tmp3 = _mm_srli_si128(tmp3, 11);  // a:1,4,7,10,13, 0,0,0,0,0,0,0,0,0,0,0
+  v1 = _mm_srli_si128(tmp1, 5);     // b:0,3,6,9,12,15,C:1,4,7,10,13, 0,0,0,0,0
+  v1 = _mm_slli_si128(v1, 5);       // 0,0,0,0,0,b:0,3,6,9,12,15,C:1,4,7,10,13,
+  v1 = _mm_or_si128(v1, tmp3);      // a:1,4,7,10,13,b:0,3,6,9,12,15,C:1,4,7,10,13,
+  v1 = _mm_slli_si128(v1, 5);       // 0,0,0,0,0,a:1,4,7,10,13,b:0,3,6,9,12,15,
+  v1 = _mm_srli_si128(v1, 5);       // a:1,4,7,10,13,b:0,3,6,9,12,15,0,0,0,0,0
+  tmp3 = _mm_srli_si128(tmp2, 5);   // c:2,5,8,11,14,0,3,6,9,12,15,0,0,0,0,0
+  tmp3 = _mm_slli_si128(tmp3, 11);  // 0,0,0,0,0,0,0,0,0,0,0,c:2,5,8,11,14,
+  v1 = _mm_or_si128(v1, tmp3);      // a:1,4,7,10,13,b:0,3,6,9,12,15,c:2,5,8,11,14,
+
+  tmp3 = _mm_srli_si128(tmp2, 10);  // c:0,3,6,9,12,15, 0,0,0,0,0,0,0,0,0,0,
+  tmp3 = _mm_slli_si128(tmp3, 10);  // 0,0,0,0,0,0,0,0,0,0, c:0,3,6,9,12,15,
+  v2 = _mm_srli_si128(tmp1, 11);    // b:1,4,7,10,13,0,0,0,0,0,0,0,0,0,0,0
+  v2 = _mm_slli_si128(v2, 5);       // 0,0,0,0,0,b:1,4,7,10,13, 0,0,0,0,0,0
+  v2 = _mm_or_si128(v2, tmp3);      // 0,0,0,0,0,b:1,4,7,10,13,c:0,3,6,9,12,15,
+  tmp0 = _mm_srli_si128(tmp0, 11);  // a:2,5,8,11,14, 0,0,0,0,0,0,0,0,0,0,0,
+  v2 = _mm_or_si128(v2, tmp0);      // a:2,5,8,11,14,b:1,4,7,10,13,c:0,3,6,9,12,15,
+}
+
+static auto load_u8_store_s32(uint8_t const *src, int32_t *const R, int32_t *const G, int32_t *const B) {
+  __m128i v0, v1, v2;
+  deinterleave_rgb_u8(src, v0, v1, v2);
+  store_u8_to_s32(v0, R);
+  store_u8_to_s32(v1, G);
+  store_u8_to_s32(v2, B);
+}
+
+static auto load_u8_store_u8(uint8_t const *src, uint8_t *const R, uint8_t *const G, uint8_t *const B) {
+  __m128i v0, v1, v2;
+  deinterleave_rgb_u8(src, v0, v1, v2);
+  _mm_storeu_si128((__m128i *)R, v0);
+  _mm_storeu_si128((__m128i *)G, v1);
+  _mm_storeu_si128((__m128i *)B, v2);
+}
+
+// split 8 interleaved RGB pixels (16-bit samples, byte order kept) into one vector per channel
+static inline void deinterleave_rgb_u16(uint16_t const *src, __m128i &v0, __m128i &v1, __m128i &v2) {
+  __m128i tmp0, tmp1, tmp2, tmp3;
+  alignas(16) static const int8_t mask16_0[16] = {0, 1, 6, 7, 12, 13, 2, 3, 8, 9, 14, 15, 4, 5, 10, 11};
+  alignas(16) static const int8_t mask16_1[16] = {2, 3, 8, 9, 14, 15, 4, 5, 10, 11, 0, 1, 6, 7, 12, 13};
+  alignas(16) static const int8_t mask16_2[16] = {4, 5, 10, 11, 0, 1, 6, 7, 12, 13, 2, 3, 8, 9, 14, 15};
+
+  v0 = _mm_loadu_si128((__m128i *)(src));       // a0,a1,a2,a3,...a7,
+  v1 = _mm_loadu_si128((__m128i *)(src + 8));   // b0,b1,b2,b3...b7
+  v2 = _mm_loadu_si128((__m128i *)(src + 16));  // c0,c1,c2,c3,...c7
+
+  tmp0 = _mm_shuffle_epi8(v0, *(__m128i *)mask16_0);  // a0,a3,a6,a1,a4,a7,a2,a5,
+  tmp1 = _mm_shuffle_epi8(v1, *(__m128i *)mask16_1);  // b1,b4,b7,b2,b5,b0,b3,b6
+  tmp2 = _mm_shuffle_epi8(v2, *(__m128i *)mask16_2);  // c2,c5, c0,c3,c6, c1,c4,c7
+
+  tmp3 = _mm_slli_si128(tmp0, 10);         // 0,0,0,0,0,a0,a3,a6,
+  tmp3 = _mm_alignr_epi8(tmp1, tmp3, 10);  // a0,a3,a6,b1,b4,b7,x,x
+  tmp3 = _mm_slli_si128(tmp3, 4);          // 0,0, a0,a3,a6,b1,b4,b7
+  tmp3 = _mm_srli_si128(tmp3, 4);          // a0,a3,a6,b1,b4,b7,0,0
+  v0 = _mm_slli_si128(tmp2, 12);           // 0,0,0,0,0,0, c2,c5,
+  v0 = _mm_or_si128(v0, tmp3);             // a0,a3,a6,b1,b4,b7,c2,c5
+
+  tmp3 = _mm_slli_si128(tmp0, 4);   // 0,0,a0,a3,a6,a1,a4,a7
+  tmp3 = _mm_srli_si128(tmp3, 10);  // a1,a4,a7, 0,0,0,0,0
+  v1 = _mm_srli_si128(tmp1, 6);     // b2,b5,b0,b3,b6,0,0
+  v1 = _mm_slli_si128(v1, 6);       // 0,0,0,b2,b5,b0,b3,b6,
+  v1 = _mm_or_si128(v1, tmp3);      // a1,a4,a7,b2,b5,b0,b3,b6,
+  v1 = _mm_slli_si128(v1, 6);       // 0,0,0,a1,a4,a7,b2,b5,
+  v1 = _mm_srli_si128(v1, 6);       // a1,a4,a7,b2,b5,0,0,0,
+  tmp3 = _mm_srli_si128(tmp2, 4);   // c0,c3,c6, c1,c4,c7,0,0
+  tmp3 = _mm_slli_si128(tmp3, 10);  // 0,0,0,0,0,c0,c3,c6,
+  v1 = _mm_or_si128(v1, tmp3);      // a1,a4,a7,b2,b5,c0,c3,c6,
+
+  tmp3 = _mm_srli_si128(tmp2, 10);  // c1,c4,c7, 0,0,0,0,0
+  tmp3 = _mm_slli_si128(tmp3, 10);  // 0,0,0,0,0, c1,c4,c7,
+  v2 = _mm_srli_si128(tmp1, 10);    // b0,b3,b6,0,0, 0,0,0
+  v2 = _mm_slli_si128(v2, 4);       // 0,0, b0,b3,b6,0,0,0
+  v2 = _mm_or_si128(v2, tmp3);      // 0,0, b0,b3,b6,c1,c4,c7,
+  tmp0 = _mm_srli_si128(tmp0, 12);  // a2,a5,0,0,0,0,0,0
+  v2 = _mm_or_si128(v2, tmp0);      // a2,a5,b0,b3,b6,c1,c4,c7,
+}
+
+static auto load_u16_store_s32(uint16_t const *src, int32_t *const R, int32_t *const G, int32_t *const B) {
+  __m128i v0, v1, v2;
+  deinterleave_rgb_u16(src, v0, v1, v2);
+  store_big_u16_to_s32(v0, R);
+  store_big_u16_to_s32(v1, G);
+  store_big_u16_to_s32(v2, B);
+}
+
+static auto load_u16_store_u16(uint16_t const *src, uint16_t *const R, uint16_t *const G,
+                               uint16_t *const B) {
+  __m128i v0, v1, v2;
+  deinterleave_rgb_u16(src, v0, v1, v2);
+  const __m128i swap = *(const __m128i *)mask16_swap;
+  _mm_storeu_si128((__m128i *)R, _mm_shuffle_epi8(v0, swap));
+  _mm_storeu_si128((__m128i *)G, _mm_shuffle_epi8(v1, swap));
+  _mm_storeu_si128((__m128i *)B, _mm_shuffle_epi8(v2, swap));
+}
+
+// gather the 4 samples of each channel of 4 interleaved RGBA pixels into one 32-bit lane, the lanes in
+// channel order
+alignas(16) static const int8_t mask8_rgba[16] = {0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15};
+// the same for the 2 samples of each channel of 2 big-endian 16-bit pixels, with their byte order reversed
+alignas(16) static const int8_t mask16_rgba[16] = {1, 0, 9, 8, 3, 2, 11, 10, 5, 4, 13, 12, 7, 6, 15, 14};
+
+// transpose the 4 x 4 matrix of 32-bit lanes held by v0 - v3
+static inline void transpose4_epi32(__m128i &v0, __m128i &v1, __m128i &v2, __m128i &v3) {
+  const __m128i t0 = _mm_unpacklo_epi32(v0, v1);  // v0[0],v1[0],v0[1],v1[1]
+  const __m128i t1 = _mm_unpacklo_epi32(v2, v3);  // v2[0],v3[0],v2[1],v3[1]
+  const __m128i t2 = _mm_unpackhi_epi32(v0, v1);  // v0[2],v1[2],v0[3],v1[3]
+  const __m128i t3 = _mm_unpackhi_epi32(v2, v3);  // v2[2],v3[2],v2[3],v3[3]
+  v0               = _mm_unpacklo_epi64(t0, t1);
+  v1               = _mm_unpackhi_epi64(t0, t1);
+  v2               = _mm_unpacklo_epi64(t2, t3);
+  v3               = _mm_unpackhi_epi64(t2, t3);
+}
+
+// split 4 vectors of interleaved 4-channel samples into one vector per channel, mask being mask8_rgba
+// (16 pixels of 8-bit samples) or mask16_rgba (8 pixels of big-endian 16-bit samples, made native-endian)
+static inline void deinterleave_rgba(uint8_t const *src, const int8_t *mask, __m128i v[4]) {
+  const __m128i m = *(const __m128i *)mask;
+  for (int k = 0; k < 4; ++k) {
+    v[k] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + 16 * k)), m);
+  }
+  transpose4_epi32(v[0], v[1], v[2], v[3]);
+}
+
+static auto load_rgba_u8_store_s32(uint8_t const *src, int32_t *const *dst) {
+  __m128i v[4];
+  deinterleave_rgba(src, mask8_rgba, v);
+  for (int ch = 0; ch < 4; ++ch) {
+    store_u8_to_s32(v[ch], dst[ch]);
+  }
+}
+
+static auto load_rgba_u8_store_u8(uint8_t const *src, uint8_t *const *dst) {
+  __m128i v[4];
+  deinterleave_rgba(src, mask8_rgba, v);
+  for (int ch = 0; ch < 4; ++ch) {
+    _mm_storeu_si128((__m128i *)dst[ch], v[ch]);
+  }
+}
+
+static auto load_rgba_u16_store_s32(uint8_t const *src, int32_t *const *dst) {
+  __m128i v[4];
+  deinterleave_rgba(src, mask16_rgba, v);
+  for (int ch = 0; ch < 4; ++ch) {
+    store_little_u16_to_s32(v[ch], dst[ch]);
+  }
+}
+
+static auto load_rgba_u16_store_u16(uint8_t const *src, uint16_t *const *dst) {
+  __m128i v[4];
+  deinterleave_rgba(src, mask16_rgba, v);
+  for (int ch = 0; ch < 4; ++ch) {
+    _mm_storeu_si128((__m128i *)dst[ch], v[ch]);
+  }
+}
+
+#if defined(__AVX512BW__)
+// 512-bit counterpart of deinterleave_rgba(): 64 pixels of 8-bit or 32 pixels of 16-bit samples; after the
+// in-lane shuffle, dword j of each 128-bit lane holds channel j, gathered across the 4 vectors by two
+// rounds of two-source permutes
+static inline void deinterleave_rgba_avx512(const uint8_t *src, const int8_t *mask, __m512i v[4]) {
+  const __m512i m = _mm512_broadcast_i32x4(*(const __m128i *)mask);
+  __m512i s[4];
+  for (int k = 0; k < 4; ++k) {
+    s[k] = _mm512_shuffle_epi8(_mm512_loadu_si512((const void *)(src + 64 * k)), m);
+  }
+  // channels 0, 1 (ch01) or 2, 3 (ch23) of two vectors, each channel in pixel order
+  const __m512i ch01 = _mm512_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28, 1, 5, 9, 13, 17, 21, 25, 29);
+  const __m512i ch23 = _mm512_setr_epi32(2, 6, 10, 14, 18, 22, 26, 30, 3, 7, 11, 15, 19, 23, 27, 31);
+  // lower (first) or upper (second) halves of two vectors
+  const __m512i first  = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 16, 17, 18, 19, 20, 21, 22, 23);
+  const __m512i second = _mm512_setr_epi32(8, 9, 10, 11, 12, 13, 14, 15, 24, 25, 26, 27, 28, 29, 30, 31);
+  const __m512i ab01   = _mm512_permutex2var_epi32(s[0], ch01, s[1]);
+  const __m512i ab23   = _mm512_permutex2var_epi32(s[0], ch23, s[1]);
+  const __m512i cd01   = _mm512_permutex2var_epi32(s[2], ch01, s[3]);
+  const __m512i cd23   = _mm512_permutex2var_epi32(s[2], ch23, s[3]);
+  v[0]                 = _mm512_permutex2var_epi32(ab01, first, cd01);
+  v[1]                 = _mm512_permutex2var_epi32(ab01, second, cd01);
+  v[2]                 = _mm512_permutex2var_epi32(ab23, first, cd23);
+  v[3]                 = _mm512_permutex2var_epi32(ab23, second, cd23);
+}
+
+static inline void load_rgba_u8_store_s32_avx512(const uint8_t *src, int32_t *const *dst) {
+  __m512i v[4];
+  deinterleave_rgba_avx512(src, mask8_rgba, v);
+  for (int ch = 0; ch < 4; ++ch) {
+    _mm512_storeu_si512((void *)dst[ch], _mm512_cvtepu8_epi32(_mm512_castsi512_si128(v[ch])));
+    _mm512_storeu_si512((void *)(dst[ch] + 16), _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(v[ch], 1)));
+    _mm512_storeu_si512((void *)(dst[ch] + 32), _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(v[ch], 2)));
+    _mm512_storeu_si512((void *)(dst[ch] + 48), _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(v[ch], 3)));
+  }
+}
+
+static inline void load_rgba_u8_store_u8_avx512(const uint8_t *src, uint8_t *const *dst) {
+  __m512i v[4];
+  deinterleave_rgba_avx512(src, mask8_rgba, v);
+  for (int ch = 0; ch < 4; ++ch) {
+    _mm512_storeu_si512((void *)dst[ch], v[ch]);
+  }
+}
+
+static inline void load_rgba_u16_store_s32_avx512(const uint8_t *src, int32_t *const *dst) {
+  __m512i v[4];
+  deinterleave_rgba_avx512(src, mask16_rgba, v);
+  for (int ch = 0; ch < 4; ++ch) {
+    _mm512_storeu_si512((void *)dst[ch], _mm512_cvtepu16_epi32(_mm512_castsi512_si256(v[ch])));
+    _mm512_storeu_si512((void *)(dst[ch] + 16), _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(v[ch], 1)));
+  }
+}
+
+static inline void load_rgba_u16_store_u16_avx512(const uint8_t *src, uint16_t *const *dst) {
+  __m512i v[4];
+  deinterleave_rgba_avx512(src, mask16_rgba, v);
+  for (int ch = 0; ch < 4; ++ch) {
+    _mm512_storeu_si512((void *)dst[ch], v[ch]);
+  }
+}
+#endif
+
+#endif
+
+/********************************************************************************
+ * unpack kernels: widen a raster held in memory (mapping or buffer) into int32
+ * src has no alignment requirement, dst shall be 32-byte aligned
+ *******************************************************************************/
+// 8-bit unsigned samples
+static void unpack_u8_to_s32(const uint8_t *src, int32_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    auto v = vld1q_u8(src + i);
+    store_u8_to_s32(v, dst + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 64; i += 64) {
+    auto v = _mm512_loadu_si512((const void *)(src + i));
+    _mm512_storeu_si512((void *)(dst + i), _mm512_cvtepu8_epi32(_mm512_castsi512_si128(v)));
+    _mm512_storeu_si512((void *)(dst + i + 16), _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(v, 1)));
+    _mm512_storeu_si512((void *)(dst + i + 32), _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(v, 2)));
+    _mm512_storeu_si512((void *)(dst + i + 48), _mm512_cvtepu8_epi32(_mm512_extracti32x4_epi32(v, 3)));
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    auto v = _mm_loadu_si128((const __m128i *)(src + i));
+    store_u8_to_s32(v, dst + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = src[i];
+  }
+}
+
+// 8-bit signed samples
+static void unpack_s8_to_s32(const uint8_t *src, int32_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    auto v = vld1q_s8((const int8_t *)(src + i));
+    store_s8_to_s32(v, dst + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 64; i += 64) {
+    auto v = _mm512_loadu_si512((const void *)(src + i));
+    _mm512_storeu_si512((void *)(dst + i), _mm512_cvtepi8_epi32(_mm512_castsi512_si128(v)));
+    _mm512_storeu_si512((void *)(dst + i + 16), _mm512_cvtepi8_epi32(_mm512_extracti32x4_epi32(v, 1)));
+    _mm512_storeu_si512((void *)(dst + i + 32), _mm512_cvtepi8_epi32(_mm512_extracti32x4_epi32(v, 2)));
+    _mm512_storeu_si512((void *)(dst + i + 48), _mm512_cvtepi8_epi32(_mm512_extracti32x4_epi32(v, 3)));
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    auto v = _mm_loadu_si128((const __m128i *)(src + i));
+    store_s8_to_s32(v, dst + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = static_cast<int8_t>(src[i]);
+  }
+}
+
+// 16-bit big-endian unsigned samples
+static void unpack_big_u16_to_s32(const uint8_t *src, int32_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    auto v = vld1q_u16((const uint16_t *)(src + 2 * i));
+    store_big_u16_to_s32(v, dst + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    auto v = swap16_avx512(_mm512_loadu_si512((const void *)(src + 2 * i)));
+    _mm512_storeu_si512((void *)(dst + i), _mm512_cvtepu16_epi32(_mm512_castsi512_si256(v)));
+    _mm512_storeu_si512((void *)(dst + i + 16), _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(v, 1)));
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    auto v = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+    store_big_u16_to_s32(v, dst + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = (src[2 * i] << 8) | src[2 * i + 1];
+  }
+}
+
+// 16-bit little-endian unsigned samples
+static void unpack_little_u16_to_s32(const uint8_t *src, int32_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    auto v = vld1q_u16((const uint16_t *)(src + 2 * i));
+    store_little_u16_to_s32(v, dst + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    auto v = _mm512_loadu_si512((const void *)(src + 2 * i));
+    _mm512_storeu_si512((void *)(dst + i), _mm512_cvtepu16_epi32(_mm512_castsi512_si256(v)));
+    _mm512_storeu_si512((void *)(dst + i + 16), _mm512_cvtepu16_epi32(_mm512_extracti64x4_epi64(v, 1)));
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    auto v = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+    store_little_u16_to_s32(v, dst + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = src[2 * i] | (src[2 * i + 1] << 8);
+  }
+}
+
+// 16-bit big-endian signed samples
+static void unpack_big_s16_to_s32(const uint8_t *src, int32_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    auto v = vld1q_u16((const uint16_t *)(src + 2 * i));
+    store_big_s16_to_s32(v, dst + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    auto v = swap16_avx512(_mm512_loadu_si512((const void *)(src + 2 * i)));
+    _mm512_storeu_si512((void *)(dst + i), _mm512_cvtepi16_epi32(_mm512_castsi512_si256(v)));
+    _mm512_storeu_si512((void *)(dst + i + 16), _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(v, 1)));
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    auto v = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+    store_big_s16_to_s32(v, dst + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = static_cast<int16_t>((src[2 * i] << 8) | src[2 * i + 1]);
+  }
+}
+
+// 16-bit little-endian signed samples
+static void unpack_little_s16_to_s32(const uint8_t *src, int32_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    auto v = vld1q_u16((const uint16_t *)(src + 2 * i));
+    store_little_s16_to_s32(v, dst + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    auto v = _mm512_loadu_si512((const void *)(src + 2 * i));
+    _mm512_storeu_si512((void *)(dst + i), _mm512_cvtepi16_epi32(_mm512_castsi512_si256(v)));
+    _mm512_storeu_si512((void *)(dst + i + 16), _mm512_cvtepi16_epi32(_mm512_extracti64x4_epi64(v, 1)));
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    auto v = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+    store_little_s16_to_s32(v, dst + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = static_cast<int16_t>(src[2 * i] | (src[2 * i + 1] << 8));
+  }
+}
+
+// 32-bit big-endian samples (PGX deeper than 16 bits, signed or unsigned)
+static void unpack_big_32_to_s32(const uint8_t *src, int32_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 4; i += 4) {
+    vst1q_s32(dst + i, vreinterpretq_s32_u8(vrev32q_u8(vld1q_u8(src + 4 * i))));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  alignas(16) static const int8_t mask32_swap[16] = {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12};
+  #if defined(__AVX512BW__)
+  const __m512i swap512 = _mm512_broadcast_i32x4(*(const __m128i *)mask32_swap);
+  for (; i < len - len % 16; i += 16) {
+    _mm512_storeu_si512((void *)(dst + i),
+                        _mm512_shuffle_epi8(_mm512_loadu_si512((const void *)(src + 4 * i)), swap512));
+  }
+  #endif
+  for (; i < len - len % 4; i += 4) {
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + 4 * i)),
+                                                            *(const __m128i *)mask32_swap));
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = static_cast<int32_t>((static_cast<uint32_t>(src[4 * i]) << 24) | (src[4 * i + 1] << 16)
+                                  | (src[4 * i + 2] << 8) | src[4 * i + 3]);
+  }
+}
+
+// 32-bit little-endian samples (PGX deeper than 16 bits, signed or unsigned)
+static void unpack_little_32_to_s32(const uint8_t *src, int32_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 4; i += 4) {
+    vst1q_s32(dst + i, vreinterpretq_s32_u8(vld1q_u8(src + 4 * i)));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 16; i += 16) {
+    _mm512_storeu_si512((void *)(dst + i), _mm512_loadu_si512((const void *)(src + 4 * i)));
+  }
+  #endif
+  for (; i < len - len % 4; i += 4) {
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_loadu_si128((const __m128i *)(src + 4 * i)));
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = static_cast<int32_t>(src[4 * i] | (src[4 * i + 1] << 8) | (src[4 * i + 2] << 16)
+                                  | (static_cast<uint32_t>(src[4 * i + 3]) << 24));
+  }
+}
+
+// interleaved 8-bit RGB samples (PPM)
+static void unpack_rgb_u8_to_s32(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    uint8x16x3_t vsrc = vld3q_u8(src + 3 * i);
+    store_u8_to_u32(vsrc.val[0], R + i);
+    store_u8_to_u32(vsrc.val[1], G + i);
+    store_u8_to_u32(vsrc.val[2], B + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512VBMI__)
+  for (; i < len - len % 64; i += 64) {
+    load_u8_store_s32_avx512(src + 3 * i, R + i, G + i, B + i);
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    load_u8_store_s32(src + 3 * i, R + i, G + i, B + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    R[i] = src[3 * i];
+    G[i] = src[3 * i + 1];
+    B[i] = src[3 * i + 2];
+  }
+}
+
+// interleaved 16-bit big-endian RGB samples (PPM)
+static void unpack_rgb_big_u16_to_s32(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B,
+                                      size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    uint16x8x3_t vsrc = vld3q_u16((const uint16_t *)(src + 6 * i));
+    store_big_u16_to_u32(vsrc.val[0], R + i);
+    store_big_u16_to_u32(vsrc.val[1], G + i);
+    store_big_u16_to_u32(vsrc.val[2], B + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    load_u16_store_s32_avx512(src + 6 * i, R + i, G + i, B + i);
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    load_u16_store_s32((const uint16_t *)(src + 6 * i), R + i, G + i, B + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    R[i] = (src[6 * i] << 8) | src[6 * i + 1];
+    G[i] = (src[6 * i + 2] << 8) | src[6 * i + 3];
+    B[i] = (src[6 * i + 4] << 8) | src[6 * i + 5];
+  }
+}
+
+// interleaved 8-bit RGB samples (PPM) into 8-bit planes
+static void unpack_rgb_u8_to_u8(const uint8_t *src, uint8_t *R, uint8_t *G, uint8_t *B, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    uint8x16x3_t vsrc = vld3q_u8(src + 3 * i);
+    vst1q_u8(R + i, vsrc.val[0]);
+    vst1q_u8(G + i, vsrc.val[1]);
+    vst1q_u8(B + i, vsrc.val[2]);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512VBMI__)
+  for (; i < len - len % 64; i += 64) {
+    load_u8_store_u8_avx512(src + 3 * i, R + i, G + i, B + i);
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    load_u8_store_u8(src + 3 * i, R + i, G + i, B + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    R[i] = src[3 * i];
+    G[i] = src[3 * i + 1];
+    B[i] = src[3 * i + 2];
+  }
+}
+
+// interleaved 16-bit big-endian RGB samples (PPM) into native-endian 16-bit planes
+static void unpack_rgb_big_u16_to_u16(const uint8_t *src, uint16_t *R, uint16_t *G, uint16_t *B,
+                                      size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    uint16x8x3_t vsrc = vld3q_u16((const uint16_t *)(src + 6 * i));
+    vst1q_u16(R + i, vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vsrc.val[0]))));
+    vst1q_u16(G + i, vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vsrc.val[1]))));
+    vst1q_u16(B + i, vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vsrc.val[2]))));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    load_u16_store_u16_avx512(src + 6 * i, R + i, G + i, B + i);
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    load_u16_store_u16((const uint16_t *)(src + 6 * i), R + i, G + i, B + i);
+  }
+#endif
+  for (; i < len; ++i) {
+    R[i] = static_cast<uint16_t>((src[6 * i] << 8) | src[6 * i + 1]);
+    G[i] = static_cast<uint16_t>((src[6 * i + 2] << 8) | src[6 * i + 3]);
+    B[i] = static_cast<uint16_t>((src[6 * i + 4] << 8) | src[6 * i + 5]);
+  }
+}
+
+// interleaved 8-bit RGBA samples (PAM of depth 4)
+static void unpack_rgba_u8_to_s32(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B, int32_t *A,
+                                  size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    uint8x16x4_t vsrc = vld4q_u8(src + 4 * i);
+    store_u8_to_u32(vsrc.val[0], R + i);
+    store_u8_to_u32(vsrc.val[1], G + i);
+    store_u8_to_u32(vsrc.val[2], B + i);
+    store_u8_to_u32(vsrc.val[3], A + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 64; i += 64) {
+    int32_t *const dst[4] = {R + i, G + i, B + i, A + i};
+    load_rgba_u8_store_s32_avx512(src + 4 * i, dst);
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    int32_t *const dst[4] = {R + i, G + i, B + i, A + i};
+    load_rgba_u8_store_s32(src + 4 * i, dst);
+  }
+#endif
+  for (; i < len; ++i) {
+    R[i] = src[4 * i];
+    G[i] = src[4 * i + 1];
+    B[i] = src[4 * i + 2];
+    A[i] = src[4 * i + 3];
+  }
+}
+
+// interleaved 16-bit big-endian RGBA samples (PAM of depth 4)
+static void unpack_rgba_big_u16_to_s32(const uint8_t *src, int32_t *R, int32_t *G, int32_t *B, int32_t *A,
+                                       size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    uint16x8x4_t vsrc = vld4q_u16((const uint16_t *)(src + 8 * i));
+    store_big_u16_to_u32(vsrc.val[0], R + i);
+    store_big_u16_to_u32(vsrc.val[1], G + i);
+    store_big_u16_to_u32(vsrc.val[2], B + i);
+    store_big_u16_to_u32(vsrc.val[3], A + i);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    int32_t *const dst[4] = {R + i, G + i, B + i, A + i};
+    load_rgba_u16_store_s32_avx512(src + 8 * i, dst);
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    int32_t *const dst[4] = {R + i, G + i, B + i, A + i};
+    load_rgba_u16_store_s32(src + 8 * i, dst);
+  }
+#endif
+  for (; i < len; ++i) {
+    R[i] = (src[8 * i] << 8) | src[8 * i + 1];
+    G[i] = (src[8 * i + 2] << 8) | src[8 * i + 3];
+    B[i] = (src[8 * i + 4] << 8) | src[8 * i + 5];
+    A[i] = (src[8 * i + 6] << 8) | src[8 * i + 7];
+  }
+}
+
+// interleaved 8-bit RGBA samples (PAM of depth 4) into 8-bit planes
+static void unpack_rgba_u8_to_u8(const uint8_t *src, uint8_t *R, uint8_t *G, uint8_t *B, uint8_t *A,
+                                 size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 16; i += 16) {
+    uint8x16x4_t vsrc = vld4q_u8(src + 4 * i);
+    vst1q_u8(R + i, vsrc.val[0]);
+    vst1q_u8(G + i, vsrc.val[1]);
+    vst1q_u8(B + i, vsrc.val[2]);
+    vst1q_u8(A + i, vsrc.val[3]);
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 64; i += 64) {
+    uint8_t *const dst[4] = {R + i, G + i, B + i, A + i};
+    load_rgba_u8_store_u8_avx512(src + 4 * i, dst);
+  }
+  #endif
+  for (; i < len - len % 16; i += 16) {
+    uint8_t *const dst[4] = {R + i, G + i, B + i, A + i};
+    load_rgba_u8_store_u8(src + 4 * i, dst);
+  }
+#endif
+  for (; i < len; ++i) {
+    R[i] = src[4 * i];
+    G[i] = src[4 * i + 1];
+    B[i] = src[4 * i + 2];
+    A[i] = src[4 * i + 3];
+  }
+}
+
+// interleaved 16-bit big-endian RGBA samples (PAM of depth 4) into native-endian 16-bit planes
+static void unpack_rgba_big_u16_to_u16(const uint8_t *src, uint16_t *R, uint16_t *G, uint16_t *B,
+                                       uint16_t *A, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    uint16x8x4_t vsrc = vld4q_u16((const uint16_t *)(src + 8 * i));
+    vst1q_u16(R + i, vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vsrc.val[0]))));
+    vst1q_u16(G + i, vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vsrc.val[1]))));
+    vst1q_u16(B + i, vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vsrc.val[2]))));
+    vst1q_u16(A + i, vreinterpretq_u16_u8(vrev16q_u8(vreinterpretq_u8_u16(vsrc.val[3]))));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    uint16_t *const dst[4] = {R + i, G + i, B + i, A + i};
+    load_rgba_u16_store_u16_avx512(src + 8 * i, dst);
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    uint16_t *const dst[4] = {R + i, G + i, B + i, A + i};
+    load_rgba_u16_store_u16(src + 8 * i, dst);
+  }
+#endif
+  for (; i < len; ++i) {
+    R[i] = static_cast<uint16_t>((src[8 * i] << 8) | src[8 * i + 1]);
+    G[i] = static_cast<uint16_t>((src[8 * i + 2] << 8) | src[8 * i + 3]);
+    B[i] = static_cast<uint16_t>((src[8 * i + 4] << 8) | src[8 * i + 5]);
+    A[i] = static_cast<uint16_t>((src[8 * i + 6] << 8) | src[8 * i + 7]);
+  }
+}
+
+// 16-bit big-endian samples (signed or unsigned) into native-endian 16-bit samples
+static void unpack_big_16_to_16(const uint8_t *src, uint16_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    vst1q_u16(dst + i, vreinterpretq_u16_u8(vrev16q_u8(vld1q_u8(src + 2 * i))));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    _mm512_storeu_si512((void *)(dst + i), swap16_avx512(_mm512_loadu_si512((const void *)(src + 2 * i))));
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    auto v = _mm_loadu_si128((const __m128i *)(src + 2 * i));
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_shuffle_epi8(v, *(const __m128i *)mask16_swap));
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = static_cast<uint16_t>((src[2 * i] << 8) | src[2 * i + 1]);
+  }
+}
+
+// 8-bit signed samples into 16-bit signed samples
+static void unpack_s8_to_s16(const uint8_t *src, int16_t *dst, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 8; i += 8) {
+    vst1q_s16(dst + i, vmovl_s8(vld1_s8((const int8_t *)(src + i))));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 32; i += 32) {
+    auto v = _mm256_loadu_si256((const __m256i *)(src + i));
+    _mm512_storeu_si512((void *)(dst + i), _mm512_cvtepi8_epi16(v));
+  }
+  #endif
+  for (; i < len - len % 8; i += 8) {
+    auto v = _mm_loadl_epi64((const __m128i *)(src + i));
+    _mm_storeu_si128((__m128i *)(dst + i), _mm_cvtepi8_epi16(v));
+  }
+#endif
+  for (; i < len; ++i) {
+    dst[i] = static_cast<int8_t>(src[i]);
+  }
+}
+
+/********************************************************************************
+ * box filter kernels of reduced reads (see unpack_reduced() in pnm_io.hpp)
+ * rows of int32 samples are summed into an accumulator row, then adjacent
+ * columns are summed pairwise, once per halving of the width
+ *******************************************************************************/
+// acc[i] += src[i]
+static void box_accumulate(const int32_t *src, int32_t *acc, size_t len) {
+  size_t i = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < len - len % 4; i += 4) {
+    vst1q_s32(acc + i, vaddq_s32(vld1q_s32(acc + i), vld1q_s32(src + i)));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  for (; i < len - len % 16; i += 16) {
+    const __m512i a = _mm512_loadu_si512((const void *)(acc + i));
+    const __m512i b = _mm512_loadu_si512((const void *)(src + i));
+    _mm512_storeu_si512((void *)(acc + i), _mm512_add_epi32(a, b));
+  }
+  #elif defined(__AVX2__)
+  for (; i < len - len % 8; i += 8) {
+    const __m256i a = _mm256_loadu_si256((const __m256i *)(acc + i));
+    const __m256i b = _mm256_loadu_si256((const __m256i *)(src + i));
+    _mm256_storeu_si256((__m256i *)(acc + i), _mm256_add_epi32(a, b));
+  }
+  #endif
+  for (; i < len - len % 4; i += 4) {
+    const __m128i a = _mm_loadu_si128((const __m128i *)(acc + i));
+    const __m128i b = _mm_loadu_si128((const __m128i *)(src + i));
+    _mm_storeu_si128((__m128i *)(acc + i), _mm_add_epi32(a, b));
+  }
+#endif
+  for (; i < len; ++i) {
+    acc[i] += src[i];
+  }
+}
+
+// acc[i] = acc[2 i] + acc[2 i + 1] for i < len / 2, in place; len shall be even
+static void box_pair_sum(int32_t *acc, size_t len) {
+  const size_t half = len / 2;
+  size_t i          = 0;
+#if defined(USE_ARM_NEON)
+  for (; i < half - half % 4; i += 4) {
+    const int32x4x2_t v = vld2q_s32(acc + 2 * i);  // even and odd columns
+    vst1q_s32(acc + i, vaddq_s32(v.val[0], v.val[1]));
+  }
+#elif defined(__AVX2__) || defined(__SSE4_1__)
+  #if defined(__AVX512BW__)
+  const __m512i even = _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+  const __m512i odd  = _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+  for (; i < half - half % 16; i += 16) {
+    const __m512i a = _mm512_loadu_si512((const void *)(acc + 2 * i));
+    const __m512i b = _mm512_loadu_si512((const void *)(acc + 2 * i + 16));
+    const __m512i s0 = _mm512_permutex2var_epi32(a, even, b);
+    const __m512i s1 = _mm512_permutex2var_epi32(a, odd, b);
+    _mm512_storeu_si512((void *)(acc + i), _mm512_add_epi32(s0, s1));
+  }
+  #elif defined(__AVX2__)
+  for (; i < half - half % 8; i += 8) {
+    const __m256i a = _mm256_loadu_si256((const __m256i *)(acc + 2 * i));
+    const __m256i b = _mm256_loadu_si256((const __m256i *)(acc + 2 * i + 8));
+    // the sums of each 128-bit lane of a and b, then the lanes in column order
+    const __m256i s = _mm256_permute4x64_epi64(_mm256_hadd_epi32(a, b), 0xD8);
+    _mm256_storeu_si256((__m256i *)(acc + i), s);
+  }
+  #endif
+  for (; i < half - half % 4; i += 4) {
+    const __m128i a = _mm_loadu_si128((const __m128i *)(acc + 2 * i));
+    const __m128i b = _mm_loadu_si128((const __m128i *)(acc + 2 * i + 4));
+    _mm_storeu_si128((__m128i *)(acc + i), _mm_hadd_epi32(a, b));
+  }
+#endif
+  for (; i < half; ++i) {
+    acc[i] = acc[2 * i] + acc[2 * i + 1];
+  }
+}
@@ -0,0 +1,348 @@
+#include <cstring>
+#include <type_traits>
+
+#include "RGB2XYB.hpp"
+#include "xyb_convert.hpp"
+#include "xyb_lut3d.hpp"
+
+template <class Cbrt>
+static xyb_kernels scalar_xyb_kernels() {
+  return {rgb2xyb_scalar<Cbrt, i32>, rgb2xyb_scalar<Cbrt, ui8>, rgb2xyb_scalar<Cbrt, ui16>};
+}
+
+// kernels of the lattice of Grid nodes per axis, for the bit depth of each call; without Stats, the matrix
+// stage is skipped and stats left untouched
+template <i32 Grid, bool Stats, class T>
+static void rgb2xyb_lut3d(const T *R, const T *G, const T *B, i32 *X, i32 *Y, i32 *Bo, size_t len, i32 bpp,
+                          xyb_stats &stats) {
+  const kernel_table &k = get_kernels();
+  const xyb_lut3d &lut  = get_xyb_lut3d(Grid, bpp);
+  xyb_stats *range      = (Stats) ? &stats : nullptr;
+  if constexpr (std::is_same_v<T, ui8>) {
+    k.rgb2xyb_u8_lut3d(lut, R, G, B, X, Y, Bo, len, range);
+  } else if constexpr (std::is_same_v<T, ui16>) {
+    k.rgb2xyb_u16_lut3d(lut, R, G, B, X, Y, Bo, len, range);
+  } else {
+    k.rgb2xyb_lut3d(lut, R, G, B, X, Y, Bo, len, range);
+  }
+}
+
+template <i32 Grid, bool Stats>
+static xyb_kernels lut3d_xyb_kernels() {
+  return {rgb2xyb_lut3d<Grid, Stats, i32>, rgb2xyb_lut3d<Grid, Stats, ui8>,
+          rgb2xyb_lut3d<Grid, Stats, ui16>};
+}
+
+xyb_kernels get_xyb_kernels(const xyb_method &method, i32 bpp) {
+  if (xyb_lut3d::supports(method.lut3d_grid, bpp)) {
+    if (method.lut3d_grid == 33) {
+      return (method.stats) ? lut3d_xyb_kernels<33, true>() : lut3d_xyb_kernels<33, false>();
+    }
+    return (method.stats) ? lut3d_xyb_kernels<17, true>() : lut3d_xyb_kernels<17, false>();
+  }
+  switch (method.cbrt) {
+    case cbrt_method::LUT1024:
+      return scalar_xyb_kernels<cbrt_lut1024>();
+    case cbrt_method::NEWTON16:
+      return scalar_xyb_kernels<cbrt_newton16>();
+    case cbrt_method::NEWTON32:
+      return scalar_xyb_kernels<cbrt_newton32>();
+    case cbrt_method::EXACT:
+      return scalar_xyb_kernels<cbrt_exact>();
+    case cbrt_method::POLY: {
+      const kernel_table &k = get_kernels();
+      return {k.rgb2xyb_poly, k.rgb2xyb_u8_poly, k.rgb2xyb_u16_poly};
+    }
+    default: {
+      const kernel_table &k = get_kernels();
+      return {k.rgb2xyb, k.rgb2xyb_u8, k.rgb2xyb_u16};
+    }
+  }
+}
+
+// upsampling kernel of the planes of T
+template <class T>
+static auto upsample_kernel(const kernel_table &k) {
+  if constexpr (std::is_same_v<T, ui8>) {
+    return k.upsample_h2_u8;
+  } else if constexpr (std::is_same_v<T, ui16>) {
+    return k.upsample_h2_u16;
+  } else {
+    return k.upsample_h2_s32;
+  }
+}
+
+// dst[i] = sum[i] / 2^shift, rounded to nearest (halves up)
+static void store_means(const i32 *sum, i32 *dst, ui32 len, ui32 shift) {
+  const i32 half = 1 << (shift - 1);
+  for (ui32 i = 0; i < len; ++i) {
+    dst[i] = (sum[i] + half) >> shift;
+  }
+}
+
+// rgb2xyb_rows() on planes of T; planes of different sizes (see image::get_subsampling()) are converted one
+// row at a time: the rows of the halved input planes are widened (or repeated) into scratch rows, and the
+// rows of the halved output planes are box-filtered from scratch rows, a vertical pair once its second row
+// is converted
+template <class T, class Kernel>
+static void rgb2xyb_rows_of(image &rgb_in, image &xyb_out, ui32 y0, ui32 y1, Kernel kernel, i32 bpp,
+                            xyb_stats &stats) {
+  const ui32 width  = rgb_in.get_width();
+  const ui32 height = rgb_in.get_height();
+  ui32 in_sx[3], in_sy[3], out_sx[3], out_sy[3];
+  bool resampled = false;
+  for (uint16_t c = 0; c < 3; ++c) {
+    rgb_in.get_subsampling(c, in_sx[c], in_sy[c]);
+    xyb_out.get_subsampling(c, out_sx[c], out_sy[c]);
+    resampled = resampled || (in_sx[c] | in_sy[c] | out_sx[c] | out_sy[c]);
+  }
+  if (!resampled) {
+    const size_t offset = static_cast<size_t>(width) * y0;
+    kernel(rgb_in.get_buf<T>(0) + offset, rgb_in.get_buf<T>(1) + offset, rgb_in.get_buf<T>(2) + offset,
+           xyb_out.get_buf(0) + offset, xyb_out.get_buf(1) + offset, xyb_out.get_buf(2) + offset,
+           static_cast<size_t>(width) * (y1 - y0), bpp, stats);
+    return;
+  }
+  const kernel_table &k = get_kernels();
+  const auto upsample   = upsample_kernel<T>(k);
+  const size_t stride   = width + 1;  // a sample past the end repeats the last one of an odd width
+  // the widened input rows; the output rows and, for planes halved vertically, the sums of the even row
+  auto in_rows  = aligned_uptr<T>(64, 3 * stride);
+  auto out_rows = aligned_uptr<i32>(64, 6 * stride);
+  for (ui32 y = y0; y < y1; ++y) {
+    const T *in[3];
+    i32 *out[3];
+    for (uint16_t c = 0; c < 3; ++c) {
+      const size_t src_row = y >> in_sy[c];
+      const T *src         = rgb_in.get_buf<T>(c) + src_row * rgb_in.get_component_width(c);
+      if (in_sx[c]) {
+        upsample(src, in_rows.get() + c * stride, width);
+        src = in_rows.get() + c * stride;
+      }
+      in[c]  = src;
+      out[c] = (out_sx[c] | out_sy[c]) ? out_rows.get() + c * stride
+                                       : xyb_out.get_buf(c) + static_cast<size_t>(y) * width;
+    }
+    xyb_stats row_stats;  // the kernels assign, not merge
+    kernel(in[0], in[1], in[2], out[0], out[1], out[2], width, bpp, row_stats);
+    stats.merge(row_stats);
+    for (uint16_t c = 0; c < 3; ++c) {
+      if (!(out_sx[c] | out_sy[c])) {
+        continue;
+      }
+      i32 *row = out[c];
+      ui32 len = width;
+      if (out_sx[c]) {
+        row[width] = row[width - 1];
+        k.box_pair_sum(row, width + (width & 1));
+        len = (width + 1) / 2;
+      }
+      const size_t dst_row = y >> out_sy[c];
+      i32 *dst             = xyb_out.get_buf(c) + dst_row * xyb_out.get_component_width(c);
+      if (!out_sy[c]) {
+        store_means(row, dst, len, 1);
+        continue;
+      }
+      i32 *sum = out_rows.get() + (3 + c) * stride;
+      if ((y & 1) == 0) {
+        memcpy(sum, row, len * sizeof(i32));
+        if (y + 1 < height) {
+          continue;  // the odd row completes the pair
+        }
+      }
+      k.box_accumulate(row, sum, len);  // the last row of an odd height is repeated
+      store_means(sum, dst, len, out_sx[c] + 1);
+    }
+  }
+}
+
+void rgb2xyb_rows(image &rgb_in, image &xyb_out, ui32 y0, ui32 y1, xyb_stats &stats,
+                  const xyb_method &method) {
+  const size_t length = static_cast<size_t>(rgb_in.get_width()) * (y1 - y0);
+  const i32 bpp       = rgb_in.get_max_bpp();
+  xyb_stats local;
+  const xyb_kernels k = get_xyb_kernels(method, bpp);
+  const size_t bytes  = 3 * length * sample_size(rgb_in.get_sample_type(0));
+  instrument::stage_timer timer(instrument::stage::XYB, bytes);
+  switch (rgb_in.get_sample_type(0)) {
+    case sample_type::U8:
+      rgb2xyb_rows_of<ui8>(rgb_in, xyb_out, y0, y1, k.u8, bpp, local);
+      break;
+    case sample_type::U16:
+      rgb2xyb_rows_of<ui16>(rgb_in, xyb_out, y0, y1, k.u16, bpp, local);
+      break;
+    case sample_type::S32:
+      rgb2xyb_rows_of<i32>(rgb_in, xyb_out, y0, y1, k.s32, bpp, local);
+      break;
+    case sample_type::F32:
+      printf("ERROR: float RGB samples are not supported.\n");
+      exit(EXIT_FAILURE);
+    default:
+      printf("ERROR: signed RGB samples are not supported.\n");
+      exit(EXIT_FAILURE);
+  }
+  stats.merge(local);
+}
+
+// the three components shall share one sample type; the planes of both images shall be of the size of
+// rgb_in or halved (see image::get_subsampling())
+static bool check_rgb_planes(image &rgb_in, image &xyb_out) {
+  if (rgb_in.get_num_components() != 3) {
+    printf("Number of components shall be 3!\n");
+    return false;
+  }
+  if (rgb_in.get_sample_type(1) != rgb_in.get_sample_type(0)
+      || rgb_in.get_sample_type(2) != rgb_in.get_sample_type(0)) {
+    printf("ERROR: components shall have the same sample type!\n");
+    return false;
+  }
+  if (xyb_out.get_num_components() != 3 || xyb_out.get_width() != rgb_in.get_width()
+      || xyb_out.get_height() != rgb_in.get_height()) {
+    printf("ERROR: XYB image shall have 3 components of the size of the RGB image!\n");
+    return false;
+  }
+  ui32 sx, sy;
+  for (uint16_t c = 0; c < 3; ++c) {
+    if (!rgb_in.get_subsampling(c, sx, sy) || !xyb_out.get_subsampling(c, sx, sy)) {
+      printf("ERROR: component %d shall be of the image size or halved (rounded up)!\n", c);
+      return false;
+    }
+  }
+  return true;
+}
+
+// method without the statistics when the caller does not ask for the range
+static xyb_method method_for(const xyb_method &method, const xyb_stats *range) {
+  xyb_method m = method;
+  m.stats      = method.stats && range != nullptr;
+  return m;
+}
+
+void rgb2xyb(image &rgb_in, image &xyb_out, xyb_stats *range, const xyb_method &method) {
+  if (!check_rgb_planes(rgb_in, xyb_out)) {
+    exit(EXIT_FAILURE);
+  }
+  xyb_stats stats;
+  rgb2xyb_rows(rgb_in, xyb_out, 0, rgb_in.get_height(), stats, method_for(method, range));
+  if (range != nullptr) {
+    *range = stats;
+  }
+}
+
+void rgb2xyb_parallel(image &rgb_in, image &xyb_out, thread_pool &pool, xyb_stats *range,
+                      const xyb_method &method) {
+  if (!check_rgb_planes(rgb_in, xyb_out)) {
+    exit(EXIT_FAILURE);
+  }
+  const xyb_method strip_method = method_for(method, range);
+  const ui32 height             = rgb_in.get_height();
+  // a few strips per thread for load balancing
+  const ui32 num_strips = std::max(1U, std::min(height, static_cast<ui32>(pool.get_num_threads() * 4)));
+  // even, so that the rows of a plane halved vertically pair up within a strip
+  const ui32 strip_rows = ((height + num_strips - 1) / num_strips + 1) & ~1U;
+
+  std::vector<xyb_stats> strip_stats(num_strips);
+  std::vector<std::future<void>> done;
+  done.reserve(num_strips);
+  for (ui32 s = 0; s < num_strips; ++s) {
+    const ui32 y0 = std::min(height, s * strip_rows);
+    const ui32 y1 = std::min(height, y0 + strip_rows);
+    done.emplace_back(pool.enqueue([&rgb_in, &xyb_out, &strip_stats, &strip_method, s, y0, y1] {
+      rgb2xyb_rows(rgb_in, xyb_out, y0, y1, strip_stats[s], strip_method);
+    }));
+  }
+  for (auto &f : done) {
+    f.get();
+  }
+  xyb_stats stats;
+  for (const auto &s : strip_stats) {
+    stats.merge(s);
+  }
+  if (range != nullptr) {
+    *range = stats;
+  }
+}
+
+int ppm2xyb(const std::string &filename, std::unique_ptr<image> &xyb_out, thread_pool &pool, io_mode mode,
+            xyb_stats *range, const xyb_method &method) {
+  file_view fv;
+  if (fv.open(filename, mode)) {
+    printf("ERROR: File %s is not found.\n", filename.c_str());
+    return EXIT_FAILURE;
+  }
+  byte_stream bs(fv.data(), fv.size());
+  pnm_header hdr;
+  if (parse_pnm_header(bs, filename, 3, hdr)) {
+    return EXIT_FAILURE;
+  }
+  const uint32_t width           = hdr.width;
+  const uint32_t height          = hdr.height;
+  const uint8_t bpp              = hdr.bpp;
+  const uint32_t byte_per_sample = hdr.byte_per_sample();
+  const size_t num_pixels        = static_cast<size_t>(width) * height;
+  // a P3 (ASCII) raster is parsed into a P6 one up front
+  unique_ptr_aligned<uint8_t> parsed;
+  const uint8_t *src = pnm_raster(bs, hdr, filename, 3 * num_pixels, parsed);
+  if (src == nullptr) {
+    return EXIT_FAILURE;
+  }
+  xyb_out = std::make_unique<image>(width, height, 3, xyb_bpp, true);
+
+  const kernel_table &k = get_kernels();
+  const xyb_kernels xk  = get_xyb_kernels(method_for(method, range), bpp);
+  i32 *X                = xyb_out->get_buf(0);
+  i32 *Y                = xyb_out->get_buf(1);
+  i32 *B                = xyb_out->get_buf(2);
+
+  // a few tasks per thread for load balancing, each task walks its range block by block
+  const size_t num_blocks  = (num_pixels + ppm2xyb_block_pixels - 1) / ppm2xyb_block_pixels;
+  const size_t num_tasks   = std::max<size_t>(1, std::min(num_blocks, pool.get_num_threads() * 4));
+  const size_t task_blocks = (num_blocks + num_tasks - 1) / num_tasks;
+
+  std::vector<xyb_stats> task_stats(num_tasks);
+  std::vector<std::future<void>> done;
+  done.reserve(num_tasks);
+  for (size_t t = 0; t < num_tasks; ++t) {
+    const size_t p0 = std::min(num_pixels, t * task_blocks * ppm2xyb_block_pixels);
+    const size_t p1 = std::min(num_pixels, p0 + task_blocks * ppm2xyb_block_pixels);
+    done.emplace_back(pool.enqueue([=, &k, &task_stats] {
+      // the scratch planes keep the sample width of the raster
+      auto scratch = aligned_uptr<uint8_t>(32, 3 * byte_per_sample * ppm2xyb_block_pixels);
+      for (size_t p = p0; p < p1; p += ppm2xyb_block_pixels) {
+        const size_t n = std::min(ppm2xyb_block_pixels, p1 - p);
+        xyb_stats local;
+        if (byte_per_sample == 1) {
+          ui8 *R  = scratch.get();
+          ui8 *G  = R + ppm2xyb_block_pixels;
+          ui8 *Bl = G + ppm2xyb_block_pixels;
+          instrument::stage_timer unpack(instrument::stage::UNPACK, 3 * n);
+          k.unpack_rgb_u8_to_u8(src + 3 * p, R, G, Bl, n);
+          unpack.stop();
+          instrument::stage_timer xyb(instrument::stage::XYB, 3 * n);
+          xk.u8(R, G, Bl, X + p, Y + p, B + p, n, bpp, local);
+        } else {
+          ui16 *R  = reinterpret_cast<ui16 *>(scratch.get());
+          ui16 *G  = R + ppm2xyb_block_pixels;
+          ui16 *Bl = G + ppm2xyb_block_pixels;
+          instrument::stage_timer unpack(instrument::stage::UNPACK, 6 * n);
+          k.unpack_rgb_big_u16_to_u16(src + 6 * p, R, G, Bl, n);
+          unpack.stop();
+          instrument::stage_timer xyb(instrument::stage::XYB, 6 * n);
+          xk.u16(R, G, Bl, X + p, Y + p, B + p, n, bpp, local);
+        }
+        task_stats[t].merge(local);
+      }
+    }));
+  }
+  for (auto &f : done) {
+    f.get();
+  }
+  xyb_stats stats;
+  for (const auto &s : task_stats) {
+    stats.merge(s);
+  }
+  if (range != nullptr) {
+    *range = stats;
+  }
+  return EXIT_SUCCESS;
+}
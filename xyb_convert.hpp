@@ -0,0 +1,83 @@
+#pragma once
+
+#include "cbrt_policy.hpp"
+#include "image_io.hpp"
+#include "simd_dispatch.hpp"
+#include "thread_pool.hpp"
+
+// XYB planes hold signed int32 samples (written as 32-bit PGX)
+constexpr uint8_t xyb_bpp = 32;
+
+// conversion kernels of one cube-root policy, for each plane sample type
+struct xyb_kernels {
+  rgb2xyb_fn s32;
+  rgb2xyb_u8_fn u8;
+  rgb2xyb_u16_fn u16;
+};
+
+// XYB engine of a conversion: the fixed-point pipeline with the cube root cbrt, or the 3D LUT of
+// xyb_lut3d.hpp with lut3d_grid (17 or 33) nodes per axis when lut3d_grid is not 0; without stats, the
+// kernels may leave the range of the mixing values empty (the 3D LUT then skips its matrix stage)
+struct xyb_method {
+  cbrt_method cbrt;
+  i32 lut3d_grid;
+  bool stats = true;
+  xyb_method(cbrt_method cbrt = cbrt_method::LUT256, i32 lut3d_grid = 0)
+      : cbrt(cbrt), lut3d_grid(lut3d_grid) {}
+};
+
+/**
+ * @brief Conversion kernels of method for bpp-bit RGB
+ *
+ * LUT256 and POLY select the kernels of the active SIMD level, the other policies the scalar kernel. The 3D
+ * LUT covers 8 - 10 bpp; other depths fall back to the pipeline with method.cbrt.
+ */
+xyb_kernels get_xyb_kernels(const xyb_method &method, i32 bpp);
+
+/**
+ * @brief Convert rows [y0, y1) of rgb_in into xyb_out with the kernel of get_xyb_kernels(method)
+ *
+ * Planes of either image may be halved horizontally and/or vertically (4:2:2, 4:2:0; see
+ * image::get_subsampling()). Halved input planes are upsampled on the fly by repeating samples (see
+ * resample_kernels.hpp), halved output planes receive the 2 x 1 or 2 x 2 block means of the converted
+ * rows; y0 shall then be even, as shall y1 unless it is the height.
+ *
+ * @param stats merged with the range of the mixing values in these rows (if method.stats)
+ */
+void rgb2xyb_rows(image &rgb_in, image &xyb_out, ui32 y0, ui32 y1, xyb_stats &stats,
+                  const xyb_method &method = xyb_method());
+
+/**
+ * @brief Convert rgb_in into xyb_out
+ *
+ * @param range if not null, receives the range of the mixing values of the image
+ */
+void rgb2xyb(image &rgb_in, image &xyb_out, xyb_stats *range = nullptr,
+             const xyb_method &method = xyb_method());
+
+/**
+ * @brief Convert rgb_in into xyb_out with horizontal strips processed concurrently on pool
+ *
+ * @param range if not null, receives the range of the mixing values of the image
+ */
+void rgb2xyb_parallel(image &rgb_in, image &xyb_out, thread_pool &pool, xyb_stats *range = nullptr,
+                      const xyb_method &method = xyb_method());
+
+/**
+ * @brief Decode a PPM (P6, or P3) file straight into XYB planes
+ *
+ * The interleaved raster is deinterleaved in blocks of ppm2xyb_block_pixels pixels into a per-task
+ * scratch buffer of 8- or 16-bit samples that stays in cache, so that no full-size RGB planes are
+ * allocated, written or read back. Blocks are distributed over pool. A plain (P3) raster is first parsed
+ * into a binary one on the calling thread.
+ *
+ * @param xyb_out receives a 3-component image of the size of the input
+ * @param range if not null, receives the range of the mixing values of the image
+ * @return EXIT_SUCCESS or EXIT_FAILURE
+ */
+int ppm2xyb(const std::string &filename, std::unique_ptr<image> &xyb_out, thread_pool &pool,
+            io_mode mode = io_mode::MMAP, xyb_stats *range = nullptr,
+            const xyb_method &method = xyb_method());
+
+// 3 x 8192 x 16-bit = 48 KiB of scratch per task at most
+constexpr size_t ppm2xyb_block_pixels = 8192;
@@ -0,0 +1,60 @@
+#include <cmath>
+#include <memory>
+#include <mutex>
+
+#include "xyb_lut3d.hpp"
+
+xyb_lut3d::xyb_lut3d(i32 grid, i32 bpp) : grid(grid), bpp(bpp) {
+  const i32 maxval = (1 << bpp) - 1;
+  // input level of the nodes along an axis
+  std::vector<i32> level(grid);
+  for (i32 k = 0; k < grid; ++k) {
+    const double t = static_cast<double>(k) / (grid - 1);
+    level[k]       = static_cast<i32>(std::lround(maxval * t * t));
+    if (k > 0 && level[k] <= level[k - 1]) {
+      level[k] = level[k - 1] + 1;
+    }
+  }
+  const i32 stride[3] = {1, grid, grid * grid};
+  for (i32 c = 0; c < 3; ++c) {
+    axis[c].resize(maxval + 1);
+    i32 k = 0;
+    for (i32 v = 0; v <= maxval; ++v) {
+      while (k < grid - 2 && level[k + 1] <= v) {
+        ++k;
+      }
+      const i32 span = level[k + 1] - level[k];
+      const i32 frac = ((v - level[k]) * (1 << lut3d_frac_bits) + span / 2) / span;
+      axis[c][v]     = static_cast<ui32>(k * stride[c]) | (static_cast<ui32>(frac) << 16);
+    }
+  }
+
+  // evaluate the pipeline at every node
+  const size_t num_nodes = static_cast<size_t>(grid) * grid * grid;
+  std::vector<i32> rgb(3 * num_nodes), xyb(3 * num_nodes);
+  for (size_t n = 0; n < num_nodes; ++n) {
+    rgb[n]                 = level[n % grid];
+    rgb[num_nodes + n]     = level[(n / grid) % grid];
+    rgb[2 * num_nodes + n] = level[n / grid / grid];
+  }
+  xyb_stats stats;
+  const i32 *R = rgb.data(), *G = R + num_nodes, *B = G + num_nodes;
+  rgb2xyb_scalar<cbrt_exact, i32>(R, G, B, xyb.data(), xyb.data() + num_nodes, xyb.data() + 2 * num_nodes,
+                                  num_nodes, bpp, stats);
+  nodes.assign(4 * num_nodes, 0);
+  for (size_t n = 0; n < num_nodes; ++n) {
+    nodes[4 * n]     = xyb[n];
+    nodes[4 * n + 1] = xyb[num_nodes + n];
+    nodes[4 * n + 2] = xyb[2 * num_nodes + n];
+  }
+}
+
+const xyb_lut3d &get_xyb_lut3d(i32 grid, i32 bpp) {
+  // one lattice per grid (17, 33) and bit depth (8 - 10)
+  static std::once_flag built[2][3];
+  static std::unique_ptr<xyb_lut3d> luts[2][3];
+  const i32 g = (grid == 33) ? 1 : 0;
+  const i32 d = bpp - 8;
+  std::call_once(built[g][d], [=] { luts[g][d] = std::make_unique<xyb_lut3d>(grid, bpp); });
+  return *luts[g][d];
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <vector>
+
+#include "RGB2XYB.hpp"
+
+/********************************************************************************
+ * 3D LUT engine of the XYB transform for 8 - 10 bpp RGB
+ * the nodes of a grid^3 lattice hold X, Y and B of the fixed-point pipeline
+ * (rgb2xyb_scalar() with cbrt_exact); node k of each axis sits at the input level
+ * round(maxval (k / (grid - 1))^2), made strictly increasing, so that the nodes
+ * are dense near black where the cube root bends most (a uniform lattice is off
+ * by up to 3400 there). A pixel is interpolated from the 4 vertices of the
+ * tetrahedron of its cell that contains it, with Q14 weights; the mixing
+ * statistics come from the matrix stage and stay exact; the kernels skip that
+ * stage when no statistics are requested.
+ * Largest difference from rgb2xyb_scalar<cbrt_exact> in Q16 (X, Y, B), over
+ * every RGB input (see lut3d_error_bound()):
+ *   grid 17:  8 bpp 18, 339, 339   9 bpp 19, 350, 350   10 bpp 20, 355, 355
+ *   grid 33:  8 bpp  6,  68,  68   9 bpp  8, 118, 118   10 bpp  9,  92,  92
+ *******************************************************************************/
+constexpr i32 lut3d_frac_bits = 14;
+
+struct xyb_lut3d {
+  i32 grid;
+  i32 bpp;
+  // per input level of R, G and B: offset of its cell (node index along the axis times the stride of the
+  // axis) in the lower 16 bits, position in the cell (Q14) in the upper 16 bits
+  std::vector<ui32> axis[3];
+  // X, Y, B and a pad per node; node (r, g, b) is at r + grid * (g + grid * b)
+  std::vector<i32> nodes;
+
+  xyb_lut3d(i32 grid, i32 bpp);
+  static bool supports(i32 grid, i32 bpp) { return (grid == 17 || grid == 33) && bpp >= 8 && bpp <= 10; }
+};
+
+/**
+ * @brief Lattice of grid^3 nodes for bpp-bit RGB, built on first use and shared by every thread
+ *
+ * @param grid 17 or 33, bpp 8 - 10 (see xyb_lut3d::supports())
+ */
+const xyb_lut3d &get_xyb_lut3d(i32 grid, i32 bpp);
+
+/**
+ * @brief Documented largest difference of the engine from rgb2xyb_scalar<cbrt_exact> (see above)
+ *
+ * @param c component: 0 = X, 1 = Y, 2 = B
+ */
+inline i32 lut3d_error_bound(i32 grid, i32 bpp, i32 c) {
+  static const i32 bound[2][3][3] = {{{18, 339, 339}, {19, 350, 350}, {20, 355, 355}},
+                                     {{6, 68, 68}, {8, 118, 118}, {9, 92, 92}}};
+  return bound[(grid == 33) ? 1 : 0][bpp - 8][c];
+}
+
+/**
+ * @brief Convert len pixels of RGB planes into XYB planes with the lattice lut (scalar kernel)
+ *
+ * Samples above the largest level of lut.bpp are clamped to it for the lookup.
+ *
+ * @tparam T sample type of the RGB planes (ui8, ui16 or i32)
+ * @param stats if not null, receives the range of the mixing values of these pixels (computed by the
+ * matrix stage, which is skipped otherwise)
+ */
+template <class T>
+static void rgb2xyb_lut3d_scalar(const xyb_lut3d &lut, const T *buf_red, const T *buf_grn, const T *buf_blu,
+                                 i32 *buf_X, i32 *buf_Y, i32 *buf_B, size_t len, xyb_stats *stats) {
+  const ui32 *axis_r = lut.axis[0].data();
+  const ui32 *axis_g = lut.axis[1].data();
+  const ui32 *axis_b = lut.axis[2].data();
+  const i32 *node    = lut.nodes.data();
+  const ui32 maxval  = (1U << lut.bpp) - 1;
+  const i32 sr       = 1;
+  const i32 sg       = lut.grid;
+  const i32 sb       = lut.grid * lut.grid;
+  const i32 diag     = sr + sg + sb;
+  const i32 one      = 1 << lut3d_frac_bits;
+  const i32 half     = 1 << (lut3d_frac_bits - 1);
+
+  i32 Lmix, Mmix, Smix;
+  i32 Lmax = INT32_MIN, Lmin = INT32_MAX, Mmax = INT32_MIN, Mmin = INT32_MAX, Smax = INT32_MIN,
+      Smin = INT32_MAX;
+  for (size_t idx = 0; idx < len; ++idx) {
+    const ui32 r = std::min(static_cast<ui32>(buf_red[idx]), maxval);
+    const ui32 g = std::min(static_cast<ui32>(buf_grn[idx]), maxval);
+    const ui32 b = std::min(static_cast<ui32>(buf_blu[idx]), maxval);
+
+    if (stats != nullptr) {
+      rgb2mix(scale_pixel_value(buf_red[idx], lut.bpp), scale_pixel_value(buf_grn[idx], lut.bpp),
+              scale_pixel_value(buf_blu[idx], lut.bpp), Lmix, Mmix, Smix);
+      Lmax = Lmax < Lmix ? Lmix : Lmax;
+      Lmin = Lmin > Lmix ? Lmix : Lmin;
+      Mmax = Mmax < Mmix ? Mmix : Mmax;
+      Mmin = Mmin > Mmix ? Mmix : Mmin;
+      Smax = Smax < Smix ? Smix : Smax;
+      Smin = Smin > Smix ? Smix : Smin;
+    }
+
+    const i32 base = static_cast<i32>((axis_r[r] & 0xFFFF) + (axis_g[g] & 0xFFFF) + (axis_b[b] & 0xFFFF));
+    const i32 fr   = static_cast<i32>(axis_r[r] >> 16);
+    const i32 fg   = static_cast<i32>(axis_g[g] >> 16);
+    const i32 fb   = static_cast<i32>(axis_b[b] >> 16);
+    // the tetrahedron runs from the base node along the axis of the largest position, then to the node
+    // opposite to the axis of the smallest one, then to the far corner; ties go to r, then g
+    // (selected arithmetically: branches on the order of the positions are mispredicted half the time)
+    const i32 rg   = fr >= fg;
+    const i32 gb   = fg >= fb;
+    const i32 rb   = fr >= fb;
+    const i32 xmax = rg & rb, ymax = (1 - rg) & gb;
+    const i32 xmin = rb & gb, ymin = rg & (1 - gb);
+    const i32 smax = xmax * sr + ymax * sg + (1 - xmax - ymax) * sb;
+    const i32 smin = xmin * sb + ymin * sg + (1 - xmin - ymin) * sr;
+    const i32 fmax = std::max(fr, std::max(fg, fb));
+    const i32 fmin = std::min(fr, std::min(fg, fb));
+    const i32 fmid = fr + fg + fb - fmax - fmin;
+    const i32 w0 = one - fmax, w1 = fmax - fmid, w2 = fmid - fmin, w3 = fmin;
+    const i32 *c0 = node + 4 * base;
+    const i32 *c1 = node + 4 * (base + smax);
+    const i32 *c2 = node + 4 * (base + diag - smin);
+    const i32 *c3 = node + 4 * (base + diag);
+
+    buf_X[idx] = (w0 * c0[0] + w1 * c1[0] + w2 * c2[0] + w3 * c3[0] + half) >> lut3d_frac_bits;
+    buf_Y[idx] = (w0 * c0[1] + w1 * c1[1] + w2 * c2[1] + w3 * c3[1] + half) >> lut3d_frac_bits;
+    buf_B[idx] = (w0 * c0[2] + w1 * c1[2] + w2 * c2[2] + w3 * c3[2] + half) >> lut3d_frac_bits;
+  }
+  if (stats != nullptr) {
+    stats->Lmax = Lmax;
+    stats->Lmin = Lmin;
+    stats->Mmax = Mmax;
+    stats->Mmin = Mmin;
+    stats->Smax = Smax;
+    stats->Smin = Smin;
+  }
+}